@@ -0,0 +1,531 @@
+// 端到端基准：进程内启动 bridge，合成 cyber writer 发布，本地无界面 WebSocket 客户端订阅并解码
+// 用法: fox_bridge_bench [--topics N] [--size 1K|10M] [--hz R] [--duration S] [--warmup S]
+//                        [--port P] [--config file] [--json file]
+// 消息为 google.protobuf.BytesValue，value 前 8 字节为发布时刻（steady_clock ns），
+// 客户端收到后计算发布 -> 客户端解码的延迟
+#include <arpa/inet.h>
+#include <google/protobuf/wrappers.pb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cyber/cyber.h>
+#include <ctime>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BridgeConfig.hpp"
+#include "CyberBridge.hpp"
+#include "FoxgloveServer.hpp"
+#include "LatencyRecorder.hpp"
+
+using namespace apollo;
+using google::protobuf::BytesValue;
+using Json = nlohmann::json;
+
+namespace {
+
+struct BenchOptions {
+  size_t topics = 8;
+  size_t size = 1024;
+  double hz = 100;
+  uint32_t duration_s = 10;
+  uint32_t warmup_s = 2;
+  uint16_t port = 18765;
+  std::string config;
+  std::string json;
+};
+
+// 支持 K / M 后缀，如 1K、10M
+size_t parseSize(const std::string& value) {
+  char* end = nullptr;
+  double size = std::strtod(value.c_str(), &end);
+  if (end && (*end == 'K' || *end == 'k')) {
+    size *= 1024;
+  } else if (end && (*end == 'M' || *end == 'm')) {
+    size *= 1024 * 1024;
+  }
+  return static_cast<size_t>(size);
+}
+
+bool parseOptions(int argc, char** argv, BenchOptions& options) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::fprintf(stderr, "missing value for %s\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--topics") {
+      options.topics = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--size") {
+      options.size = parseSize(value);
+    } else if (arg == "--hz") {
+      options.hz = std::strtod(value.c_str(), nullptr);
+    } else if (arg == "--duration") {
+      options.duration_s = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--warmup") {
+      options.warmup_s = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--port") {
+      options.port = static_cast<uint16_t>(std::strtoul(value.c_str(), nullptr, 10));
+    } else if (arg == "--config") {
+      options.config = value;
+    } else if (arg == "--json") {
+      options.json = value;
+    } else {
+      std::fprintf(stderr, "unknown option: %s\n", arg.c_str());
+      return false;
+    }
+  }
+  if (options.topics == 0 || options.hz <= 0 || options.duration_s == 0) {
+    std::fprintf(stderr, "topics, hz and duration must be positive\n");
+    return false;
+  }
+  options.size = std::max<size_t>(options.size, sizeof(uint64_t));
+  return true;
+}
+
+uint64_t steadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+uint64_t cpuNs(clockid_t clock) {
+  timespec ts{};
+  clock_gettime(clock, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+uint64_t threadCpuNs(std::thread& thread) {
+  clockid_t clock;
+  if (pthread_getcpuclockid(thread.native_handle(), &clock) != 0) {
+    return 0;
+  }
+  return cpuNs(clock);
+}
+
+// 最小的 foxglove.websocket.v1 客户端，只处理 advertise / subscribe 与 MessageData
+class WsClient {
+public:
+  enum Opcode : uint8_t { Continuation = 0x0, Text = 0x1, Binary = 0x2, Close = 0x8, Ping = 0x9,
+    Pong = 0xA };
+
+  ~WsClient() {
+    close();
+  }
+
+  bool connect(const std::string& host, uint16_t port) {
+    _fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) {
+      return false;
+    }
+    int one = 1;
+    ::setsockopt(_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    int rcvbuf = 8 * 1024 * 1024;
+    ::setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, host.c_str(), &addr.sin_addr);
+    if (::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+      return false;
+    }
+    std::string request = "GET / HTTP/1.1\r\nHost: " + host + ":" + std::to_string(port) +
+                          "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                          "Sec-WebSocket-Version: 13\r\n"
+                          "Sec-WebSocket-Protocol: foxglove.websocket.v1\r\n\r\n";
+    if (!sendAll(request.data(), request.size())) {
+      return false;
+    }
+    size_t header_end = std::string::npos;
+    while ((header_end = _buffer.find("\r\n\r\n")) == std::string::npos) {
+      if (!fill()) {
+        return false;
+      }
+    }
+    if (_buffer.compare(0, 12, "HTTP/1.1 101") != 0) {
+      std::fprintf(stderr, "websocket upgrade failed: %s\n", _buffer.substr(0, header_end).c_str());
+      return false;
+    }
+    _pos = header_end + 4;
+    return true;
+  }
+
+  // 唤醒阻塞在 read() 的线程，fd 在析构时关闭
+  void shutdown() {
+    if (_fd >= 0) {
+      ::shutdown(_fd, SHUT_RDWR);
+    }
+  }
+
+  void close() {
+    if (_fd >= 0) {
+      ::close(_fd);
+      _fd = -1;
+    }
+  }
+
+  // 客户端发出的帧必须带掩码
+  bool send(Opcode opcode, const std::string& payload) {
+    std::string frame;
+    frame.push_back(static_cast<char>(0x80 | opcode));
+    if (payload.size() < 126) {
+      frame.push_back(static_cast<char>(0x80 | payload.size()));
+    } else if (payload.size() <= 0xFFFF) {
+      frame.push_back(static_cast<char>(0x80 | 126));
+      frame.push_back(static_cast<char>(payload.size() >> 8));
+      frame.push_back(static_cast<char>(payload.size() & 0xFF));
+    } else {
+      frame.push_back(static_cast<char>(0x80 | 127));
+      for (int shift = 56; shift >= 0; shift -= 8) {
+        frame.push_back(static_cast<char>((static_cast<uint64_t>(payload.size()) >> shift) & 0xFF));
+      }
+    }
+    uint8_t mask[4];
+    uint32_t seed = _rng();
+    std::memcpy(mask, &seed, sizeof(mask));
+    frame.append(reinterpret_cast<const char*>(mask), sizeof(mask));
+    for (size_t i = 0; i < payload.size(); ++i) {
+      frame.push_back(static_cast<char>(payload[i] ^ mask[i % 4]));
+    }
+    return sendAll(frame.data(), frame.size());
+  }
+
+  // 读取一条完整消息（合并分片），返回 opcode；连接断开返回 Close
+  Opcode read(std::string& payload) {
+    payload.clear();
+    Opcode message_opcode = Continuation;
+    while (true) {
+      if (!ensure(2)) {
+        return Close;
+      }
+      uint8_t b0 = static_cast<uint8_t>(_buffer[_pos]);
+      uint8_t b1 = static_cast<uint8_t>(_buffer[_pos + 1]);
+      bool fin = b0 & 0x80;
+      auto opcode = static_cast<Opcode>(b0 & 0x0F);
+      size_t header = 2;
+      uint64_t length = b1 & 0x7F;
+      if (length == 126) {
+        header += 2;
+      } else if (length == 127) {
+        header += 8;
+      }
+      if (b1 & 0x80) {
+        header += 4;
+      }
+      if (!ensure(header)) {
+        return Close;
+      }
+      const auto* bytes = reinterpret_cast<const uint8_t*>(_buffer.data() + _pos);
+      if ((b1 & 0x7F) == 126) {
+        length = (uint64_t(bytes[2]) << 8) | bytes[3];
+      } else if ((b1 & 0x7F) == 127) {
+        length = 0;
+        for (int i = 0; i < 8; ++i) {
+          length = (length << 8) | bytes[2 + i];
+        }
+      }
+      if (!ensure(header + length)) {
+        return Close;
+      }
+      payload.append(_buffer, _pos + header, length);
+      _pos += header + length;
+      if (opcode == Ping) {
+        std::string ping = payload;
+        payload.clear();
+        send(Pong, ping);
+        continue;
+      }
+      if (opcode != Continuation) {
+        message_opcode = opcode;
+      }
+      if (fin) {
+        return message_opcode;
+      }
+    }
+  }
+
+private:
+  bool sendAll(const char* data, size_t size) {
+    while (size > 0) {
+      ssize_t n = ::send(_fd, data, size, MSG_NOSIGNAL);
+      if (n <= 0) {
+        return false;
+      }
+      data += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  bool fill() {
+    char chunk[256 * 1024];
+    ssize_t n = ::recv(_fd, chunk, sizeof(chunk), 0);
+    if (n <= 0) {
+      return false;
+    }
+    _buffer.append(chunk, n);
+    return true;
+  }
+
+  bool ensure(size_t size) {
+    if (_pos > 0 && _buffer.size() - _pos < size) {
+      _buffer.erase(0, _pos);
+      _pos = 0;
+    }
+    while (_buffer.size() - _pos < size) {
+      if (!fill()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  int _fd = -1;
+  std::string _buffer;
+  size_t _pos = 0;
+  std::minstd_rand _rng{std::random_device{}()};
+};
+
+// 解出 BytesValue.value 前 8 字节的发布时刻，payload 为 MessageData 帧去掉头部后的数据
+bool decodeSendNs(const uint8_t* data, size_t size, uint64_t& send_ns) {
+  if (size < 2 || data[0] != 0x0A) {  // field 1, length-delimited
+    return false;
+  }
+  uint64_t length = 0;
+  size_t pos = 1;
+  for (int shift = 0; pos < size && shift < 64; shift += 7) {
+    uint8_t b = data[pos++];
+    length |= uint64_t(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      break;
+    }
+  }
+  if (length < sizeof(send_ns) || pos + sizeof(send_ns) > size) {
+    return false;
+  }
+  std::memcpy(&send_ns, data + pos, sizeof(send_ns));
+  return true;
+}
+
+struct ClientStats {
+  std::atomic<bool> measuring{false};
+  std::atomic<size_t> subscribed{0};
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> decode_errors{0};
+  LatencyRecorder latency;
+};
+
+void runClient(WsClient& client, const std::string& prefix, ClientStats& stats) {
+  constexpr uint8_t kMessageData = 0x01;
+  constexpr size_t kMessageHeader = 1 + 4 + 8;  // opcode + subscription id + log time
+  uint32_t next_subscription = 1;
+  std::string payload;
+  while (true) {
+    auto opcode = client.read(payload);
+    if (opcode == WsClient::Close) {
+      return;
+    }
+    if (opcode == WsClient::Text) {
+      auto message = Json::parse(payload, nullptr, false);
+      if (message.is_discarded() || message.value("op", "") != "advertise") {
+        continue;
+      }
+      Json subscriptions = Json::array();
+      for (const auto& channel : message["channels"]) {
+        const std::string topic = channel.value("topic", "");
+        if (topic.rfind(prefix, 0) != 0 || topic.find("/converted") != std::string::npos) {
+          continue;
+        }
+        subscriptions.push_back({{"id", next_subscription++}, {"channelId", channel["id"]}});
+      }
+      if (!subscriptions.empty()) {
+        Json subscribe = {{"op", "subscribe"}, {"subscriptions", subscriptions}};
+        client.send(WsClient::Text, subscribe.dump());
+        stats.subscribed += subscriptions.size();
+      }
+      continue;
+    }
+    if (opcode != WsClient::Binary || payload.size() < kMessageHeader ||
+        static_cast<uint8_t>(payload[0]) != kMessageData) {
+      continue;
+    }
+    uint64_t now = steadyNs();
+    if (!stats.measuring.load(std::memory_order_relaxed)) {
+      continue;
+    }
+    uint64_t send_ns = 0;
+    const auto* data = reinterpret_cast<const uint8_t*>(payload.data()) + kMessageHeader;
+    if (!decodeSendNs(data, payload.size() - kMessageHeader, send_ns) || send_ns > now) {
+      stats.decode_errors.fetch_add(1, std::memory_order_relaxed);
+      continue;
+    }
+    stats.latency.record((now - send_ns) / 1000);
+    stats.messages.fetch_add(1, std::memory_order_relaxed);
+    stats.bytes.fetch_add(payload.size(), std::memory_order_relaxed);
+  }
+}
+
+// 单线程按各 topic 的周期发布，每条消息新建，避免与 bridge 侧共享同一块内存
+void runWriters(const std::vector<std::shared_ptr<cyber::Writer<BytesValue>>>& writers,
+  const BenchOptions& options, const std::atomic<bool>& running, std::atomic<uint64_t>& sent) {
+  const uint64_t period = static_cast<uint64_t>(1e9 / options.hz);
+  const std::string value(options.size, 'x');
+  std::vector<uint64_t> next(writers.size());
+  uint64_t start = steadyNs();
+  for (size_t i = 0; i < next.size(); ++i) {
+    next[i] = start + period * i / next.size();  // 错开各 topic 的相位
+  }
+  while (running.load(std::memory_order_relaxed)) {
+    uint64_t now = steadyNs();
+    uint64_t wake = now + period;
+    for (size_t i = 0; i < writers.size(); ++i) {
+      if (next[i] <= now) {
+        auto msg = std::make_shared<BytesValue>();
+        msg->set_value(value);
+        uint64_t send_ns = steadyNs();
+        std::memcpy(&(*msg->mutable_value())[0], &send_ns, sizeof(send_ns));
+        writers[i]->Write(msg);
+        sent.fetch_add(1, std::memory_order_relaxed);
+        // 发布跟不上时不补发积压的周期
+        next[i] = std::max(next[i] + period, now);
+      }
+      wake = std::min(wake, next[i]);
+    }
+    now = steadyNs();
+    if (wake > now) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(wake - now));
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchOptions options;
+  if (!parseOptions(argc, argv, options)) {
+    return 1;
+  }
+  if (!options.config.empty() && !BridgeConfig::instance().load(options.config)) {
+    return 1;
+  }
+  SetLogLevel(LogLevel::WARN);
+  cyber::Init("fox_bridge_bench");
+
+  auto server = std::make_shared<FoxgloveServer>();
+  if (!server->getBridge()->start() || !server->start("127.0.0.1", options.port)) {
+    std::fprintf(stderr, "failed to start bridge\n");
+    return 1;
+  }
+
+  const std::string prefix = "/bench/topic_";
+  auto node = cyber::CreateNode("fox_bridge_bench_writer");
+  std::vector<std::shared_ptr<cyber::Writer<BytesValue>>> writers;
+  for (size_t i = 0; i < options.topics; ++i) {
+    writers.push_back(node->CreateWriter<BytesValue>(prefix + std::to_string(i)));
+  }
+
+  WsClient client;
+  if (!client.connect("127.0.0.1", options.port)) {
+    std::fprintf(stderr, "failed to connect to 127.0.0.1:%u\n", options.port);
+    return 1;
+  }
+  ClientStats stats;
+  std::thread client_thread([&]() {
+    runClient(client, prefix, stats);
+  });
+
+  std::atomic<bool> running{true};
+  std::atomic<uint64_t> sent{0};
+  std::thread writer_thread([&]() {
+    runWriters(writers, options, running, sent);
+  });
+
+  // 等待全部 topic 被发现并订阅
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (stats.subscribed.load() < options.topics && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (stats.subscribed.load() < options.topics) {
+    std::fprintf(stderr, "only %zu of %zu topics subscribed\n", stats.subscribed.load(),
+      options.topics);
+  }
+  std::this_thread::sleep_for(std::chrono::seconds(options.warmup_s));
+
+  // 测量窗口：bridge CPU = 进程 CPU - writer 与客户端线程 CPU
+  stats.latency.collect();
+  stats.measuring = true;
+  uint64_t sent_begin = sent.load();
+  uint64_t process_begin = cpuNs(CLOCK_PROCESS_CPUTIME_ID);
+  uint64_t bench_begin = threadCpuNs(client_thread) + threadCpuNs(writer_thread);
+  uint64_t wall_begin = steadyNs();
+  std::this_thread::sleep_for(std::chrono::seconds(options.duration_s));
+  stats.measuring = false;
+  uint64_t wall_ns = steadyNs() - wall_begin;
+  uint64_t bench_ns = threadCpuNs(client_thread) + threadCpuNs(writer_thread) - bench_begin;
+  uint64_t process_ns = cpuNs(CLOCK_PROCESS_CPUTIME_ID) - process_begin;
+  uint64_t sent_count = sent.load() - sent_begin;
+
+  running = false;
+  writer_thread.join();
+  client.shutdown();
+  client_thread.join();
+  server->stop();
+  cyber::Clear();
+
+  auto latency = stats.latency.collect();
+  double seconds = wall_ns / 1e9;
+  double cpu_cores = process_ns > bench_ns ? (process_ns - bench_ns) / double(wall_ns) : 0;
+  unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t received = stats.messages.load();
+  Json result = {
+    {"topics", options.topics},
+    {"size", options.size},
+    {"hz", options.hz},
+    {"duration_s", seconds},
+    {"sent", sent_count},
+    {"received", received},
+    {"decode_errors", stats.decode_errors.load()},
+    {"msgs_per_s", received / seconds},
+    {"mb_per_s", stats.bytes.load() / seconds / (1024 * 1024)},
+    {"latency_us",
+      {{"avg", latency.average()}, {"p50", latency.percentile(0.5)},
+        {"p99", latency.percentile(0.99)}, {"p999", latency.percentile(0.999)},
+        {"max", latency.max}}},
+    {"bridge_cpu_cores", cpu_cores},
+    {"bridge_cpu_per_core", cpu_cores / cores},
+    {"cores", cores},
+  };
+
+  std::printf("topics: %zu size: %zu B rate: %.1f Hz duration: %.1f s\n", options.topics,
+    options.size, options.hz, seconds);
+  std::printf("sent: %lu received: %lu (%.1f msgs/s, %.2f MB/s)\n",
+    static_cast<unsigned long>(sent_count), static_cast<unsigned long>(received),
+    received / seconds, stats.bytes.load() / seconds / (1024 * 1024));
+  std::printf("latency us: p50 %lu p99 %lu p999 %lu max %lu\n",
+    static_cast<unsigned long>(latency.percentile(0.5)),
+    static_cast<unsigned long>(latency.percentile(0.99)),
+    static_cast<unsigned long>(latency.percentile(0.999)), static_cast<unsigned long>(latency.max));
+  std::printf("bridge cpu: %.2f cores (%.1f%% of %u cores)\n", cpu_cores,
+    cpu_cores * 100 / cores, cores);
+  if (options.json == "-") {
+    std::printf("%s\n", result.dump().c_str());
+  } else if (!options.json.empty()) {
+    std::ofstream(options.json) << result.dump(2) << "\n";
+  }
+  return 0;
+}
@@ -0,0 +1,92 @@
+// 点云降采样吞吐：PointCloudReducer 的向量化路径 vs 逐点路径
+// 用法: cloud_bench [points] [frames] [options]
+//   options 为 CloudOptions 文本格式，缺省时依次测试几组典型配置
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "PointCloudReducer.hpp"
+
+namespace {
+
+// 模拟 128 线激光雷达的一帧：近处密、远处稀，少量无效点
+struct Frame {
+  std::vector<float> x, y, z, intensity;
+
+  explicit Frame(size_t points) {
+    std::mt19937 rng(42);
+    std::exponential_distribution<float> range(1.0f / 20.0f);
+    const float pi = static_cast<float>(M_PI);
+    std::uniform_real_distribution<float> angle(-pi, pi);
+    std::uniform_real_distribution<float> pitch(-0.4f, 0.2f);
+    std::uniform_real_distribution<float> value(0, 255);
+    for (size_t i = 0; i < points; ++i) {
+      float r = 1.0f + range(rng);
+      float yaw = angle(rng);
+      float elevation = pitch(rng);
+      bool invalid = i % 97 == 0;
+      x.push_back(invalid ? NAN : r * std::cos(elevation) * std::cos(yaw));
+      y.push_back(r * std::cos(elevation) * std::sin(yaw));
+      z.push_back(r * std::sin(elevation));
+      intensity.push_back(value(rng));
+    }
+  }
+
+  CloudView view() const {
+    return {x.data(), y.data(), z.data(), intensity.data(), x.size()};
+  }
+};
+
+// 返回每帧平均耗时（us）
+double measure(const Frame& frame, const CloudOptions& options, PointCloudReducer::Path path,
+  size_t frames, size_t& output_points) {
+  std::vector<std::byte> output;
+  PointCloudReducer::reduce(frame.view(), options, output, path);  // 预热
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < frames; ++i) {
+    output_points = PointCloudReducer::reduce(frame.view(), options, output, path);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  return std::chrono::duration<double, std::micro>(elapsed).count() / frames;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t points = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 300000;
+  size_t frames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 50;
+  std::vector<std::string> specs = {"voxel=0,intensity=0", "range=2:60", "voxel=0.2",
+    "voxel=0.1,range=1:80,roi=-60:60:-30:30:-2:4"};
+  if (argc > 3) {
+    specs = {argv[3]};
+  }
+
+  Frame frame(points);
+  std::printf("points: %zu frames: %zu\n", points, frames);
+  std::printf("%-56s %10s %10s %10s %8s %10s\n", "options", "scalar_us", "vector_us", "speedup",
+    "Mpts/s", "out_pts");
+  for (const auto& spec : specs) {
+    CloudOptions options;
+    if (!CloudOptions::parse(spec, options)) {
+      std::fprintf(stderr, "invalid options: %s\n", spec.c_str());
+      return 1;
+    }
+    size_t scalar_points = 0;
+    size_t vector_points = 0;
+    double scalar_us =
+      measure(frame, options, PointCloudReducer::Path::Scalar, frames, scalar_points);
+    double vector_us =
+      measure(frame, options, PointCloudReducer::Path::Vector, frames, vector_points);
+    if (scalar_points != vector_points) {
+      std::fprintf(stderr, "output mismatch: %zu vs %zu\n", scalar_points, vector_points);
+      return 1;
+    }
+    std::printf("%-56s %10.1f %10.1f %9.2fx %8.1f %10zu\n", options.toString().c_str(),
+      scalar_us, vector_us, scalar_us / vector_us, points / vector_us, vector_points);
+  }
+  return 0;
+}
@@ -0,0 +1,194 @@
+// 单条消息转发开销：旧的按 topic 查表路径 vs 订阅时解析好的 ForwardHandle
+// 用法: forward_bench [topics] [messages] [--sink]
+//   --sink 挂一个丢弃数据的 MCAP writer，使 raw 与 /converted 通道都实际 log
+// 计时前先检查 Latest 积压策略：客户端恢复后只补发积压期间最新的一条，检查失败返回 1
+#include <google/protobuf/duration.pb.h>
+#include <google/protobuf/timestamp.pb.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <foxglove/context.hpp>
+#include <foxglove/mcap.hpp>
+#include <map>
+#include <vector>
+
+#include "ForwardHandle.hpp"
+
+using google::protobuf::Duration;
+using google::protobuf::Timestamp;
+
+static void convertStamp(const Timestamp& stamp, std::string& out) {
+  Duration duration;
+  duration.set_seconds(stamp.seconds());
+  duration.set_nanos(stamp.nanos());
+  duration.SerializeToString(&out);
+}
+
+REGISTER_MESSAGE_CONVERTER(Timestamp, Duration, convertStamp)
+
+namespace {
+
+// 旧实现：FoxgloveServer::_channels 为 std::map，每条消息按 topic 查找两次并拼接 /converted
+struct LegacyChannel {
+  std::string type;
+  std::shared_ptr<foxglove::RawChannel> channel;
+};
+
+bool legacySend(std::map<std::string, LegacyChannel>& channels, const std::string& topic,
+  const std::string& message, const google::protobuf::Message* parsed) {
+  if (channels.find(topic) == channels.end()) {
+    return false;
+  }
+  auto& channel = channels[topic];
+  if (channel.channel->has_sinks()) {
+    channel.channel->log(reinterpret_cast<const std::byte*>(message.c_str()), message.length());
+  }
+  if (MessageConverter::instance().hasConverter(channel.type)) {
+    auto& repeat = channels[topic + "/converted"];
+    if (!repeat.channel || !repeat.channel->has_sinks()) {
+      return true;
+    }
+    std::string& output = ProtoArena::local().convertedBuffer();
+    if (!MessageConverter::instance().convert(message, parsed, channel.type, output)) {
+      return false;
+    }
+    repeat.channel->log(reinterpret_cast<const std::byte*>(output.c_str()), output.length());
+  }
+  return true;
+}
+
+std::shared_ptr<foxglove::RawChannel> makeChannel(
+  const std::string& topic, const foxglove::Context& context) {
+  auto result = foxglove::RawChannel::create(topic, "protobuf", std::nullopt, context);
+  if (!result.has_value()) {
+    std::fprintf(stderr, "create channel failed: %s\n", foxglove::strerror(result.error()));
+    std::exit(1);
+  }
+  return std::make_shared<foxglove::RawChannel>(std::move(result.value()));
+}
+
+// 客户端按 1000 B/s 消费、积压超过 100ms 视为 lag：第一条 200 字节发出后进入 lag，
+// 之后的消息互相覆盖；恢复后 flushLatest 只发出最新一条，发送字节数的增量即其长度
+bool checkLatestPolicy(const foxglove::Context& context) {
+  auto handle = std::make_shared<ForwardHandle>();
+  handle->topic = "/bench/latest";
+  handle->raw = makeChannel(handle->topic, context);
+  handle->converted = makeChannel(handle->topic + "/converted", context);
+  handle->lag_policy = LagPolicy::Latest;
+  auto client = std::make_shared<ClientBacklog>(1, 1, 1000, 100);
+  handle->setClients(true, std::make_shared<const ForwardHandle::ClientList>(
+                             ForwardHandle::ClientList{client}));
+
+  handle->deliverConverted(std::string(200, 'a'));
+  for (size_t size : {10, 20, 777}) {
+    handle->deliverConverted(std::string(size, 'b'));
+  }
+  auto lagging = client->stats(ClientBacklog::nowNs());
+  // 2 秒后积压已全部流出
+  handle->flushLatest(ClientBacklog::nowNs() + 2000000000ull);
+  auto recovered = client->stats(ClientBacklog::nowNs() + 2000000000ull);
+  bool ok = lagging.sent_bytes == 200 && lagging.collapsed == 2 && lagging.dropped == 0 &&
+            recovered.sent_bytes == 200 + 777;
+  std::printf("latest policy check: %s (sent %lu -> %lu, collapsed %lu)\n", ok ? "ok" : "FAILED",
+    static_cast<unsigned long>(lagging.sent_bytes),
+    static_cast<unsigned long>(recovered.sent_bytes),
+    static_cast<unsigned long>(lagging.collapsed));
+  return ok;
+}
+
+template<typename F>
+double measure(size_t messages, F&& send) {
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < messages; ++i) {
+    send(i);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / messages;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t topic_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 400;
+  size_t messages = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000000;
+  bool with_sink = argc > 3 && std::strcmp(argv[3], "--sink") == 0;
+
+  auto context = foxglove::Context::create();
+  std::optional<foxglove::McapWriter> writer;
+  if (with_sink) {
+    foxglove::McapWriterOptions options;
+    options.context = context;
+    options.compression = foxglove::McapCompression::None;
+    foxglove::CustomWriter discard;
+    uint64_t pos = 0;
+    discard.write = [&pos](const uint8_t*, size_t len, int*) {
+      pos += len;
+      return len;
+    };
+    discard.flush = []() {
+      return 0;
+    };
+    discard.seek = [&pos](int64_t, int, uint64_t* new_pos) {
+      *new_pos = pos;
+      return 0;
+    };
+    options.custom_writer = discard;
+    auto result = foxglove::McapWriter::create(options);
+    if (!result.has_value()) {
+      std::fprintf(stderr, "create mcap writer failed: %s\n", foxglove::strerror(result.error()));
+      return 1;
+    }
+    writer.emplace(std::move(result.value()));
+  }
+
+  if (!checkLatestPolicy(context)) {
+    return 1;
+  }
+
+  const std::string type = Timestamp::descriptor()->full_name();
+  std::vector<std::string> topics;
+  std::map<std::string, LegacyChannel> legacy;
+  std::vector<std::shared_ptr<ForwardHandle>> handles;
+  for (size_t i = 0; i < topic_count; ++i) {
+    std::string topic = "/bench/topic_" + std::to_string(i);
+    auto raw = makeChannel(topic, context);
+    auto converted = makeChannel(topic + "/converted", context);
+    topics.push_back(topic);
+    legacy[topic] = {type, raw};
+    legacy[topic + "/converted"] = {type, converted};
+    auto handle = std::make_shared<ForwardHandle>();
+    handle->topic = topic;
+    handle->msg_type = type;
+    handle->raw = raw;
+    handle->converted = converted;
+    handle->converter = MessageConverter::instance().find(type);
+    handles.push_back(handle);
+  }
+
+  Timestamp stamp;
+  stamp.set_seconds(1700000000);
+  stamp.set_nanos(123456789);
+  const std::string payload = stamp.SerializeAsString();
+
+  // 预热
+  measure(messages / 10, [&](size_t i) {
+    legacySend(legacy, topics[i % topic_count], payload, &stamp);
+    handles[i % topic_count]->forward(payload, &stamp);
+  });
+  double legacy_ns = measure(messages, [&](size_t i) {
+    legacySend(legacy, topics[i % topic_count], payload, &stamp);
+  });
+  double handle_ns = measure(messages, [&](size_t i) {
+    handles[i % topic_count]->forward(payload, &stamp);
+  });
+
+  std::printf("topics: %zu messages: %zu sink: %s\n", topic_count, messages,
+    with_sink ? "mcap(discard)" : "none");
+  std::printf("legacy lookup : %8.1f ns/msg\n", legacy_ns);
+  std::printf("forward handle: %8.1f ns/msg\n", handle_ns);
+  if (writer) {
+    writer->close();
+  }
+  return 0;
+}
@@ -0,0 +1,143 @@
+// 坐标变换汇总开销：TfAggregator 的 update（有变化 / 无变化 / 静态）、onSubscribe 补发与 erase
+// 用法: tf_bench [topics] [frames_per_topic] [updates] [--sink]
+//   --sink 在默认 Context 上挂一个丢弃数据的 MCAP writer，使汇总通道实际编码并 log
+#include <google/protobuf/timestamp.pb.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <foxglove/mcap.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "TfAggregator.hpp"
+
+using google::protobuf::Timestamp;
+
+// seconds 为 frame 序号，nanos 为平移量，模拟各 pose topic 转换出的变换
+static void stampToTransform(const Timestamp& stamp, foxglove::schemas::FrameTransform& tf) {
+  tf.parent_frame_id = "world";
+  tf.child_frame_id = "frame_" + std::to_string(stamp.seconds());
+  tf.translation = foxglove::schemas::Vector3{stamp.nanos() * 1e-6, 0, 0};
+  tf.rotation = foxglove::schemas::Quaternion{0, 0, 0, 1};
+}
+
+REGISTER_TYPED_CONVERTER(Timestamp, FrameTransform, stampToTransform)
+
+namespace {
+
+template<typename F>
+double measure(size_t count, F&& run) {
+  auto begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    run(i);
+  }
+  auto elapsed = std::chrono::steady_clock::now() - begin;
+  return std::chrono::duration<double, std::nano>(elapsed).count() / count;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  size_t topic_count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20;
+  size_t frames = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 5;
+  size_t updates = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000000;
+  bool with_sink = argc > 4 && std::strcmp(argv[4], "--sink") == 0;
+
+  std::optional<foxglove::McapWriter> writer;
+  if (with_sink) {
+    foxglove::McapWriterOptions options;
+    options.compression = foxglove::McapCompression::None;
+    foxglove::CustomWriter discard;
+    uint64_t pos = 0;
+    discard.write = [&pos](const uint8_t*, size_t len, int*) {
+      pos += len;
+      return len;
+    };
+    discard.flush = []() {
+      return 0;
+    };
+    discard.seek = [&pos](int64_t, int, uint64_t* new_pos) {
+      *new_pos = pos;
+      return 0;
+    };
+    options.custom_writer = discard;
+    auto result = foxglove::McapWriter::create(options);
+    if (!result.has_value()) {
+      std::fprintf(stderr, "create mcap writer failed: %s\n", foxglove::strerror(result.error()));
+      return 1;
+    }
+    writer.emplace(std::move(result.value()));
+  }
+
+  const auto* converter =
+    MessageConverter::instance().find(Timestamp::descriptor()->full_name());
+  if (!converter || !converter->transforms) {
+    std::fprintf(stderr, "transform converter not registered\n");
+    return 1;
+  }
+  TfOptions options;
+  options.enabled = true;
+  options.hz = 100;
+  TfAggregator tf(options);
+  if (!tf.start()) {
+    return 1;
+  }
+
+  // 每个 topic 负责 frames 个 child frame，消息按 topic、frame 轮转
+  std::vector<std::string> topics;
+  for (size_t i = 0; i < topic_count; ++i) {
+    topics.push_back("/bench/pose_" + std::to_string(i));
+  }
+  size_t total_frames = topic_count * frames;
+  auto message = [&](size_t i, int32_t nanos) {
+    Timestamp stamp;
+    stamp.set_seconds(static_cast<int64_t>(i % total_frames));
+    stamp.set_nanos(nanos);
+    return stamp;
+  };
+  auto update = [&](size_t i, int32_t nanos, bool is_static) {
+    Timestamp stamp = message(i, nanos);
+    tf.update(topics[(i % total_frames) / frames], is_static, *converter, "", &stamp);
+  };
+
+  // 预热，建立全部 frame
+  measure(total_frames, [&](size_t i) { update(i, 0, false); });
+  // 每次都改变平移：比较、保存并标记待发送
+  double changed_ns = measure(updates, [&](size_t i) {
+    update(i, static_cast<int32_t>(i / total_frames % 1000000 + 1), false);
+  });
+  // 位姿不变：只有转换与比较
+  double unchanged_ns = measure(updates, [&](size_t i) { update(i, 7, false); });
+  // 静态变换有变化时立即发送全部静态变换
+  size_t static_updates = std::max<size_t>(updates / 100, 1);
+  double static_ns = measure(static_updates, [&](size_t i) {
+    update(i, static_cast<int32_t>(i / total_frames % 1000000 + 1), true);
+  });
+  // 新订阅者补发当前全部动态变换；0 不是静态通道的 id，按动态通道处理
+  size_t subscribes = std::max<size_t>(updates / 1000, 1);
+  double subscribe_ns = measure(subscribes, [&](size_t i) { tf.onSubscribe(0, i + 1); });
+  // 源 topic 消失，逐个移除
+  double erase_ns = measure(topic_count, [&](size_t i) { tf.erase(topics[i]); });
+
+  BridgeMetrics::Values values;
+  tf.collect(values);
+  tf.stop();
+  std::printf("topics: %zu frames: %zu updates: %zu sink: %s\n", topic_count, total_frames,
+    updates, with_sink ? "mcap(discard)" : "none");
+  std::printf("update changed  : %10.1f ns/msg\n", changed_ns);
+  std::printf("update unchanged: %10.1f ns/msg\n", unchanged_ns);
+  std::printf("update static   : %10.1f ns/msg\n", static_ns);
+  std::printf("onSubscribe     : %10.1f ns/call\n", subscribe_ns);
+  std::printf("erase           : %10.1f ns/topic\n", erase_ns);
+  for (const auto& [name, value] : values) {
+    std::printf("%s : %lu\n", name.c_str(), static_cast<unsigned long>(value));
+  }
+  if (writer) {
+    writer->close();
+  }
+  return 0;
+}
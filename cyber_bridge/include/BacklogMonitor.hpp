@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "BridgeMetrics.hpp"
+#include "ClientBacklog.hpp"
+
+// 管理各客户端的 ClientBacklog，周期性检查 lag 状态并补发 Latest 策略暂存的消息
+// Linux 下通过 sock_diag 找到各客户端在服务端口上的 TCP 连接，每个周期读取其内核发送状态，
+// 按客户端实际的确认速率与发送队列判断 lag；找不到 socket 的客户端按带宽预算估算
+class BacklogMonitor {
+public:
+  using Tick = std::function<void(uint64_t now_ns)>;  // 周期回调，用于补发暂存消息
+  // 客户端进入（lagging = true）或退出 lag 状态时调用
+  using StatusCallback = std::function<void(const BacklogStats& stats, bool lagging)>;
+
+  BacklogMonitor(uint64_t drain_bytes_per_s, uint32_t threshold_ms, uint32_t interval_ms = 50);
+  ~BacklogMonitor();
+
+  // 客户端每订阅一个通道调用一次 acquire，取消订阅时 release，计数归零后移除
+  // port 为客户端所连服务的端口，用于查找其 socket，0 表示不查找
+  std::shared_ptr<ClientBacklog> acquire(uint32_t client_id, uint64_t sink_id, uint16_t port);
+  void release(uint32_t client_id);
+  std::shared_ptr<ClientBacklog> find(uint32_t client_id);
+
+  void start(Tick tick, StatusCallback status);
+  void stop();
+
+  std::vector<BacklogStats> stats();
+  // 输出到 BridgeMetrics 的计数类变量
+  void collect(BridgeMetrics::Values& values);
+
+private:
+  struct Entry {
+    std::shared_ptr<ClientBacklog> backlog;
+    uint32_t refs = 0;
+    uint16_t port = 0;
+    uint64_t inode = 0;   // 对应的 socket inode，0 表示尚未对应
+    uint32_t probes = 0;  // 查找 socket 的次数，超过上限后不再查找
+  };
+
+  void run();
+  // 读取已对应 socket 的内核发送状态，并为未对应的客户端查找 socket
+  void probeSockets(uint64_t now_ns);
+  std::vector<std::shared_ptr<ClientBacklog>> snapshot();
+
+  const uint64_t _drain_bytes_per_s;
+  const uint32_t _threshold_ms;
+  const uint32_t _interval_ms;
+  std::mutex _mutex;
+  std::map<uint32_t, Entry> _clients;
+
+  Tick _tick;
+  StatusCallback _status;
+  std::mutex _run_mutex;
+  std::condition_variable _cv;
+  std::thread _thread;
+  bool _running = false;
+};
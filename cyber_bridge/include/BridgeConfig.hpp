@@ -0,0 +1,225 @@
+#pragma once
+#include <fnmatch.h>
+#include <logger/log.h>
+
+#include <fstream>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "ClientBacklog.hpp"
+#include "Dispatcher.hpp"
+#include "ImageEncoder.hpp"
+#include "PointCloudReducer.hpp"
+#include "Projection.hpp"
+#include "RateLimiter.hpp"
+
+// 单个 topic（或 service）的选项，由全局配置与匹配到的 topic 规则叠加得到
+struct TopicOptions {
+  bool passthrough = false;       // 透传 RawMessage::message，不做 parse/serialize
+  uint32_t validate_every_n = 0;  // 透传时每 N 帧抽样解析校验一次，0 表示不校验
+  uint32_t queue_size = 16;       // 分发队列长度
+  OverflowPolicy overflow = OverflowPolicy::DropOldest;  // 分发队列满时的策略
+  RatePolicy rate;                // 限频策略，在入队前生效
+  uint32_t service_timeout_ms = 5000;  // 服务调用超时，超时后向客户端回复错误
+  uint32_t service_concurrency = 4;    // 单个服务同时处理的请求数上限，0 表示不限
+  LagPolicy lag_policy = LagPolicy::Drop;  // 订阅客户端积压时的处理策略
+  std::string server;  // 所属 WebSocket 服务（servers 中的 name），为空时使用主服务
+  ImageOptions image;  // 原始图像压缩到 /converted，format 为空时不压缩
+  CloudOptions cloud;  // 点云裁剪与降采样到 /converted，未配置时不处理
+  bool latch = false;  // 保存最近一条消息，新订阅者订阅时立即补发，topic 存在期间保持 cyber 订阅
+  uint32_t batch_ms = 0;  // 大于 0 时创建 <topic>/batch，按该窗口把多条消息合并为一帧
+};
+
+// 额外的 WebSocket 服务，各自使用独立的 Context、端口与分发线程，按 topic 的 server 分类路由
+struct ServerOptions {
+  std::string name;
+  uint16_t port = 0;              // 0 表示主服务端口 + 序号
+  uint32_t dispatch_threads = 1;  // 该分类 topic 的转换与发送线程数
+};
+
+// bridge 配置文件（json），示例见 config/bridge_config.json
+class BridgeConfig {
+public:
+  static BridgeConfig& instance() {
+    static BridgeConfig inst;
+    return inst;
+  }
+
+  bool load(const std::string& path) {
+    std::ifstream ifs(path);
+    if (!ifs.is_open()) {
+      LOG_WARN << "Failed to open config: " << path;
+      return false;
+    }
+    nlohmann::json root = nlohmann::json::parse(ifs, nullptr, false);
+    if (root.is_discarded() || !root.is_object()) {
+      LOG_WARN << "Invalid config: " << path;
+      return false;
+    }
+    // resolve 在运行时调用 apply，字段类型错误需在加载时发现，否则会在订阅时抛出 type_error
+    std::string error;
+    if (!validate(root, error)) {
+      LOG_WARN << "Invalid config: " << path << " " << error;
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _global = root;
+    _global.erase("topics");
+    _rules.clear();
+    if (root.contains("topics") && root["topics"].is_array()) {
+      for (const auto& rule : root["topics"]) {
+        if (!rule.is_object() || !rule.contains("match") || !rule["match"].is_string()) {
+          LOG_WARN << "Skip topic rule without string 'match': " << rule.dump();
+          continue;
+        }
+        if (!validate(rule, error)) {
+          LOG_WARN << "Skip invalid topic rule: " << rule.dump() << " " << error;
+          continue;
+        }
+        _rules.push_back({rule["match"].get<std::string>(), rule});
+      }
+    }
+    LOG_INFO << "Loaded config: " << path << " rules: " << _rules.size();
+    return true;
+  }
+
+  // 按顺序叠加：全局配置 -> 所有匹配的 topic 规则 -> 运行时设置的限频（后者覆盖前者）
+  TopicOptions resolve(const std::string& topic) const {
+    TopicOptions options;
+    std::lock_guard<std::mutex> lock(_mutex);
+    apply(_global, options);
+    for (const auto& rule : _rules) {
+      if (match(rule.pattern, topic)) {
+        apply(rule.options, options);
+      }
+    }
+    for (const auto& [pattern, policy] : _rate_overrides) {
+      if (match(pattern, topic)) {
+        options.rate = policy;
+      }
+    }
+    return options;
+  }
+
+  // 运行时设置限频（topic 名或通配），同一 pattern 重复设置时以最后一次为准
+  void setRate(const std::string& pattern, const RatePolicy& policy) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (auto it = _rate_overrides.begin(); it != _rate_overrides.end(); ++it) {
+      if (it->first == pattern) {
+        _rate_overrides.erase(it);
+        break;
+      }
+    }
+    _rate_overrides.emplace_back(pattern, policy);
+  }
+
+  std::vector<std::pair<std::string, RatePolicy>> rateOverrides() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _rate_overrides;
+  }
+
+  // 只在启动阶段读取
+  const nlohmann::json& global() const {
+    return _global;
+  }
+
+  // 全局 servers 数组，跳过没有 name 的项
+  std::vector<ServerOptions> servers() const {
+    std::vector<ServerOptions> result;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_global.contains("servers") || !_global["servers"].is_array()) {
+      return result;
+    }
+    for (const auto& item : _global["servers"]) {
+      if (!item.is_object() || !item.contains("name") || !item["name"].is_string()) {
+        LOG_WARN << "Skip server without string 'name': " << item.dump();
+        continue;
+      }
+      ServerOptions server;
+      try {
+        server.name = item["name"].get<std::string>();
+        server.port = item.value("port", server.port);
+        server.dispatch_threads = item.value("dispatch_threads", server.dispatch_threads);
+      } catch (const nlohmann::json::exception& e) {
+        LOG_WARN << "Skip invalid server: " << item.dump() << " " << e.what();
+        continue;
+      }
+      result.push_back(server);
+    }
+    return result;
+  }
+
+  // 全局 projections 数组，跳过格式不正确的项
+  std::vector<ProjectionSpec> projections() const {
+    std::vector<ProjectionSpec> result;
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_global.contains("projections") || !_global["projections"].is_array()) {
+      return result;
+    }
+    for (const auto& item : _global["projections"]) {
+      ProjectionSpec spec;
+      if (!ProjectionSpec::fromJson(item, spec)) {
+        LOG_WARN << "Skip invalid projection: " << item.dump();
+        continue;
+      }
+      result.push_back(spec);
+    }
+    return result;
+  }
+
+  // topic 通配匹配，支持 * ? [] 语法
+  static bool match(const std::string& pattern, const std::string& topic) {
+    return fnmatch(pattern.c_str(), topic.c_str(), 0) == 0;
+  }
+
+private:
+  struct TopicRule {
+    std::string pattern;
+    nlohmann::json options;
+  };
+
+  // 按 apply 读取一遍，字段类型错误时返回 false
+  static bool validate(const nlohmann::json& j, std::string& error) {
+    try {
+      TopicOptions options;
+      apply(j, options);
+    } catch (const nlohmann::json::exception& e) {
+      error = e.what();
+      return false;
+    }
+    return true;
+  }
+
+  static void apply(const nlohmann::json& j, TopicOptions& options) {
+    options.passthrough = j.value("passthrough", options.passthrough);
+    options.validate_every_n = j.value("validate_every_n", options.validate_every_n);
+    options.queue_size = j.value("queue_size", options.queue_size);
+    if (j.contains("overflow")) {
+      options.overflow = overflowPolicyFromString(j["overflow"].get<std::string>());
+    }
+    if (j.contains("rate") && !RatePolicy::parse(j["rate"].get<std::string>(), options.rate)) {
+      LOG_WARN << "Invalid rate policy: " << j["rate"].dump();
+    }
+    options.service_timeout_ms = j.value("service_timeout_ms", options.service_timeout_ms);
+    options.service_concurrency = j.value("service_concurrency", options.service_concurrency);
+    if (j.contains("lag_policy")) {
+      options.lag_policy = lagPolicyFromString(j["lag_policy"].get<std::string>());
+    }
+    options.server = j.value("server", options.server);
+    options.latch = j.value("latch", options.latch);
+    options.batch_ms = j.value("batch_ms", options.batch_ms);
+    if (j.contains("cloud") && !CloudOptions::parse(j["cloud"].get<std::string>(), options.cloud)) {
+      LOG_WARN << "Invalid cloud options: " << j["cloud"].dump();
+    }
+    if (j.contains("image")) {
+      options.image = ImageOptions::fromJson(j["image"], options.image);
+    }
+  }
+
+  mutable std::mutex _mutex;
+  nlohmann::json _global = nlohmann::json::object();
+  std::vector<TopicRule> _rules;
+  std::vector<std::pair<std::string, RatePolicy>> _rate_overrides;
+};
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "LatencyRecorder.hpp"
+
+// 单个 topic 的延迟与吞吐统计，订阅时获取并由回调持有，热路径不查表
+struct TopicMetrics {
+  std::string name;              // bvar 风格的变量名前缀
+  LatencyRecorder cyber_latency;  // cyber 发布 -> bridge 收到
+  LatencyRecorder proc_latency;   // protobuf -> foxglove 结构体的转换耗时
+  LatencyRecorder encode_latency;  // 图像压缩、点云降采样耗时，与 proc 分开避免混在同一直方图
+  LatencyRecorder tran_latency;   // bridge 收到 -> log 完成（含排队）
+  std::atomic<uint64_t> recv_msgs{0};   // reader 收到的消息数
+  std::atomic<uint64_t> total_msgs{0};  // 转发到 foxglove 的消息数
+};
+
+// 周期性输出统计：按 bvar 的 key : value 格式写入 dump 目录，并交给 publisher（/bridge/stats）
+class BridgeMetrics {
+public:
+  using Values = std::map<std::string, uint64_t>;
+  // values 为计数类变量，latencies 为延迟分位（us）
+  using Publisher = std::function<void(const Values& values, const Values& latencies)>;
+  // 其他模块的计数类变量，每个周期 collect 时调用
+  using Collector = std::function<void(Values& values)>;
+
+  static BridgeMetrics& instance() {
+    static BridgeMetrics inst;
+    return inst;
+  }
+
+  std::shared_ptr<TopicMetrics> topic(const std::string& topic);
+  // topic 的变量名前缀 fox_bridge_cyber_bridge_channel_<topic>，供其他模块输出按 topic 的计数
+  static std::string topicName(const std::string& topic);
+  // topic 消失时移除其统计项，仍持有的 TopicMetrics 继续有效但不再输出
+  void removeTopic(const std::string& topic);
+
+  // interval_s 为 0 时不启动；dump_dir 为空时只发布不写文件
+  void start(uint32_t interval_s, const std::string& dump_dir);
+  void stop();
+  void setPublisher(Publisher publisher);
+  void addCollector(Collector collector);
+  void clearCollectors();
+
+  // 取走当前窗口的数据，生成一次完整输出
+  void collect(Values& values, Values& latencies);
+
+  ~BridgeMetrics() {
+    stop();
+  }
+
+private:
+  BridgeMetrics() = default;
+  void run();
+  void dump(const Values& values, const std::string& file) const;
+
+  std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<TopicMetrics>> _topics;
+  Publisher _publisher;
+  std::vector<Collector> _collectors;
+
+  std::mutex _run_mutex;
+  std::condition_variable _cv;
+  std::thread _thread;
+  bool _running = false;
+  uint32_t _interval_s = 10;
+  std::string _dump_dir;
+};
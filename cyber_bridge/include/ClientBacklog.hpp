@@ -0,0 +1,197 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 客户端积压时 topic 的处理策略
+enum class LagPolicy {
+  Drop,    // 丢帧，适合相机、点云等大数据量 topic
+  Latest,  // 只保留最新一条，客户端恢复后补发，适合定位、规划状态等状态类 topic
+};
+
+inline LagPolicy lagPolicyFromString(const std::string& name) {
+  return name == "latest" ? LagPolicy::Latest : LagPolicy::Drop;
+}
+
+inline const char* lagPolicyName(LagPolicy policy) {
+  return policy == LagPolicy::Latest ? "latest" : "drop";
+}
+
+struct BacklogStats {
+  uint32_t client_id = 0;
+  uint64_t queued_bytes = 0;   // 估算的未发送字节数
+  uint64_t oldest_age_ms = 0;  // 估算的最旧未发送数据的等待时间
+  uint64_t sent_bytes = 0;
+  uint64_t rate_bytes_per_s = 0;  // 估算积压等待时间使用的发送速率
+  uint64_t dropped = 0;    // Drop 策略丢弃的消息数
+  uint64_t collapsed = 0;  // Latest 策略被新消息覆盖的消息数
+  bool measured = false;   // 积压来自该客户端 socket 的内核发送状态，而不是带宽预算
+  bool lagging = false;
+};
+
+// 客户端 socket 的内核发送状态
+struct SocketSample {
+  uint64_t bytes_acked = 0;  // 对端已确认的字节数（TCP_INFO）
+  uint64_t queued = 0;       // 内核发送队列中未确认与未发送的字节数（SIOCOUTQ）
+};
+
+// 单个客户端的发送积压
+// 找到该客户端的 socket 时按内核发送状态估算：积压为内核发送队列加上交给 SDK 但尚未写入
+// socket 的字节，速率为对端确认的速率，慢链路与快链路各自按实际带宽判断
+// 找不到 socket 时退回漏桶：交给 SDK 的字节进桶，按配置的带宽预算流出
+class ClientBacklog {
+public:
+  ClientBacklog(uint32_t client_id, uint64_t sink_id, uint64_t drain_bytes_per_s,
+    uint32_t threshold_ms)
+      : _client_id(client_id)
+      , _sink_id(sink_id)
+      , _drain_bytes_per_s(drain_bytes_per_s > 0 ? drain_bytes_per_s : 1)
+      , _threshold_ms(threshold_ms)
+      , _rate(_drain_bytes_per_s) {}
+
+  static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  // 积压未超过阈值时计入 bytes 并返回 true，调用方随后把消息发给该客户端
+  bool tryConsume(size_t bytes, uint64_t now_ns) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    leak(now_ns);
+    if (ageMs() >= _threshold_ms) {
+      return false;
+    }
+    if (!_measured) {
+      _level += bytes;
+    }
+    _sent_bytes += bytes;
+    return true;
+  }
+
+  // 由 BacklogMonitor 周期调用，按 socket 的内核发送状态更新积压与速率
+  void observe(const SocketSample& sample, uint64_t now_ns) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_measured && now_ns > _sample_ns && sample.bytes_acked >= _sample.bytes_acked) {
+      uint64_t elapsed_us = (now_ns - _sample_ns) / 1000;
+      uint64_t acked = sample.bytes_acked - _sample.bytes_acked;
+      uint64_t rate = elapsed_us > 0 ? acked * 1000000 / elapsed_us : 0;
+      if (_sample.queued > 0 && sample.queued > 0) {
+        // 期间发送队列一直非空，确认速率即链路的实际带宽，链路停滞时速率降向 0
+        _rate = (_rate * 3 + rate) / 4;
+      } else if (rate > _rate) {
+        // 链路未饱和时确认速率只是带宽的下界
+        _rate = rate;
+      }
+      // 交给 SDK 的字节减去写入 socket 的字节；SDK 另外发送的帧头与广播数据使估算偏小，不会误判
+      int64_t written = static_cast<int64_t>(acked) +
+                        static_cast<int64_t>(sample.queued) - static_cast<int64_t>(_sample.queued);
+      int64_t pending = static_cast<int64_t>(_sdk_queued) +
+                        static_cast<int64_t>(_sent_bytes - _sample_sent) - written;
+      _sdk_queued = pending > 0 ? static_cast<uint64_t>(pending) : 0;
+    } else {
+      _sdk_queued = 0;
+    }
+    _measured = true;
+    _sample = sample;
+    _sample_sent = _sent_bytes;
+    _sample_ns = now_ns;
+  }
+
+  // socket 已关闭或无法读取，退回按带宽预算估算
+  void detach() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _measured = false;
+    _level = 0;
+    _last_ns = 0;
+    _rate = _drain_bytes_per_s;
+  }
+
+  void onDropped() {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+  }
+  void onCollapsed() {
+    _collapsed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // 更新并返回 lag 状态，changed 表示与上次调用相比发生了变化
+  bool refresh(uint64_t now_ns, bool& changed) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    leak(now_ns);
+    bool lagging = ageMs() >= _threshold_ms;
+    changed = lagging != _lagging;
+    _lagging = lagging;
+    return lagging;
+  }
+
+  BacklogStats stats(uint64_t now_ns) {
+    BacklogStats stats;
+    std::lock_guard<std::mutex> lock(_mutex);
+    leak(now_ns);
+    stats.client_id = _client_id;
+    stats.queued_bytes = queuedBytes();
+    stats.oldest_age_ms = ageMs();
+    stats.sent_bytes = _sent_bytes;
+    stats.rate_bytes_per_s = _measured ? _rate : _drain_bytes_per_s;
+    stats.measured = _measured;
+    stats.dropped = _dropped.load(std::memory_order_relaxed);
+    stats.collapsed = _collapsed.load(std::memory_order_relaxed);
+    stats.lagging = _lagging;
+    return stats;
+  }
+
+  uint32_t clientId() const {
+    return _client_id;
+  }
+  uint64_t sinkId() const {
+    return _sink_id;
+  }
+
+private:
+  void leak(uint64_t now_ns) {
+    if (_measured) {
+      return;
+    }
+    if (_last_ns != 0 && now_ns > _last_ns) {
+      // 按 us 计算，避免长时间无发送后乘法溢出
+      uint64_t drained = (now_ns - _last_ns) / 1000 * _drain_bytes_per_s / 1000000ull;
+      if (drained == 0) {
+        return;  // 间隔太短，留到下次一起计算，避免舍入误差累积
+      }
+      _level = drained >= _level ? 0 : _level - drained;
+    }
+    _last_ns = now_ns;
+  }
+
+  uint64_t queuedBytes() const {
+    return _measured ? _sample.queued + _sdk_queued : _level;
+  }
+
+  uint64_t ageMs() const {
+    if (_measured) {
+      return queuedBytes() * 1000 / (_rate > 0 ? _rate : 1);
+    }
+    return _level * 1000 / _drain_bytes_per_s;
+  }
+
+  const uint32_t _client_id;
+  const uint64_t _sink_id;
+  const uint64_t _drain_bytes_per_s;
+  const uint32_t _threshold_ms;
+  std::mutex _mutex;
+  uint64_t _level = 0;
+  uint64_t _last_ns = 0;
+  uint64_t _sent_bytes = 0;
+  bool _lagging = false;
+  // 以下为 socket 测量，_measured 为 false 时不使用
+  bool _measured = false;
+  uint64_t _rate;              // 对端确认速率（B/s），初始为带宽预算
+  SocketSample _sample;        // 上次读取的内核发送状态
+  uint64_t _sample_sent = 0;   // 上次读取时的 _sent_bytes
+  uint64_t _sample_ns = 0;
+  uint64_t _sdk_queued = 0;    // 估算的在 SDK 队列中、尚未写入 socket 的字节
+  std::atomic<uint64_t> _dropped{0};
+  std::atomic<uint64_t> _collapsed{0};
+};
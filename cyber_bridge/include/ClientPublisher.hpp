@@ -0,0 +1,89 @@
+#pragma once
+#include <google/protobuf/util/json_util.h>
+#include <google/protobuf/util/type_resolver.h>
+#include <google/protobuf/util/type_resolver_util.h>
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "protoPool.hpp"
+
+// 客户端发布通道（client advertise）对应的 cyber 写入句柄，advertise 时解析好
+// protobuf 编码的数据直接写入 writer；json 编码使用缓存的 TypeResolver 直接转为二进制，
+// 不再经过中间的 Message 对象
+class ClientPublisher {
+public:
+  ClientPublisher(std::string topic, std::shared_ptr<const TypeInfo> info, bool binary,
+    std::shared_ptr<cyber::Writer<MessageBase>> writer)
+      : _topic(std::move(topic))
+      , _info(std::move(info))
+      , _binary(binary)
+      , _writer(std::move(writer)) {
+    if (!_binary) {
+      _type_url = "type.googleapis.com/" + _info->name();
+      _resolver.reset(google::protobuf::util::NewTypeResolverForDescriptorPool(
+        "type.googleapis.com", _info->descriptor()->file()->pool()));
+    }
+  }
+
+  // 同一通道的消息来自同一个客户端连接，加锁只为保护复用的 RawMessage
+  bool publish(const std::byte* data, size_t len) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto raw = acquire();
+    if (_binary) {
+      raw->message.assign(reinterpret_cast<const char*>(data), len);
+    } else {
+      raw->message.clear();
+      auto status = google::protobuf::util::JsonToBinaryString(_resolver.get(), _type_url,
+        {reinterpret_cast<const char*>(data), len}, &raw->message);
+      if (!status.ok()) {
+        _errors.fetch_add(1, std::memory_order_relaxed);
+        LOG_WARN << "Failed to convert JSON to message: " << _topic << " "
+                 << status.ToString();
+        return false;
+      }
+    }
+    if (!_writer->Write(raw)) {
+      _errors.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    _published.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  const std::string& topic() const {
+    return _topic;
+  }
+  bool binary() const {
+    return _binary;
+  }
+  uint64_t published() const {
+    return _published.load(std::memory_order_relaxed);
+  }
+  uint64_t errors() const {
+    return _errors.load(std::memory_order_relaxed);
+  }
+
+private:
+  // cyber 已释放上一条消息时复用，否则重新分配
+  std::shared_ptr<MessageBase> acquire() {
+    if (!_raw || _raw.use_count() > 1) {
+      _raw = std::make_shared<MessageBase>();
+    }
+    return _raw;
+  }
+
+  const std::string _topic;
+  std::shared_ptr<const TypeInfo> _info;
+  const bool _binary;
+  std::shared_ptr<cyber::Writer<MessageBase>> _writer;
+  std::string _type_url;
+  std::unique_ptr<google::protobuf::util::TypeResolver> _resolver;
+  std::mutex _mutex;
+  std::shared_ptr<MessageBase> _raw;
+  std::atomic<uint64_t> _published{0};
+  std::atomic<uint64_t> _errors{0};
+};
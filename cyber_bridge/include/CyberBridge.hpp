@@ -3,17 +3,37 @@
 #include <cyber/node/reader.h>
 #include <cyber/parameter/parameter_client.h>
 #include <cyber/parameter/parameter_server.h>
+#include <cyber/service_discovery/topology_manager.h>
 #include <cyber/time/rate.h>
 #include <cyber/time/time.h>
 
+#include <chrono>
+#include <mutex>
 #include <optional>
 #include <queue>
+#include <set>
+
+#include "ClientPublisher.hpp"
+#include "Dispatcher.hpp"
+#include "RateLimiter.hpp"
+#include "RcuRegistry.hpp"
 
 using namespace apollo;
 // using namespace gwm::adcos;
 using MessageBase = cyber::message::RawMessage;
 class mssageManage;  // manage message
 
+// 进入分发队列的消息，附带 bridge 收到的时间（cyber 时钟，ns）
+struct InboundMessage {
+  std::shared_ptr<MessageBase> msg;
+  uint64_t recv_ns = 0;
+  explicit operator bool() const {
+    return msg != nullptr;
+  }
+};
+using InboundQueue = TopicQueue<InboundMessage>;
+using InboundLimiter = RateLimiter<InboundMessage>;
+
 struct Schema {
   std::string name;
   std::string desc;
@@ -26,25 +46,38 @@ public:
 
   using adCallback = std::function<void(
     const std::string& topic, Schema& schema_1, std::optional<Schema>& schema_2)>;
-  using msgCallback = std::function<void(const std::string& topic, const std::string& msg)>;
+  // parsed 为已解析的消息（位于分发线程 arena 上），透传且未抽样时为 nullptr
+  using msgCallback = std::function<void(const std::string& topic, const std::string& msg,
+    const google::protobuf::Message* parsed)>;
   using unScribeCallback = std::function<void(const std::string& topic)>;
+  // 监听 topology 变化增量发现 topic/service，定时器仅做低频全量对账
   void startDiscoverTimer(const adCallback& topic_adCb, const unScribeCallback& topic_unadCb,
     const adCallback& service_adCb);
   void onUnsubscribe(const std::string& topic);
   void onSubscribe(const std::string& topic, const msgCallback& cb);
-  void onWriterCreate(const std::string& topic, const std::string& msg_type);
+  // 客户端 advertise 时创建（或复用）writer，返回该客户端通道的写入句柄，失败返回 nullptr
+  // encoding 为 json 或 protobuf
+  std::shared_ptr<ClientPublisher> onWriterCreate(
+    const std::string& topic, const std::string& msg_type, const std::string& encoding);
+  // 同一 topic 可被多个客户端 advertise，最后一个 unadvertise 时才释放 writer
   void onWriterDelete(const std::string& topic);
-  void onReceiveMsg(const std::string& topic, const std::string& msg);
 
   bool start();
   void stop();
 
-  std::vector<std::string> getTopics() const {
-    return _topics;
+  std::vector<std::string> getTopics() {
+    std::lock_guard<std::mutex> lock(_discover_mutex);
+    return {_topics.begin(), _topics.end()};
   }
   std::shared_ptr<mssageManage> getMsgManage(const std::string& topic) {
-    return _msg_manages[topic];
+    return _msg_manages.get(topic);
   }
+  // 各 topic 分发队列的深度及丢弃计数
+  std::vector<QueueStats> getQueueStats();
+  // 运行时修改限频，pattern 为 topic 名或通配，立即作用于已订阅的 topic
+  void setRatePolicy(const std::string& pattern, const RatePolicy& policy);
+  // 各 topic 限频后的转发/抑制计数
+  std::vector<RateStats> getRateStats();
   // std::weak_ptr<Reader<MessageBase>> getReader(const std::string& topic)
   // {
   //     return _readers[topic];
@@ -55,7 +88,10 @@ public:
   void onServiceUnregister(const std::string& service_name);
 
   void onClientRegister(const std::string& client_name);
-  void onClientCall(const std::string& topic, const std::string& req, std::string& res);
+  // 调用 cyber 服务并等待响应，最多等待 timeout；失败时 error 为回复给客户端的错误信息
+  // 可在多个线程中并发调用
+  bool onClientCall(const std::string& topic, const std::string& req, std::string& res,
+    std::chrono::milliseconds timeout, std::string& error);
   void onClientUnregister(const std::string& client_name);
 
   void onSetParameter(std::string& key, std::string& type, cyber::Parameter& parameter);
@@ -63,20 +99,47 @@ public:
     const std::vector<std::string_view>& param_names, std::vector<cyber::Parameter>& parameters);
 
 private:
-  void discoverTopics(const adCallback& adCb, const unScribeCallback& unScribeCb);
-  void discoverServices(const adCallback& adCb);
+  void onTopologyChange(const cyber::proto::ChangeMsg& msg);
+  void reconcile();
+  // 以下由持有 _discover_mutex 的调用方调用
+  void discoverTopics();
+  void discoverServices();
+  void addTopic(const std::string& channel);
+  void removeTopic(const std::string& channel);
+  void flushRateWindows();  // 投递 window 模式下已到期的暂存消息
+  // 按 topic 的 server 分类选择分发线程池，未配置的分类使用默认线程池
+  Dispatcher* dispatcherFor(const std::string& server);
 
 private:
-  std::vector<std::string> _topics;
+  std::mutex _discover_mutex;  // 串行化事件与对账，保护 _topics 及发现回调
+  std::set<std::string> _topics;  // 已广播的 cyber topic（存在 writer）
+  adCallback _topic_adCb;
+  unScribeCallback _topic_unadCb;
+  adCallback _service_adCb;
+  cyber::service_discovery::TopologyManager::ChangeConnection _change_conn;
   std::shared_ptr<cyber::Timer> _timer;
+  std::shared_ptr<cyber::Timer> _rate_timer;
   std::shared_ptr<cyber::Node> _node;
   // std::shared_ptr<cyber::ParameterServer> _param_server;
   std::shared_ptr<cyber::ParameterClient> _param_client;
 
-  std::map<std::string, std::shared_ptr<mssageManage>> _msg_manages;
+  RcuRegistry<mssageManage> _msg_manages;  // 读取无锁，写入来自发现线程与客户端 advertise
+  std::mutex _topic_mutex;                 // 保护 _readers、_writers、_writer_refs
   std::map<std::string, std::shared_ptr<cyber::ReaderBase>> _readers;
+  std::unique_ptr<Dispatcher> _dispatcher;  // cyber 回调与 foxglove 发送解耦
+  // servers 中每个分类独立的线程池，大数据量 topic 的转换与发送不占用默认线程池
+  std::map<std::string, std::unique_ptr<Dispatcher>> _server_dispatchers;
+  std::mutex _queue_mutex;
+  std::map<std::string, std::shared_ptr<InboundQueue>> _queues;
+  std::map<std::string, std::shared_ptr<InboundLimiter>> _limiters;  // 由 _queue_mutex 保护
   std::map<std::string, std::shared_ptr<cyber::WriterBase>> _writers;
+  struct WriterRef {
+    uint32_t count = 0;        // advertise 该 topic 的客户端通道数
+    bool owns_manage = false;  // _msg_manages 中的句柄由 advertise 创建，释放 writer 时一并移除
+  };
+  std::map<std::string, WriterRef> _writer_refs;
   std::map<std::string, std::shared_ptr<mssageManage>> _srv_msgs;
+  std::mutex _client_mutex;  // 保护 _services、_clients，服务调用来自多个 worker 线程
   std::map<std::string, std::pair<std::shared_ptr<mssageManage>, std::shared_ptr<mssageManage>>>
     _services;
   std::map<std::string, std::shared_ptr<cyber::ClientBase>> _clients;
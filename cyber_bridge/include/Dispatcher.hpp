@@ -0,0 +1,170 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BoundedQueue.hpp"
+
+// 队列满时的处理策略
+enum class OverflowPolicy {
+  DropOldest,  // 丢弃最旧的消息
+  KeepLatest,  // 只保留最新一条
+  Block,       // 阻塞生产者（cyber 回调线程）直到有空位
+};
+
+inline OverflowPolicy overflowPolicyFromString(const std::string& name) {
+  if (name == "keep_latest") return OverflowPolicy::KeepLatest;
+  if (name == "block") return OverflowPolicy::Block;
+  return OverflowPolicy::DropOldest;
+}
+
+inline const char* overflowPolicyName(OverflowPolicy policy) {
+  switch (policy) {
+    case OverflowPolicy::KeepLatest:
+      return "keep_latest";
+    case OverflowPolicy::Block:
+      return "block";
+    default:
+      return "drop_oldest";
+  }
+}
+
+struct QueueStats {
+  std::string topic;
+  size_t depth = 0;
+  size_t capacity = 0;
+  uint64_t enqueued = 0;
+  uint64_t dropped = 0;
+};
+
+class Dispatcher;
+
+// 可被 Dispatcher 调度的队列，同一时刻只会被一个 worker 消费，保证单队列内有序
+class DispatchQueue : public std::enable_shared_from_this<DispatchQueue> {
+public:
+  virtual ~DispatchQueue() = default;
+  // 消费最多 budget 条，返回实际处理条数
+  virtual size_t drain(size_t budget) = 0;
+  virtual bool empty() const = 0;
+
+private:
+  friend class Dispatcher;
+  std::atomic<bool> _scheduled{false};
+};
+
+// 固定大小的 worker 线程池，按队列轮转消费
+class Dispatcher {
+public:
+  explicit Dispatcher(size_t threads, size_t budget = 64);
+  ~Dispatcher();
+
+  // 队列有新数据时调用，已在调度中则忽略
+  void schedule(DispatchQueue& queue);
+  void stop();
+  size_t threads() const {
+    return _workers.size();
+  }
+
+private:
+  void workerLoop();
+
+  const size_t _budget;
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::deque<std::shared_ptr<DispatchQueue>> _ready;
+  bool _stopped = false;
+};
+
+// 单个 topic 的有界消息队列，生产者为该 topic 的 cyber reader 回调
+template<typename T>
+class TopicQueue final : public DispatchQueue {
+public:
+  using Handler = std::function<void(const T&)>;
+
+  TopicQueue(std::string topic, size_t capacity, OverflowPolicy policy, Handler handler,
+    Dispatcher* dispatcher)
+      : _topic(std::move(topic))
+      , _policy(policy)
+      , _queue(capacity)
+      , _handler(std::move(handler))
+      , _dispatcher(dispatcher) {}
+
+  bool push(T msg) {
+    if (_closed.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    if (_policy == OverflowPolicy::KeepLatest) {
+      T stale;
+      while (_queue.tryPop(stale)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    while (!_queue.tryPush(std::move(msg))) {
+      if (_policy == OverflowPolicy::Block) {
+        if (_closed.load(std::memory_order_relaxed)) {
+          return false;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        continue;
+      }
+      T stale;
+      if (_queue.tryPop(stale)) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+    _enqueued.fetch_add(1, std::memory_order_relaxed);
+    _dispatcher->schedule(*this);
+    return true;
+  }
+
+  size_t drain(size_t budget) override {
+    size_t count = 0;
+    T msg;
+    while (count < budget && _queue.tryPop(msg)) {
+      _handler(msg);
+      ++count;
+    }
+    return count;
+  }
+
+  bool empty() const override {
+    return _queue.empty();
+  }
+
+  // 关闭后不再接收新消息，阻塞中的生产者立即返回
+  void close() {
+    _closed.store(true, std::memory_order_relaxed);
+  }
+
+  QueueStats stats() const {
+    QueueStats stats;
+    stats.topic = _topic;
+    stats.depth = _queue.size();
+    stats.capacity = _queue.capacity();
+    stats.enqueued = _enqueued.load(std::memory_order_relaxed);
+    stats.dropped = _dropped.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  OverflowPolicy policy() const {
+    return _policy;
+  }
+
+private:
+  const std::string _topic;
+  const OverflowPolicy _policy;
+  BoundedQueue<T> _queue;
+  Handler _handler;
+  Dispatcher* _dispatcher;
+  std::atomic<bool> _closed{false};
+  std::atomic<uint64_t> _enqueued{0};
+  std::atomic<uint64_t> _dropped{0};
+};
@@ -0,0 +1,267 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <foxglove/channel.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BridgeMetrics.hpp"
+#include "ClientBacklog.hpp"
+#include "LatchCache.hpp"
+#include "MessageBatch.hpp"
+#include "MessageConverter.hpp"
+#include "Projection.hpp"
+#include "ProtoArena.hpp"
+#include "RewindBuffer.hpp"
+#include "TfAggregator.hpp"
+#include "logger/log.h"
+
+struct ForwardStats {
+  std::string topic;
+  uint64_t messages = 0;   // 收到的消息数
+  uint64_t bytes = 0;      // raw 通道 log 的字节数
+  uint64_t converted = 0;  // /converted 通道 log 的消息数
+  uint64_t errors = 0;     // 转换或 log 失败数
+};
+
+// 订阅时解析好的转发句柄，由 cyber 回调持有
+// 转发时直接使用其中的通道与转换器，不再按 topic 查表、拼接字符串
+struct ForwardHandle : std::enable_shared_from_this<ForwardHandle> {
+  std::string topic;
+  std::string msg_type;
+  std::shared_ptr<foxglove::RawChannel> raw;
+  std::shared_ptr<foxglove::RawChannel> converted;  // 没有转换器时为空
+  const ConverterInfo* converter = nullptr;         // 指向 MessageConverter 内的注册项
+  std::shared_ptr<AsyncConverter> async_converter;  // 可为空，设置时代替 converter
+  std::shared_ptr<TopicMetrics> metrics;            // 可为空，记录转换耗时
+  LagPolicy lag_policy = LagPolicy::Drop;           // 订阅客户端积压时的处理策略
+  std::shared_ptr<LatchSlot> latch;  // 可为空，保存最近一条消息，新订阅者订阅时补发
+  std::shared_ptr<RewindTrack> rewind;  // 可为空，写入回看缓冲
+  std::shared_ptr<MessageBatch> batch;  // 可为空，合并到 <topic>/batch，不做按客户端背压
+  std::shared_ptr<TfAggregator> tf;     // 可为空，converter 提供变换时汇总到 tf 通道
+  bool tf_static = false;               // 汇总到静态 tf 通道
+
+  std::atomic<uint64_t> messages{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> converted_count{0};
+  std::atomic<uint64_t> errors{0};
+
+  // 只对有 sink（客户端订阅或录制）的通道做 log，无人订阅的 /converted 通道不做转换
+  bool forward(const std::string& message, const google::protobuf::Message* parsed) {
+    if (message.empty()) {
+      return false;
+    }
+    messages.fetch_add(1, std::memory_order_relaxed);
+    if (latch) {
+      latch->store(message);
+    }
+    if (rewind) {
+      rewind->push(message);
+    }
+    if (raw->has_sinks()) {
+      if (!deliver(*raw, false, message)) {
+        return false;
+      }
+      bytes.fetch_add(message.size(), std::memory_order_relaxed);
+    }
+    if (batch && batch->channel()->has_sinks()) {
+      batch->add(message);
+    }
+    // 派生通道与转换器共用同一次解析结果
+    if (auto projections = std::atomic_load(&_projections)) {
+      for (const auto& projection : *projections) {
+        projection->forward(message, parsed);
+      }
+    }
+    if (tf) {
+      tf->update(topic, tf_static, *converter, message, parsed);
+    }
+    if (async_converter) {
+      if (converted && converted->has_sinks()) {
+        async_converter->offer(message, [self = shared_from_this()](const std::string& output) {
+          self->deliverConverted(output);
+        });
+      }
+      return true;
+    }
+    if (!converter || !converted || !converted->has_sinks()) {
+      return true;
+    }
+    std::string& output = ProtoArena::local().convertedBuffer();
+    auto begin = std::chrono::steady_clock::now();
+    bool ok = converter->converter(message, parsed, output) && !output.empty();
+    if (metrics) {
+      auto elapsed = std::chrono::steady_clock::now() - begin;
+      metrics->proc_latency.record(
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+    }
+    if (!ok) {
+      errors.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (!deliver(*converted, true, output)) {
+      return false;
+    }
+    converted_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // 把最近一条消息只发给新订阅 channel 的客户端（sink_id），channel 为 raw、/converted 或派生通道
+  // /converted 与派生通道在调用线程上按需转换，异步转换（图像、点云）不补发
+  bool sendLatched(const std::shared_ptr<foxglove::RawChannel>& channel, uint64_t sink_id) {
+    auto data = latch ? latch->load() : nullptr;
+    if (!data || !channel) {
+      return false;
+    }
+    bool ok = false;
+    if (channel == raw) {
+      ok = logTo(*raw, *data, sink_id);
+    } else if (channel == converted) {
+      if (!converter || async_converter) {
+        return false;
+      }
+      ProtoArena::local().reset();
+      std::string output;
+      if (!converter->converter(*data, nullptr, output) || output.empty()) {
+        errors.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      ok = logTo(*converted, output, sink_id);
+    } else if (auto projections = std::atomic_load(&_projections)) {
+      for (const auto& projection : *projections) {
+        if (projection->channel() == channel) {
+          ProtoArena::local().reset();
+          const google::protobuf::Message* parsed = nullptr;
+          ok = projection->forward(*data, parsed, sink_id);
+          break;
+        }
+      }
+    }
+    if (ok) {
+      latch->onSent();
+    }
+    return ok;
+  }
+
+  // 异步转换完成后由转换线程调用
+  void deliverConverted(const std::string& output) {
+    if (deliver(*converted, true, output)) {
+      converted_count.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  using ProjectionList = std::vector<std::shared_ptr<Projection>>;
+
+  // 设置以该 topic 为源的派生通道，派生通道直接 log 给所有 sink，不做按客户端背压
+  void setProjections(std::shared_ptr<const ProjectionList> projections) {
+    std::atomic_store(&_projections, std::move(projections));
+  }
+
+  using ClientList = std::vector<std::shared_ptr<ClientBacklog>>;
+
+  // 设置订阅 raw（converted = false）或 /converted 通道的客户端，逐个客户端按积压发送
+  // clients 为空指针时不做背压，直接 log 给该通道的所有 sink
+  void setClients(bool converted_channel, std::shared_ptr<const ClientList> clients) {
+    std::atomic_store(converted_channel ? &_converted_clients : &_raw_clients, std::move(clients));
+  }
+
+  // 补发 Latest 策略下暂存的消息，客户端仍在积压时继续暂存
+  void flushLatest(uint64_t now_ns) {
+    if (_latest_pending.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(_latest_mutex);
+    for (auto it = _latest.begin(); it != _latest.end();) {
+      auto [client_id, converted_channel] = it->first;
+      auto clients = std::atomic_load(converted_channel ? &_converted_clients : &_raw_clients);
+      std::shared_ptr<ClientBacklog> client;
+      if (clients) {
+        for (const auto& candidate : *clients) {
+          if (candidate->clientId() == client_id) {
+            client = candidate;
+            break;
+          }
+        }
+      }
+      if (client && !client->tryConsume(it->second.size(), now_ns)) {
+        ++it;
+        continue;
+      }
+      if (client) {
+        auto& channel = converted_channel ? *converted : *raw;
+        logTo(channel, it->second, client->sinkId());
+      }
+      it = _latest.erase(it);
+      _latest_pending.fetch_sub(1, std::memory_order_relaxed);
+    }
+  }
+
+  ForwardStats stats() const {
+    ForwardStats stats;
+    stats.topic = topic;
+    stats.messages = messages.load(std::memory_order_relaxed);
+    stats.bytes = bytes.load(std::memory_order_relaxed);
+    stats.converted = converted_count.load(std::memory_order_relaxed);
+    stats.errors = errors.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+private:
+  bool logTo(foxglove::RawChannel& channel, const std::string& data,
+    std::optional<uint64_t> sink_id) {
+    auto result = channel.log(
+      reinterpret_cast<const std::byte*>(data.data()), data.size(), std::nullopt, sink_id);
+    if (result != foxglove::FoxgloveError::Ok) {
+      errors.fetch_add(1, std::memory_order_relaxed);
+      LOG_ERROR << "Failed to log message: " << foxglove::strerror(result);
+      return false;
+    }
+    return true;
+  }
+
+  bool deliver(foxglove::RawChannel& channel, bool converted_channel, const std::string& data) {
+    auto clients = std::atomic_load(converted_channel ? &_converted_clients : &_raw_clients);
+    if (!clients) {
+      return logTo(channel, data, std::nullopt);
+    }
+    uint64_t now = ClientBacklog::nowNs();
+    bool ok = true;
+    for (const auto& client : *clients) {
+      if (client->tryConsume(data.size(), now)) {
+        // 客户端已恢复，直接发送的消息比暂存的更新，丢弃暂存
+        if (_latest_pending.load(std::memory_order_relaxed) > 0) {
+          std::lock_guard<std::mutex> lock(_latest_mutex);
+          if (_latest.erase({client->clientId(), converted_channel}) > 0) {
+            _latest_pending.fetch_sub(1, std::memory_order_relaxed);
+          }
+        }
+        ok = logTo(channel, data, client->sinkId()) && ok;
+        continue;
+      }
+      if (lag_policy == LagPolicy::Drop) {
+        client->onDropped();
+        continue;
+      }
+      std::lock_guard<std::mutex> lock(_latest_mutex);
+      auto [it, inserted] = _latest.try_emplace({client->clientId(), converted_channel}, data);
+      if (inserted) {
+        _latest_pending.fetch_add(1, std::memory_order_relaxed);
+      } else {
+        it->second = data;
+        client->onCollapsed();
+      }
+    }
+    return ok;
+  }
+
+  std::shared_ptr<const ClientList> _raw_clients;
+  std::shared_ptr<const ClientList> _converted_clients;
+  std::shared_ptr<const ProjectionList> _projections;
+  std::mutex _latest_mutex;
+  std::map<std::pair<uint32_t, bool>, std::string> _latest;  // (client id, 是否 /converted) -> 数据
+  std::atomic<size_t> _latest_pending{0};
+};
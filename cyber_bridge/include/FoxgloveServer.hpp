@@ -2,16 +2,35 @@
 #define USE_CYBER_BRIDGE
 #include <atomic>
 #include <foxglove/channel.hpp>
-#include <foxglove/mcap.hpp>
+#include <foxglove/context.hpp>
 #include <foxglove/server.hpp>
 #include <foxglove/server/service.hpp>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <string>
 
+#include "BacklogMonitor.hpp"
+#include "ForwardHandle.hpp"
+#include "ImageStage.hpp"
+#include "LatchCache.hpp"
+#include "MessageBatch.hpp"
+#include "PointCloudStage.hpp"
+#include "McapRecorder.hpp"
+#include "RcuRegistry.hpp"
+#include "RewindBuffer.hpp"
+#include "RewindPlayer.hpp"
+#include "ServiceExecutor.hpp"
+#include "TfAggregator.hpp"
+
+namespace google::protobuf {
+class Message;
+}
+
 #ifdef USE_CYBER_BRIDGE
 class CyberBridge;
+class ClientPublisher;
 struct Schema;
 #else
 class FastDDSBridge;
@@ -20,11 +39,15 @@ class FoxgloveServer {
 public:
   struct ChannelConfig {
     std::string type;
-    int32_t sub_count;
+    std::string source;  // 数据来源的 cyber topic，/converted 通道与原始通道相同
+    int32_t sub_count;   // 订阅该通道的客户端数，由 _sub_mutex 保护
+    uint8_t server;      // 所属服务序号，0 为主服务
     std::shared_ptr<foxglove::RawChannel> channel;
     ChannelConfig()
         : type("")
+        , source("")
         , sub_count(0)
+        , server(0)
         , channel(nullptr) {}
   };
 
@@ -32,12 +55,19 @@ public:
   FoxgloveServer();
   ~FoxgloveServer();
   bool start(const std::string& ipAddress, uint16_t port);
-  bool start(const std::string& filePath, const std::string& filename);
   void stop();
+  // 录制与实时转发共用同一 Context，每条消息只 log 一次，由 SDK 同时分发给客户端与 MCAP 文件
+  bool startRecording();
+  void stopRecording();
+  void setRecordTopics(const std::vector<std::string>& topics);
 
   bool createChannel(const std::string& topic, Schema& schema);
   void closeChannel(const std::string& topic);
-  bool sendMessage(const std::string& topic, const std::string& message);
+  // 按 topic 查找通道后发送；cyber 订阅走 ForwardHandle，不经过这里
+  bool sendMessage(const std::string& topic, const std::string& message,
+    const google::protobuf::Message* parsed = nullptr);
+  // 当前订阅中各 topic 的转发计数
+  std::vector<ForwardStats> getForwardStats();
   auto getBridge() const {
     return _bridge;
   }
@@ -45,7 +75,89 @@ public:
     const std::string& service_name, Schema& request_schema, Schema& response_schema);
 
 private:
+  // 额外的 WebSocket 服务，独立的 Context 与端口，只承载按 server 分类路由过来的 topic
+  struct Endpoint {
+    std::string name;
+    foxglove::Context context;
+    std::unique_ptr<foxglove::WebSocketServer> server;
+  };
+  static constexpr uint32_t kClientIdBits = 24;
+  static constexpr uint32_t kClientIdMask = (1u << kClientIdBits) - 1;
+  static constexpr size_t kMaxEndpoints = 255;
+  // 各服务的 client id 各自从 1 开始，高 8 位放服务序号，作为 bridge 内部的客户端 key
+  static uint32_t clientKey(uint8_t index, uint32_t client_id) {
+    return (static_cast<uint32_t>(index) << kClientIdBits) | (client_id & kClientIdMask);
+  }
+
   bool setConfigParam();  // 设置配置参数
+  // 序号为 index 的服务的选项与回调，额外服务只支持订阅与客户端发布
+  foxglove::WebSocketServerOptions serverOptions(uint8_t index);
+  // 按配置中的 servers 启动额外服务，端口为 0 时使用主服务端口 + 序号
+  void startEndpoints(const std::string& ipAddress, uint16_t port);
+  // topic 所属服务的序号，未配置或服务未启动时为 0
+  uint8_t endpointFor(const std::string& topic);
+  foxglove::Context contextOf(uint8_t index) const;
+  foxglove::WebSocketServer* serverOf(uint32_t client_key) const;
+  // 各服务的通道数、客户端数、转发消息数与字节数
+  void collectEndpoints(BridgeMetrics::Values& values);
+  // 限频参数（rate.<topic>），names 为空时列出全部
+  void getRateParameters(
+    const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result);
+  // 点云降采样参数（cloud.<topic>），names 为空时列出全部点云 topic
+  void getCloudParameters(
+    const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result);
+  // 修改匹配 pattern 的点云 topic 的降采样选项，返回匹配到的数量
+  size_t setCloudOptions(const std::string& pattern, const CloudOptions& options);
+  // 派生通道参数（projection.<topic>），names 为空时列出全部定义
+  void getProjectionParameters(
+    const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result);
+  // 新增、替换或删除（text 为 off 或空）派生通道定义，源通道已存在时立即创建
+  bool setProjection(const std::string& topic, const std::string& text, std::string& error);
+  // 按源消息类型编译派生通道，不创建通道
+  std::shared_ptr<Projection> compileProjection(
+    const ProjectionSpec& spec, const std::string& type, std::string& error);
+  // 按定义编译并创建派生通道，源通道不存在或 topic 已被占用时失败
+  bool createProjection(const ProjectionSpec& spec, std::string& error);
+  // 创建以 source 为源的所有派生通道，在源通道创建后调用
+  void createProjections(const std::string& source);
+  void removeProjection(const std::string& topic);
+  // topic 配置了 batch_ms 时创建 <topic>/batch 通道，在源通道创建后调用
+  void createBatch(const std::string& topic, const std::string& type, uint8_t server);
+  // source 当前的派生通道列表，调用方持有 _sub_mutex
+  std::shared_ptr<const ForwardHandle::ProjectionList> projectionsOf(const std::string& source);
+  // 通道关闭后不会再收到 unsubscribe，释放订阅该通道的客户端，调用方持有 _sub_mutex
+  void releaseChannelClients(uint64_t channel_id);
+  // 按 channel id 增减订阅计数，source topic 的 raw 与 /converted 都无人订阅时关闭 cyber reader
+  void onChannelSubscribe(uint64_t channel_id, const foxglove::ClientMetadata& client);
+  void onChannelUnsubscribe(uint64_t channel_id, const foxglove::ClientMetadata& client);
+  std::shared_ptr<ForwardHandle> makeForwardHandle(const std::string& source);
+  // topic 配置了 cloud / image 且消息为点云 / 原始图像时创建转换阶段并给出 /converted 的 schema，
+  // 否则返回空
+  std::shared_ptr<AsyncConverter> makeStage(
+    const std::string& topic, const std::string& type, foxglove::Schema& schema);
+  // source topic 的引用计数，首次引用时创建 cyber reader，调用方持有 _sub_mutex
+  bool acquireSource(const std::string& source);
+  void releaseSource(const std::string& source);
+  // 按录制与回看缓冲的 topic 引用 source，使无客户端订阅的 topic 也能录制，调用方持有 _sub_mutex
+  void syncRecordedSources();
+  bool isRecorded(std::string_view topic);
+  // 录制参数（record.enabled / record.topics / record.file），names 为空时列出全部
+  void getRecordParameters(
+    const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result);
+  // 冻结回看缓冲并（重新）启动回看服务，已连接回看服务的客户端需要重连
+  bool startRewind(std::string& message);
+  void stopRewind();
+  // 回看参数（rewind.snapshot / rewind.status），names 为空时列出全部
+  void getRewindParameters(
+    const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result);
+  // 按 _channel_clients 更新 handle 的客户端列表，调用方持有 _sub_mutex
+  void refreshClients(ForwardHandle& handle);
+  // 配置了 client_budget_mbps 时启动客户端积压监控
+  void startBacklogMonitor();
+  // 启动统计输出：dump 文件与 /bridge/stats 通道
+  void startStats();
+  // 停止录制、执行器、统计与全部服务，stop() 与主服务创建失败时调用
+  void shutdown();
 
 private:
 #ifdef USE_CYBER_BRIDGE
@@ -53,15 +165,41 @@ private:
 #else
   std::shared_ptr<FastDDSBridge> _bridge;
 #endif
-  std::unique_ptr<foxglove::WebSocketServer> _server;
-  std::unique_ptr<foxglove::McapWriter> _mcapWriter;
-  std::map<std::string, ChannelConfig> _channels;
-  std::map<uint32_t, std::string> _client_channels;
+  std::unique_ptr<foxglove::WebSocketServer> _server;  // 主服务，使用默认 Context
+  std::vector<Endpoint> _endpoints;  // 序号 1.. 的额外服务，启动后不再变化
+  RcuRegistry<ChannelConfig> _channels;  // 按 topic 与 foxglove channel id 索引，转发路径无锁读取
+  std::mutex _sub_mutex;
+  std::map<std::string, int32_t> _source_refs;  // source topic -> 订阅数（raw + /converted）
+  std::map<std::string, std::shared_ptr<ForwardHandle>> _handles;  // 由 _sub_mutex 保护
+  std::set<std::string> _recorded_sources;  // 因录制或回看缓冲而引用的 source topic，由 _sub_mutex 保护
+  std::set<std::string> _latched_sources;   // 因 latch 而引用的 source topic，由 _sub_mutex 保护
+  std::set<std::string> _tf_sources;  // 因 tf 汇总而引用的 source topic，由 _sub_mutex 保护
+  std::map<uint64_t, std::set<uint32_t>> _channel_clients;  // channel id -> 客户端，由 _sub_mutex 保护
+  std::unique_ptr<BacklogMonitor> _backlog;  // 未配置 client_budget_mbps 时为空，不做背压
+  std::mutex _client_mutex;
+  // (client id, client channel id) -> 写入句柄，client channel id 只在单个客户端内唯一
+  std::map<std::pair<uint32_t, uint32_t>, std::shared_ptr<ClientPublisher>> _client_channels;
   // std::map<std::string, foxglove::Parameter> param_store;
   std::map<std::string, std::shared_ptr<foxglove::Parameter>> _param_store;  // 参数存储
   std::set<std::string> _services_set;
-
-  std::atomic<bool> _isRecording;
-  std::string _recordingFilePath;
-  uint32_t _recordTime;  // 记录时间
+  std::shared_ptr<foxglove::RawChannel> _stats_channel;  // /bridge/stats，json 编码
+  std::unique_ptr<ServiceExecutor> _service_executor;    // 服务调用线程池
+  std::unique_ptr<ServiceExecutor> _image_executor;      // 图像压缩线程池，按 topic 限制并发
+  // source topic -> 图像压缩、点云降采样等转换阶段，由 _sub_mutex 保护，通道关闭时移除
+  std::map<std::string, std::shared_ptr<AsyncConverter>> _stages;
+  // 派生通道定义与已创建的派生通道，按输出 topic 索引，由 _sub_mutex 保护
+  std::map<std::string, ProjectionSpec> _projection_specs;
+  std::map<std::string, std::shared_ptr<Projection>> _projections;
+  // source topic -> <topic>/batch 的合并缓冲，由 _sub_mutex 保护，通道关闭时移除
+  std::map<std::string, std::shared_ptr<MessageBatch>> _batches;
+  std::unique_ptr<BatchFlusher> _batch_flusher;  // 发送到期的 batch 帧
+  std::map<std::string, std::unique_ptr<foxglove::ServiceHandler>> _service_handlers;
+  std::unique_ptr<McapRecorder> _recorder;  // 未开始录制时不打开文件
+  std::unique_ptr<RewindBuffer> _rewind;   // 未开启 rewind 时为空
+  std::mutex _rewind_mutex;
+  std::unique_ptr<RewindPlayer> _rewind_player;  // 由 _rewind_mutex 保护，未冻结时为空
+  std::string _host;  // 主服务地址与端口，回看服务使用
+  uint16_t _port = 0;
+  std::unique_ptr<LatchCache> _latch;       // 按 source topic 保存最近一条消息，总大小受 latch_max_mb 限制
+  std::shared_ptr<TfAggregator> _tf;  // 未开启 tf 时为空，由 ForwardHandle 共同持有
 };
@@ -0,0 +1,65 @@
+#pragma once
+#include <google/protobuf/message.h>
+
+#include <foxglove/schemas.hpp>
+#include <optional>
+#include <string>
+
+// 按字段名从 cyber 消息中取 frame_id 与时间戳，供转换为 foxglove schema 的阶段共用
+
+inline const google::protobuf::FieldDescriptor* findScalarField(
+  const google::protobuf::Message& msg, const char* name,
+  google::protobuf::FieldDescriptor::CppType type) {
+  const auto* field = msg.GetDescriptor()->FindFieldByName(name);
+  if (!field || field->is_repeated() || field->cpp_type() != type) {
+    return nullptr;
+  }
+  return field;
+}
+
+inline const google::protobuf::Message* findHeader(const google::protobuf::Message& msg) {
+  const auto* field =
+    findScalarField(msg, "header", google::protobuf::FieldDescriptor::CPPTYPE_MESSAGE);
+  return field ? &msg.GetReflection()->GetMessage(msg, field) : nullptr;
+}
+
+// frame_id 优先取消息本身的字段，其次取 header.frame_id
+inline std::string headerFrameId(const google::protobuf::Message& msg) {
+  for (const auto* candidate : {&msg, findHeader(msg)}) {
+    if (!candidate) {
+      continue;
+    }
+    if (const auto* field = findScalarField(
+          *candidate, "frame_id", google::protobuf::FieldDescriptor::CPPTYPE_STRING)) {
+      std::string frame_id = candidate->GetReflection()->GetString(*candidate, field);
+      if (!frame_id.empty()) {
+        return frame_id;
+      }
+    }
+  }
+  return "";
+}
+
+// 时间戳依次取 measurement_time 与 header.timestamp_sec（单位 s）
+inline std::optional<foxglove::schemas::Timestamp> headerTimestamp(
+  const google::protobuf::Message& msg) {
+  constexpr auto kDouble = google::protobuf::FieldDescriptor::CPPTYPE_DOUBLE;
+  double seconds = 0;
+  if (const auto* field = findScalarField(msg, "measurement_time", kDouble)) {
+    seconds = msg.GetReflection()->GetDouble(msg, field);
+  }
+  if (seconds <= 0) {
+    if (const auto* header = findHeader(msg)) {
+      if (const auto* field = findScalarField(*header, "timestamp_sec", kDouble)) {
+        seconds = header->GetReflection()->GetDouble(*header, field);
+      }
+    }
+  }
+  if (seconds <= 0) {
+    return std::nullopt;
+  }
+  foxglove::schemas::Timestamp timestamp;
+  timestamp.sec = static_cast<uint32_t>(seconds);
+  timestamp.nsec = static_cast<uint32_t>((seconds - timestamp.sec) * 1e9);
+  return timestamp;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// 图像 topic 的压缩选项，format 为空时不压缩
+struct ImageOptions {
+  std::string format;         // jpeg / png
+  int quality = 80;           // jpeg 质量 1-100，png 固定使用最快的压缩级别
+  uint32_t scale = 1;         // 宽高缩小的倍数，按 scale x scale 块取平均
+  double max_hz = 0;          // 压缩帧率上限，0 表示不限
+  uint32_t max_inflight = 2;  // 单个 topic 排队与压缩中的帧数上限，超出时跳过新帧
+
+  bool enabled() const {
+    return !format.empty();
+  }
+
+  static ImageOptions fromJson(const nlohmann::json& j, ImageOptions options) {
+    if (!j.is_object()) {
+      return options;
+    }
+    options.format = j.value("format", options.format);
+    options.quality = std::clamp(j.value("quality", options.quality), 1, 100);
+    options.scale = std::max(j.value("scale", options.scale), 1u);
+    options.max_hz = j.value("max_hz", options.max_hz);
+    options.max_inflight = std::max(j.value("max_inflight", options.max_inflight), 1u);
+    return options;
+  }
+};
+
+// 原始像素到 jpeg / png 的编码，支持 mono8/16、rgb8、bgr8、rgba8、bgra8、yuyv、uyvy
+class ImageEncoder {
+public:
+  struct Frame {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t step = 0;  // 每行字节数，0 表示按 encoding 紧密排列
+    std::string_view encoding;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+  };
+
+  // 编译时未找到 libjpeg 则只支持 png，请求 jpeg 时退回 png
+  static bool jpegSupported();
+
+  // 输出压缩数据与实际格式；输入不合法或 encoding 不支持时返回 false 并写入 error
+  static bool encode(const Frame& frame, const ImageOptions& options,
+    std::vector<std::byte>& output, std::string& format, std::string& error);
+};
@@ -0,0 +1,60 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "BridgeMetrics.hpp"
+#include "ImageEncoder.hpp"
+#include "MessageConverter.hpp"
+#include "ServiceExecutor.hpp"
+
+namespace google::protobuf {
+class Descriptor;
+}
+class TypeInfo;
+
+struct ImageStats {
+  std::string topic;
+  uint64_t encoded = 0;    // 已压缩并发送的帧数
+  uint64_t skipped = 0;    // 超出帧率或并发上限而跳过的帧数
+  uint64_t errors = 0;     // 解析或压缩失败的帧数
+  uint64_t bytes_in = 0;   // 原始像素字节数
+  uint64_t bytes_out = 0;  // 压缩后字节数
+  uint64_t last_encode_us = 0;
+};
+
+// 原始图像 topic 的压缩阶段：在线程池中把图像消息编码为 foxglove.CompressedImage，
+// 只在 /converted 通道有 sink 时由 ForwardHandle 调用；每帧编码耗时记录到 encode 延迟
+class ImageStage : public AsyncConverter, public std::enable_shared_from_this<ImageStage> {
+public:
+  ImageStage(std::string topic, std::shared_ptr<const TypeInfo> type, ImageOptions options,
+    ServiceExecutor* executor, std::shared_ptr<TopicMetrics> metrics);
+
+  // 是否为可压缩的图像消息：包含 width、height、encoding 与 data 字段
+  static bool isImageType(const google::protobuf::Descriptor* descriptor);
+
+  // 超出帧率或并发上限时跳过该帧，否则复制消息并投递到线程池
+  bool offer(const std::string& message, Deliver deliver) override;
+  ImageStats stats() const;
+  // 输出到 BridgeMetrics：<topic 变量名>_image_{encoded,skipped,errors,bytes_in,bytes_out,encode_us}
+  void collect(BridgeMetrics::Values& values) const override;
+
+private:
+  void encode(const std::string& message, const Deliver& deliver);
+
+  const std::string _topic;
+  const std::shared_ptr<const TypeInfo> _type;
+  const ImageOptions _options;
+  const uint64_t _interval_ns;  // 由 max_hz 换算，0 表示不限
+  ServiceExecutor* _executor;
+  std::shared_ptr<TopicMetrics> _metrics;
+
+  std::atomic<uint64_t> _next_ns{0};
+  std::atomic<uint64_t> _encoded{0};
+  std::atomic<uint64_t> _skipped{0};
+  std::atomic<uint64_t> _errors{0};
+  std::atomic<uint64_t> _bytes_in{0};
+  std::atomic<uint64_t> _bytes_out{0};
+  std::atomic<uint64_t> _last_encode_us{0};
+};
@@ -0,0 +1,107 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "BridgeMetrics.hpp"
+
+// 所有 latch slot 共用的内存上限
+struct LatchBudget {
+  const size_t limit;
+  std::atomic<size_t> bytes{0};
+  std::atomic<uint64_t> rejected{0};  // 超出上限未能保存的消息数
+  std::atomic<uint64_t> sent{0};      // 补发给新订阅者的消息数
+
+  explicit LatchBudget(size_t limit_bytes)
+      : limit(limit_bytes) {}
+};
+
+// 单个 topic 最近一条消息，由 ForwardHandle 在转发时写入、订阅回调中读取
+// store 只在该 topic 的分发线程中调用，load 可在任意线程调用
+class LatchSlot {
+public:
+  explicit LatchSlot(std::shared_ptr<LatchBudget> budget)
+      : _budget(std::move(budget)) {}
+
+  ~LatchSlot() {
+    clear();
+  }
+
+  // 按新旧消息的大小差额记账，超出上限时清空本 slot，不向新订阅者发送过期数据
+  void store(const std::string& message) {
+    auto old = std::atomic_load(&_data);
+    size_t old_size = old ? old->size() : 0;
+    if (message.size() > old_size) {
+      size_t extra = message.size() - old_size;
+      if (_budget->bytes.fetch_add(extra, std::memory_order_relaxed) + extra > _budget->limit) {
+        _budget->bytes.fetch_sub(extra, std::memory_order_relaxed);
+        _budget->rejected.fetch_add(1, std::memory_order_relaxed);
+        clear();
+        return;
+      }
+    } else {
+      _budget->bytes.fetch_sub(old_size - message.size(), std::memory_order_relaxed);
+    }
+    std::atomic_store(&_data, std::make_shared<const std::string>(message));
+  }
+
+  std::shared_ptr<const std::string> load() const {
+    return std::atomic_load(&_data);
+  }
+
+  void clear() {
+    if (auto old = std::atomic_exchange(&_data, std::shared_ptr<const std::string>())) {
+      _budget->bytes.fetch_sub(old->size(), std::memory_order_relaxed);
+    }
+  }
+
+  void onSent() {
+    _budget->sent.fetch_add(1, std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<LatchBudget> _budget;
+  std::shared_ptr<const std::string> _data;
+};
+
+// 按 source topic 保存 latch slot，slot 与 ForwardHandle 分离，reader 重建后仍保留最近一条消息
+class LatchCache {
+public:
+  explicit LatchCache(size_t limit_bytes)
+      : _budget(std::make_shared<LatchBudget>(limit_bytes)) {}
+
+  std::shared_ptr<LatchSlot> slot(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& slot = _slots[topic];
+    if (!slot) {
+      slot = std::make_shared<LatchSlot>(_budget);
+    }
+    return slot;
+  }
+
+  // topic 消失时释放保存的消息
+  void erase(const std::string& topic) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (auto it = _slots.find(topic); it != _slots.end()) {
+      it->second->clear();
+      _slots.erase(it);
+    }
+  }
+
+  // 输出到 BridgeMetrics：fox_bridge_latch_{topics,bytes,rejected,sent}
+  void collect(BridgeMetrics::Values& values) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    values["fox_bridge_latch_topics"] = _slots.size();
+    values["fox_bridge_latch_bytes"] = _budget->bytes.load(std::memory_order_relaxed);
+    values["fox_bridge_latch_rejected"] = _budget->rejected.load(std::memory_order_relaxed);
+    values["fox_bridge_latch_sent"] = _budget->sent.load(std::memory_order_relaxed);
+  }
+
+private:
+  std::shared_ptr<LatchBudget> _budget;
+  mutable std::mutex _mutex;
+  std::map<std::string, std::shared_ptr<LatchSlot>> _slots;
+};
@@ -0,0 +1,140 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// 无锁延迟直方图（单位 us），对数-线性分桶，相对误差约 1/8
+// 每个线程写入各自的分片，读取时合并；collect() 取走当前窗口的数据并清零
+class LatencyRecorder {
+public:
+  static constexpr uint32_t kSubBits = 3;
+  static constexpr uint32_t kSubCount = 1u << kSubBits;
+  static constexpr uint32_t kMaxBit = 31;  // 超过 2^32 us 的值计入最后一个桶
+  static constexpr uint32_t kBucketCount = (kMaxBit - kSubBits + 2) * kSubCount;
+
+  struct Snapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::array<uint64_t, kBucketCount> buckets{};
+
+    uint64_t average() const {
+      return count ? sum / count : 0;
+    }
+
+    // ratio 取 0.8 / 0.99 等，返回所在桶的中值
+    uint64_t percentile(double ratio) const {
+      if (count == 0) {
+        return 0;
+      }
+      uint64_t rank = static_cast<uint64_t>(ratio * count);
+      if (rank >= count) {
+        rank = count - 1;
+      }
+      uint64_t seen = 0;
+      for (uint32_t i = 0; i < kBucketCount; ++i) {
+        seen += buckets[i];
+        if (seen > rank) {
+          return std::min(bucketMid(i), max);
+        }
+      }
+      return max;
+    }
+  };
+
+  LatencyRecorder() = default;
+  ~LatencyRecorder() {
+    for (auto& shard : _shards) {
+      delete shard.load();
+    }
+  }
+  LatencyRecorder(const LatencyRecorder&) = delete;
+  LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+  void record(uint64_t us) {
+    Shard& shard = localShard();
+    shard.buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(us, std::memory_order_relaxed);
+    uint64_t max = shard.max.load(std::memory_order_relaxed);
+    while (us > max && !shard.max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+    _total.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // 取走上次 collect 之后的数据
+  Snapshot collect() {
+    Snapshot snapshot;
+    for (auto& slot : _shards) {
+      Shard* shard = slot.load(std::memory_order_acquire);
+      if (!shard) {
+        continue;
+      }
+      for (uint32_t i = 0; i < kBucketCount; ++i) {
+        snapshot.buckets[i] += shard->buckets[i].exchange(0, std::memory_order_relaxed);
+      }
+      snapshot.count += shard->count.exchange(0, std::memory_order_relaxed);
+      snapshot.sum += shard->sum.exchange(0, std::memory_order_relaxed);
+      snapshot.max = std::max(snapshot.max, shard->max.exchange(0, std::memory_order_relaxed));
+    }
+    return snapshot;
+  }
+
+  // 累计记录次数
+  uint64_t total() const {
+    return _total.load(std::memory_order_relaxed);
+  }
+
+  static uint32_t bucketIndex(uint64_t value) {
+    if (value < kSubCount) {
+      return static_cast<uint32_t>(value);
+    }
+    uint32_t bit = 63 - static_cast<uint32_t>(__builtin_clzll(value));
+    if (bit > kMaxBit) {
+      return kBucketCount - 1;
+    }
+    uint32_t shift = bit - kSubBits;
+    uint32_t sub = static_cast<uint32_t>(value >> shift) & (kSubCount - 1);
+    return (shift + 1) * kSubCount + sub;
+  }
+
+  static uint64_t bucketMid(uint32_t index) {
+    if (index < kSubCount) {
+      return index;
+    }
+    uint32_t shift = index / kSubCount - 1;
+    uint64_t low = static_cast<uint64_t>(kSubCount + index % kSubCount) << shift;
+    return low + ((1ull << shift) >> 1);
+  }
+
+private:
+  static constexpr uint32_t kShardCount = 8;
+
+  struct alignas(64) Shard {
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets{};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum{0};
+    std::atomic<uint64_t> max{0};
+  };
+
+  // 线程按首次使用顺序分配到固定分片，分片在第一次写入时创建
+  Shard& localShard() {
+    static std::atomic<uint32_t> next_slot{0};
+    thread_local uint32_t slot = next_slot.fetch_add(1, std::memory_order_relaxed) % kShardCount;
+    Shard* shard = _shards[slot].load(std::memory_order_acquire);
+    if (shard) {
+      return *shard;
+    }
+    auto fresh = std::make_unique<Shard>();
+    if (_shards[slot].compare_exchange_strong(shard, fresh.get(), std::memory_order_acq_rel)) {
+      return *fresh.release();
+    }
+    return *shard;
+  }
+
+  std::array<std::atomic<Shard*>, kShardCount> _shards{};
+  std::atomic<uint64_t> _total{0};
+};
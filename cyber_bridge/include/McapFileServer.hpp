@@ -0,0 +1,79 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <foxglove/channel.hpp>
+#include <foxglove/context.hpp>
+#include <foxglove/server.hpp>
+#include <mcap/reader.hpp>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+#include "PlaybackClock.hpp"
+
+struct McapServeOptions {
+  uint32_t lookahead_ms = 2000;  // 解码领先回放时间的上限
+  uint64_t lookahead_mb = 64;    // 已解码未发送的消息大小上限
+  uint32_t backfill_ms = 2000;   // 拖动后补发目标时刻之前这段时间内各通道的最后一条消息
+
+  static McapServeOptions fromJson(const nlohmann::json& j);
+};
+
+// MCAP 文件回放：不经过 cyber，直接用 mcap reader 读取文件，按文件中的 channel 与 schema 建立通道，
+// 开启 RangedPlayback 与 Time，客户端用播放条暂停、拖动与倍速回放
+// 解码线程按 log time 读取并领先回放时间不超过 lookahead，拖动时按 chunk index 从目标时刻重新读取
+class McapFileServer {
+public:
+  McapFileServer(std::string path, McapServeOptions options);
+  ~McapFileServer();
+
+  bool start(const std::string& host, uint16_t port);
+  void stop();
+
+private:
+  struct Pending {
+    uint64_t time_ns;
+    foxglove::RawChannel* channel;
+    std::string data;
+  };
+
+  bool open();
+  bool createChannels();
+  foxglove::PlaybackState onControl(const foxglove::PlaybackControlRequest& request);
+  // 解码线程：从 _decode_from 读到文件末尾，拖动后从新的位置重新读取
+  void decode();
+  // 读取过程中发生拖动或停止时返回 false
+  bool decodeFrom(uint64_t generation, uint64_t from);
+  // 播放线程：按回放时间发送已解码的消息
+  void play();
+  // 以下调用方持有 _mutex
+  bool fullLocked() const;
+  void clearLocked();
+  static void logPending(const Pending& message);
+
+  const std::string _path;
+  const McapServeOptions _options;
+  mcap::McapReader _reader;  // 只在解码线程中读取
+  bool _indexed = false;     // 文件有 chunk index 与 message index，可按时间顺序读取并直接跳转
+  foxglove::Context _context;
+  std::unordered_map<mcap::ChannelId, std::unique_ptr<foxglove::RawChannel>> _channels;
+  std::unique_ptr<foxglove::WebSocketServer> _server;
+
+  std::mutex _mutex;
+  std::condition_variable _decode_cv;  // 解码线程等待队列有空间或拖动
+  std::condition_variable _play_cv;    // 播放线程等待开始播放
+  std::thread _decode_thread;
+  std::thread _play_thread;
+  bool _running = false;
+  std::optional<PlaybackClock> _clock;
+  uint64_t _generation = 0;   // 每次拖动加一，解码线程据此丢弃旧位置的读取
+  uint64_t _decode_from = 0;  // 解码线程的起始 log time
+  bool _decoded_all = false;  // 当前 generation 已读到文件末尾
+  std::deque<Pending> _pending;
+  size_t _pending_bytes = 0;
+};
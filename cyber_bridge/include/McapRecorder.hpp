@@ -0,0 +1,69 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <foxglove/mcap.hpp>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct RecordOptions {
+  bool enabled = false;             // 启动时即开始录制
+  std::string dir = "records";      // 文件目录
+  std::string prefix = "fox_bridge";  // 文件名前缀，文件名为 <prefix>_<时间>.mcap
+  uint64_t max_size_mb = 1024;      // 单个文件大小上限，0 表示不按大小切分
+  uint32_t max_duration_s = 600;    // 单个文件时长上限，0 表示不按时间切分
+  std::vector<std::string> topics = {"*"};  // 录制的 topic，支持通配
+  std::string compression = "zstd";        // zstd / lz4 / none
+
+  static RecordOptions fromJson(const nlohmann::json& j);
+};
+
+// 与 WebSocket 服务共用同一个 Context 的 MCAP 录制：每条消息只 log 一次，
+// 由 SDK 分发给客户端与录制文件；按 sink_channel_filter 选择 topic，按大小或时长切分文件
+// 每个 Context 写一个文件，多个 Context 的文件同时切换
+class McapRecorder {
+public:
+  using FileCallback = std::function<void(const std::string& path)>;
+
+  explicit McapRecorder(RecordOptions options);
+  ~McapRecorder();
+
+  // 默认 Context 在构造时加入；其他 Context 的文件名为 <prefix>_<name>_<时间>.mcap，在 start 前调用
+  void addContext(const std::string& name, const foxglove::Context& context);
+
+  bool start();
+  void stop();
+  bool recording();
+  std::vector<std::string> currentFiles();
+  RecordOptions options();
+
+  // 修改录制的 topic，录制中时立即切换到新文件
+  void setTopics(const std::vector<std::string>& topics);
+  // topic 是否在录制范围内
+  bool matches(const std::string& topic);
+  // 每次打开新文件时调用
+  void setFileCallback(FileCallback callback);
+
+private:
+  // 调用方持有 _mutex
+  bool openLocked();
+  std::string nextPath(const std::string& name) const;
+  void run();
+
+  std::mutex _mutex;
+  RecordOptions _options;
+  // name -> Context，默认 Context 的 name 为空
+  std::vector<std::pair<std::string, foxglove::Context>> _contexts;
+  std::vector<std::unique_ptr<foxglove::McapWriter>> _writers;  // 与 _contexts 一一对应
+  std::vector<std::string> _paths;
+  uint64_t _opened_ns = 0;
+  FileCallback _file_callback;
+
+  std::condition_variable _cv;
+  std::thread _thread;
+  bool _running = false;
+};
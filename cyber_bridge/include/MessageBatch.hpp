@@ -0,0 +1,98 @@
+#pragma once
+#include <google/protobuf/descriptor.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <foxglove/channel.hpp>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BridgeMetrics.hpp"
+
+// 所有 batch 共用的计数
+struct BatchTotals {
+  std::atomic<uint64_t> messages{0};  // 合并的消息数
+  std::atomic<uint64_t> frames{0};    // 发出的帧数
+};
+
+// 把一个 topic 的高频小消息按时间窗口合并为 <topic>/batch 上的一帧，减少 WebSocket 帧数
+// 帧的类型为 fox_bridge.batch.<源类型名>Batch：
+//   repeated <源类型> messages = 1; repeated fixed64 log_time = 2;
+// 原始字节直接拼接为 messages 字段，不重新序列化；schema 在运行时按源类型生成
+class MessageBatch {
+public:
+  // source 为源消息类型的描述符，source_fd_set 为其 FileDescriptorSet；失败时返回 nullptr 并写入 error
+  static std::shared_ptr<MessageBatch> create(const std::string& topic,
+    const google::protobuf::Descriptor* source, const std::string& source_fd_set,
+    uint32_t window_ms, std::shared_ptr<BatchTotals> totals, std::string& error);
+
+  // 输出消息全名，如 fox_bridge.batch.ImuBatch
+  const std::string& typeName() const {
+    return _type_name;
+  }
+  // 源类型的 FileDescriptorSet 加上输出消息
+  const std::string& fdSet() const {
+    return _fd_set;
+  }
+
+  // 在发布到 ForwardHandle 之前设置
+  void attach(std::shared_ptr<foxglove::RawChannel> channel) {
+    _channel = std::move(channel);
+  }
+  const std::shared_ptr<foxglove::RawChannel>& channel() const {
+    return _channel;
+  }
+
+  // 在源 topic 的分发线程中调用，窗口到期或帧超过上限时发送
+  void add(const std::string& message);
+  // 由 BatchFlusher 周期调用，发送窗口已到期的帧，源 topic 停止发布时不会滞留；now_ns 为 steady clock
+  void flushExpired(uint64_t now_ns);
+
+private:
+  MessageBatch(uint32_t window_ms, std::shared_ptr<BatchTotals> totals);
+  // 调用方持有 _mutex
+  void flushLocked();
+
+  const uint64_t _window_ns;
+  std::shared_ptr<BatchTotals> _totals;
+  std::string _type_name;
+  std::string _fd_set;
+  std::shared_ptr<foxglove::RawChannel> _channel;
+
+  std::mutex _mutex;
+  std::string _frame;             // 已编码的 messages 字段
+  std::vector<uint64_t> _times;   // 各消息的 log_time，发送时编码为 packed 字段
+  uint64_t _first_ns = 0;         // 帧内第一条消息的时间（steady clock）
+};
+
+// 周期发送到期的帧，并输出 fox_bridge_batch_{topics,messages,frames,saved_frames,saved_per_s}
+// 第一个 batch 加入时启动线程
+class BatchFlusher {
+public:
+  BatchFlusher();
+  ~BatchFlusher();
+
+  std::shared_ptr<BatchTotals> totals() const {
+    return _totals;
+  }
+  void add(const std::shared_ptr<MessageBatch>& batch);
+  void remove(const std::shared_ptr<MessageBatch>& batch);
+  void stop();
+  void collect(BridgeMetrics::Values& values);
+
+private:
+  void run();
+
+  std::shared_ptr<BatchTotals> _totals;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::vector<std::shared_ptr<MessageBatch>> _batches;
+  std::thread _thread;
+  bool _running = false;
+  uint64_t _last_saved = 0;    // 上次 collect 时的 saved_frames
+  uint64_t _last_collect = 0;  // steady clock
+};
@@ -3,18 +3,50 @@
 #include <google/protobuf/message.h>
 
 #include <any>
+#include <foxglove/error.hpp>
+#include <foxglove/schema.hpp>
+#include <foxglove/schemas.hpp>
 #include <functional>
+#include <iterator>
+#include <map>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <typeindex>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "ProtoArena.hpp"
 
 struct ConverterInfo {
-  std::function<void(const std::string&, std::string&)> converter;
-  std::string target_type;
-  std::string target_schema;
+  // parsed 可为空，此时由转换器在当前线程 arena 上解析 proto_str
+  std::function<bool(
+    const std::string& proto_str, const google::protobuf::Message* parsed, std::string& output)>
+    converter = {};
+  std::string target_type = {};  // 目标类型的 schema 由 TypeRegistry 按需生成
+  // foxglove::schemas 结构体转换器的 schema（SDK 内静态分配），设置时不再通过 TypeRegistry 查找
+  std::optional<foxglove::Schema> target_schema = std::nullopt;
+  // 目标为 FrameTransform / FrameTransforms 的结构体转换器同时提供，填充 tf 汇总使用的变换，
+  // 其他转换器为空；output 由调用方复用
+  std::function<bool(const std::string& proto_str, const google::protobuf::Message* parsed,
+    std::vector<foxglove::schemas::FrameTransform>& output)>
+    transforms = {};
+};
+
+// 按 topic 配置的转换阶段（如图像压缩、点云降采样），设置后代替 ConverterInfo 生成 /converted 数据
+// offer 在分发线程调用，转换可以在当前线程或其他线程完成后调用 deliver；返回 false 表示该帧被跳过
+class AsyncConverter {
+public:
+  using Deliver = std::function<void(const std::string& output)>;
+  virtual ~AsyncConverter() = default;
+  virtual bool offer(const std::string& message, Deliver deliver) = 0;
+  // 输出统计值，与 BridgeMetrics::Values 相同
+  virtual void collect(std::map<std::string, uint64_t>& values [[maybe_unused]]) const {}
 };
 
 class MessageConverter {
@@ -28,18 +60,79 @@ public:
   template<typename ProtoMsg, typename FoxgloveSchema>
   void registerConverter(std::function<void(const ProtoMsg&, std::string&)> converter) {
     const auto* descriptor = ProtoMsg::descriptor();
-    const auto* target_descriptor = FoxgloveSchema::descriptor();
 
-    type_registry_[descriptor->full_name()] = {
-      [converter](const std::string& proto_str, std::string& output) {
-        ProtoMsg msg;
-        if (!msg.ParseFromString(proto_str)) {
-          throw std::runtime_error("Failed to parse protobuf");
+    ConverterInfo info;
+    info.converter = [converter](const std::string& proto_str,
+                       const google::protobuf::Message* parsed, std::string& output) -> bool {
+      const ProtoMsg* msg = parseOrReuse<ProtoMsg>(proto_str, parsed);
+      if (!msg) {
+        return false;
+      }
+      output.clear();
+      converter(*msg, output);
+      return true;
+    };
+    info.target_type = FoxgloveSchema::descriptor()->full_name();
+    type_registry_[descriptor->full_name()] = std::move(info);
+  }
+
+  // 注册填充 foxglove::schemas 结构体的转换器：结构体由 SDK 直接编码到输出缓冲区，
+  // 不再构造 foxglove protobuf 消息与中间字符串
+  template<typename ProtoMsg, typename FoxgloveStruct>
+  void registerTypedConverter(std::function<void(const ProtoMsg&, FoxgloveStruct&)> converter) {
+    const auto* descriptor = ProtoMsg::descriptor();
+    foxglove::Schema schema = FoxgloveStruct::schema();
+    ConverterInfo info;
+    info.converter = [converter](const std::string& proto_str,
+                       const google::protobuf::Message* parsed, std::string& output) -> bool {
+      const ProtoMsg* msg = parseOrReuse<ProtoMsg>(proto_str, parsed);
+      if (!msg) {
+        return false;
+      }
+      // 每条消息从空结构体开始，转换函数未设置的字段不会沿用上一条消息的值
+      FoxgloveStruct value;
+      converter(*msg, value);
+      // output 为线程复用的缓冲区，容量不足时按 SDK 返回的长度扩容一次
+      size_t encoded_len = 0;
+      output.resize(output.capacity());
+      auto result =
+        value.encode(reinterpret_cast<uint8_t*>(output.data()), output.size(), &encoded_len);
+      if (result == foxglove::FoxgloveError::BufferTooShort) {
+        output.resize(encoded_len);
+        result =
+          value.encode(reinterpret_cast<uint8_t*>(output.data()), output.size(), &encoded_len);
+      }
+      if (result != foxglove::FoxgloveError::Ok) {
+        output.clear();
+        return false;
+      }
+      output.resize(encoded_len);
+      return true;
+    };
+    info.target_type = schema.name;
+    info.target_schema = schema;
+    if constexpr (std::is_same_v<FoxgloveStruct, foxglove::schemas::FrameTransform> ||
+                  std::is_same_v<FoxgloveStruct, foxglove::schemas::FrameTransforms>) {
+      info.transforms =
+        [converter](const std::string& proto_str, const google::protobuf::Message* parsed,
+          std::vector<foxglove::schemas::FrameTransform>& output) -> bool {
+        const ProtoMsg* msg = parseOrReuse<ProtoMsg>(proto_str, parsed);
+        if (!msg) {
+          return false;
+        }
+        FoxgloveStruct value;
+        converter(*msg, value);
+        output.clear();
+        if constexpr (std::is_same_v<FoxgloveStruct, foxglove::schemas::FrameTransform>) {
+          output.push_back(std::move(value));
+        } else {
+          output.insert(output.end(), std::make_move_iterator(value.transforms.begin()),
+            std::make_move_iterator(value.transforms.end()));
         }
-        converter(msg, output);
-      },
-      target_descriptor->full_name(),
-      SerializeFdSet(target_descriptor)};
+        return true;
+      };
+    }
+    type_registry_[descriptor->full_name()] = std::move(info);
   }
 
   // 查询是否有转换器
@@ -47,61 +140,68 @@ public:
     return type_registry_.find(msg_type) != type_registry_.end();
   }
 
-  // 执行转换
-  void convert(
-    const std::string& proto_str, const std::string& msg_type, std::string& output) const {
+  // 返回注册项，未注册返回 nullptr；注册只发生在静态初始化阶段，指针长期有效
+  const ConverterInfo* find(const std::string& msg_type) const {
     auto it = type_registry_.find(msg_type);
-    if (it == type_registry_.end()) {
-      throw std::runtime_error("No converter registered for message type: " + msg_type);
-    }
-    it->second.converter(proto_str, output);
+    return it == type_registry_.end() ? nullptr : &it->second;
   }
 
-  // 获取目标类型的Descriptor string
-  std::string getTargetDescriptorString(const std::string& msg_type) const {
-    return type_registry_.at(msg_type).target_schema;
+  // 执行转换，output 由调用方复用；解析失败或未注册返回 false
+  bool convert(const std::string& proto_str, const google::protobuf::Message* parsed,
+    const std::string& msg_type, std::string& output) const {
+    auto it = type_registry_.find(msg_type);
+    if (it == type_registry_.end()) {
+      return false;
+    }
+    return it->second.converter(proto_str, parsed, output);
   }
 
   // 获取目标类型名称
-  std::string getTargetTypeName(const std::string& msg_type) const {
+  const std::string& getTargetTypeName(const std::string& msg_type) const {
     return type_registry_.at(msg_type).target_type;
   }
 
 private:
-  std::unordered_map<std::string, ConverterInfo> type_registry_;
-
-  using Descriptor = google::protobuf::Descriptor;
-  using FileDescriptorSet = google::protobuf::FileDescriptorSet;
-  using FileDescriptor = google::protobuf::FileDescriptor;
-
-  static std::string SerializeFdSet(const Descriptor* descriptor) {
-    google::protobuf::FileDescriptorSet fdSet;
-    std::queue<const FileDescriptor*> toAdd;
-    std::unordered_set<std::string> seenDependencies;
-    toAdd.push(descriptor->file());
-    seenDependencies.insert(descriptor->file()->name());
-    while (!toAdd.empty()) {
-      const FileDescriptor* next = toAdd.front();
-      toAdd.pop();
-      next->CopyTo(fdSet.add_file());
-      for (int i = 0; i < next->dependency_count(); ++i) {
-        const auto& dep = next->dependency(i);
-        if (seenDependencies.find(dep->name()) == seenDependencies.end()) {
-          seenDependencies.insert(dep->name());
-          toAdd.push(dep);
-        }
-      }
+  // 优先复用上游已解析的消息，否则在当前线程 arena 上解析，失败返回 nullptr
+  template<typename ProtoMsg>
+  static const ProtoMsg* parseOrReuse(
+    const std::string& proto_str, const google::protobuf::Message* parsed) {
+    const ProtoMsg* msg =
+      parsed ? google::protobuf::DynamicCastToGenerated<ProtoMsg>(parsed) : nullptr;
+    if (msg) {
+      return msg;
     }
-    return fdSet.SerializeAsString();
+    auto* fresh = google::protobuf::Arena::CreateMessage<ProtoMsg>(ProtoArena::local().arena());
+    return fresh->ParseFromString(proto_str) ? fresh : nullptr;
   }
+
+  std::unordered_map<std::string, ConverterInfo> type_registry_;
 };
 
+// FoxgloveType 为 foxglove::schemas 下的结构体名（如 FrameTransform），
+// ConverterFunc 签名为 void(const ProtoType&, foxglove::schemas::FoxgloveType&)
+#define REGISTER_TYPED_CONVERTER(ProtoType, FoxgloveType, ConverterFunc) \
+  namespace { \
+  const bool _registered_typed_##ProtoType##_##FoxgloveType = []() -> bool { \
+    MessageConverter::instance() \
+      .registerTypedConverter<ProtoType, foxglove::schemas::FoxgloveType>(ConverterFunc); \
+    return true; \
+  }(); \
+  }
+
+// ConverterFunc 签名为 void(const ProtoType&, std::string&)；
+// 旧的 void(const std::string&, std::string&) 仍兼容，但会多一次序列化和解析
 #define REGISTER_MESSAGE_CONVERTER(ProtoType, FoxgloveType, ConverterFunc) \
   namespace { \
   const bool _registered_##ProtoType##_##FoxgloveType = []() -> bool { \
     MessageConverter::instance().registerConverter<ProtoType, FoxgloveType>( \
-      [](const ProtoType& msg, std::string& output) { \
-        ConverterFunc(msg.SerializeAsString(), output); \
+      [](const auto& msg, std::string& output) { \
+        if constexpr (std::is_invocable_v<decltype(ConverterFunc)&, const ProtoType&, \
+                        std::string&>) { \
+          ConverterFunc(msg, output); \
+        } else { \
+          ConverterFunc(msg.SerializeAsString(), output); \
+        } \
       }); \
     return true; \
   }(); \
@@ -0,0 +1,90 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <foxglove/server.hpp>
+#include <optional>
+#include <string>
+
+// RangedPlayback 的回放时钟：按播放控制请求维护状态、倍速与回放时间，回看与文件回放共用
+// 不加锁，由调用方保护
+class PlaybackClock {
+public:
+  PlaybackClock(uint64_t begin_ns, uint64_t end_ns)
+      : _begin(begin_ns)
+      , _end(end_ns)
+      , _position(begin_ns) {}
+
+  uint64_t begin() const {
+    return _begin;
+  }
+  uint64_t end() const {
+    return _end;
+  }
+  foxglove::PlaybackStatus status() const {
+    return _status;
+  }
+  bool playing() const {
+    return _status == foxglove::PlaybackStatus::Playing;
+  }
+
+  // 当前回放时间，播放时按经过的墙钟时间与倍速推进
+  uint64_t current() const {
+    if (!playing()) {
+      return _position;
+    }
+    auto elapsed = static_cast<double>(steadyNs() - _wall_base) * _speed;
+    return std::min(_position + static_cast<uint64_t>(elapsed), _end);
+  }
+
+  // 处理播放控制请求，发生拖动时返回拖动到的回放时间
+  // 播放结束后再次播放视为拖动到开头
+  std::optional<uint64_t> apply(const foxglove::PlaybackControlRequest& request) {
+    _position = current();
+    std::optional<uint64_t> seek;
+    if (request.seek_time) {
+      _position = std::clamp(*request.seek_time, _begin, _end);
+      seek = _position;
+    }
+    if (request.playback_speed > 0) {
+      _speed = request.playback_speed;
+    }
+    if (request.playback_command == foxglove::PlaybackCommand::Play) {
+      if (_status == foxglove::PlaybackStatus::Ended && !seek) {
+        _position = _begin;
+        seek = _position;
+      }
+      _status = foxglove::PlaybackStatus::Playing;
+    } else {
+      _status = foxglove::PlaybackStatus::Paused;
+    }
+    _wall_base = steadyNs();
+    return seek;
+  }
+
+  // 所有消息已发送
+  void finish() {
+    _position = _end;
+    _status = foxglove::PlaybackStatus::Ended;
+  }
+
+  // 回复播放控制请求时带上 request_id
+  foxglove::PlaybackState state(
+    bool did_seek, std::optional<std::string> request_id = std::nullopt) const {
+    return {_status, current(), _speed, did_seek, std::move(request_id)};
+  }
+
+private:
+  static uint64_t steadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  const uint64_t _begin;
+  const uint64_t _end;
+  foxglove::PlaybackStatus _status = foxglove::PlaybackStatus::Paused;
+  float _speed = 1.0f;
+  uint64_t _position;       // 暂停时的回放时间；播放时为 _wall_base 对应的回放时间
+  uint64_t _wall_base = 0;  // steady clock
+};
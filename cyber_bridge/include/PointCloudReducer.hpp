@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 点云降采样选项，文本格式：voxel=0.1,range=1:80,roi=x0:x1:y0:y1:z0:z1,intensity=1 / off
+// 各项可省略，voxel 为 0 表示不做体素降采样，range 上限为 0 表示不限
+struct CloudOptions {
+  bool enabled = false;
+  float voxel = 0;      // 体素边长（m），同一体素内的点取平均
+  float min_range = 0;  // 到原点的距离范围（m）
+  float max_range = 0;
+  bool roi = false;  // 是否按轴对齐包围盒裁剪
+  float roi_min[3] = {0, 0, 0};
+  float roi_max[3] = {0, 0, 0};
+  bool intensity = true;  // 输出是否保留 intensity，否则只有 x/y/z
+
+  static bool parse(const std::string& spec, CloudOptions& options);
+  std::string toString() const;
+
+  // 输出每个点的字节数
+  uint32_t stride() const {
+    return intensity ? 16 : 12;
+  }
+};
+
+// 按列存放的输入点，intensity 可为空
+struct CloudView {
+  const float* x = nullptr;
+  const float* y = nullptr;
+  const float* z = nullptr;
+  const float* intensity = nullptr;
+  size_t size = 0;
+};
+
+// 裁剪 + 体素降采样，输出紧密排列的 float32（x y z [intensity]）
+// Vector 路径用编译器向量扩展一次判断 4 个点的裁剪条件与体素坐标，Scalar 路径逐点计算，结果一致
+class PointCloudReducer {
+public:
+  enum class Path : uint8_t { Scalar, Vector };
+
+  // 返回输出点数，output 被覆盖为 点数 * stride 字节；调用方复用 output 以避免重复分配
+  static size_t reduce(const CloudView& input, const CloudOptions& options,
+    std::vector<std::byte>& output, Path path = Path::Vector);
+};
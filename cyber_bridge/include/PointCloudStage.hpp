@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "BridgeMetrics.hpp"
+#include "MessageConverter.hpp"
+#include "PointCloudReducer.hpp"
+
+namespace google::protobuf {
+class Descriptor;
+}
+class TypeInfo;
+
+struct CloudStats {
+  std::string topic;
+  std::string options;
+  uint64_t frames = 0;      // 已降采样并发送的帧数
+  uint64_t errors = 0;      // 解析或序列化失败的帧数
+  uint64_t points_in = 0;   // 输入点数
+  uint64_t points_out = 0;  // 输出点数
+  uint64_t last_reduce_us = 0;
+};
+
+// 点云 topic 的降采样阶段：解码 repeated point（x/y/z/intensity）后裁剪、体素降采样，
+// 输出 float32 紧密排列的 foxglove.PointCloud；在分发线程中同步完成，耗时记录到 encode 延迟
+// 解码直接读取 point 字段的 wire 格式，不为每个点创建子消息；其他字段单独解析以取得 frame_id 与时间戳
+class PointCloudStage : public AsyncConverter {
+public:
+  PointCloudStage(std::string topic, std::shared_ptr<const TypeInfo> type, CloudOptions options,
+    std::shared_ptr<TopicMetrics> metrics);
+
+  // 是否为可降采样的点云消息：包含 repeated point 字段，子消息有数值类型的 x、y、z
+  static bool isCloudType(const google::protobuf::Descriptor* descriptor);
+
+  bool offer(const std::string& message, Deliver deliver) override;
+
+  // 运行时修改选项，下一帧生效；enabled 为 false 时输出原始点（只做字段精简）
+  void setOptions(const CloudOptions& options);
+  CloudOptions options() const;
+  const std::string& topic() const {
+    return _topic;
+  }
+
+  CloudStats stats() const;
+  // 输出到 BridgeMetrics：<topic 变量名>_cloud_{frames,errors,points_in,points_out,reduce_us}
+  void collect(BridgeMetrics::Values& values) const override;
+
+private:
+  struct Column {
+    int number = 0;  // point 子消息中的字段号，0 表示不存在
+    int type = 0;    // google::protobuf::FieldDescriptor::Type
+    float default_value = 0;
+  };
+
+  bool decode(const std::string& message, std::string& rest);
+
+  const std::string _topic;
+  const std::shared_ptr<const TypeInfo> _type;
+  std::shared_ptr<TopicMetrics> _metrics;
+  int _point_field = 0;
+  Column _columns[4];  // x y z intensity
+  std::shared_ptr<const CloudOptions> _options;
+
+  std::atomic<uint64_t> _frames{0};
+  std::atomic<uint64_t> _errors{0};
+  std::atomic<uint64_t> _points_in{0};
+  std::atomic<uint64_t> _points_out{0};
+  std::atomic<uint64_t> _last_reduce_us{0};
+};
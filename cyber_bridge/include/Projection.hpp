@@ -0,0 +1,102 @@
+#pragma once
+#include <google/protobuf/message.h>
+
+#include <atomic>
+#include <cstdint>
+#include <foxglove/channel.hpp>
+#include <memory>
+#include <optional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+// 派生通道定义，文本格式：<source>:<item>,<item>,...
+// item 为字段路径（如 chassis.speed_mps、obstacle[0].position.x），或 name=表达式，
+// 表达式支持数字、字段路径、+ - * / ( ) 与 abs()、sqrt()
+struct ProjectionSpec {
+  std::string topic;   // 输出通道名
+  std::string source;  // 源 cyber topic
+  std::vector<std::string> items;
+
+  static bool parse(const std::string& topic, const std::string& text, ProjectionSpec& spec);
+  // 配置文件中的 {"topic", "source", "fields": [...]}
+  static bool fromJson(const nlohmann::json& j, ProjectionSpec& spec);
+  std::string toString() const;
+};
+
+// 编译后的派生通道：字段路径解析为 FieldDescriptor 链，表达式编译为后缀指令，只在创建时查找一次描述符
+// 输出消息只包含 double 字段（proto3，字段号按 item 顺序），schema 在运行时生成
+class Projection {
+public:
+  // prototype 为源消息类型的原型；字段不存在、不是数值或表达式非法时返回 nullptr 并写入 error
+  static std::shared_ptr<Projection> compile(const ProjectionSpec& spec,
+    std::shared_ptr<const google::protobuf::Message> prototype, std::string& error);
+
+  const ProjectionSpec& spec() const {
+    return _spec;
+  }
+  // 输出消息全名，如 fox_bridge.projection.PlotChassis
+  const std::string& typeName() const {
+    return _type_name;
+  }
+  // 输出消息的 FileDescriptorSet
+  const std::string& fdSet() const {
+    return _fd_set;
+  }
+  const std::vector<std::string>& outputs() const {
+    return _outputs;
+  }
+
+  // 在发布到 ForwardHandle 之前设置
+  void attach(std::shared_ptr<foxglove::RawChannel> channel) {
+    _channel = std::move(channel);
+  }
+  const std::shared_ptr<foxglove::RawChannel>& channel() const {
+    return _channel;
+  }
+
+  // 通道有 sink 时计算并 log 给所有 sink（或只给 sink_id）；parsed 为空时在线程 arena 上解析并回写，
+  // 供后续转换复用
+  bool forward(const std::string& message, const google::protobuf::Message*& parsed,
+    std::optional<uint64_t> sink_id = std::nullopt);
+
+  // 计算所有输出并序列化到 output
+  void project(const google::protobuf::Message& msg, std::string& output) const;
+
+  uint64_t count() const {
+    return _count.load(std::memory_order_relaxed);
+  }
+  uint64_t errors() const {
+    return _errors.load(std::memory_order_relaxed);
+  }
+
+private:
+  struct Step {
+    const google::protobuf::FieldDescriptor* field;
+    int index;  // repeated 字段的下标，单值字段为 -1
+  };
+  struct Op {
+    enum Kind : uint8_t { Const, Load, Add, Sub, Mul, Div, Neg, Abs, Sqrt };
+    Kind kind;
+    double value;   // Const
+    uint32_t slot;  // Load：_paths 的下标
+  };
+  class Parser;
+
+  // 解析字段路径并去重，返回 _paths 的下标，失败返回 -1
+  int resolve(const std::string& path, std::string& error);
+  double load(const google::protobuf::Message& msg, const std::vector<Step>& path) const;
+
+  ProjectionSpec _spec;
+  std::shared_ptr<const google::protobuf::Message> _prototype;
+  std::string _type_name;
+  std::string _fd_set;
+  std::vector<std::string> _outputs;
+  std::vector<std::string> _path_names;
+  std::vector<std::vector<Step>> _paths;  // 去重后的字段路径，与 _path_names 一一对应
+  std::vector<std::vector<Op>> _programs;  // 每个输出一段后缀指令
+  size_t _max_stack = 0;
+  std::shared_ptr<foxglove::RawChannel> _channel;
+  std::atomic<uint64_t> _count{0};
+  std::atomic<uint64_t> _errors{0};
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <google/protobuf/arena.h>
+
+#include <memory>
+#include <string>
+
+// 每个分发线程独享的 protobuf Arena 及输出缓冲区
+// 分发线程在处理每条消息前调用 reset()，同一条消息的解析结果在 raw 与 /converted 通道间共享
+class ProtoArena {
+public:
+  static ProtoArena& local() {
+    thread_local ProtoArena inst;
+    return inst;
+  }
+
+  google::protobuf::Arena* arena() {
+    return &_arena;
+  }
+
+  // 释放上一条消息占用的内存，首块内存保留复用
+  void reset() {
+    _arena.Reset();
+  }
+
+  // 非透传模式下重新序列化的 raw 消息
+  std::string& rawBuffer() {
+    return _raw;
+  }
+
+  // 转换器输出
+  std::string& convertedBuffer() {
+    return _converted;
+  }
+
+  ProtoArena(const ProtoArena&) = delete;
+  ProtoArena& operator=(const ProtoArena&) = delete;
+
+private:
+  static constexpr size_t kInitialBlockSize = 256 * 1024;
+
+  ProtoArena()
+      : _block(new char[kInitialBlockSize])
+      , _arena(makeOptions(_block.get())) {}
+
+  static google::protobuf::ArenaOptions makeOptions(char* block) {
+    google::protobuf::ArenaOptions options;
+    options.initial_block = block;
+    options.initial_block_size = kInitialBlockSize;
+    return options;
+  }
+
+  std::unique_ptr<char[]> _block;
+  google::protobuf::Arena _arena;
+  std::string _raw;
+  std::string _converted;
+};
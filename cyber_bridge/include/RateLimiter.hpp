@@ -0,0 +1,203 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+// 限频策略，文本格式：max_hz=10 / every_n=5 / window_ms=100 / off
+struct RatePolicy {
+  enum class Mode : uint8_t {
+    Off,     // 不限频
+    MaxHz,   // 最大频率，超出的消息直接丢弃
+    EveryN,  // 每 N 条转发一条
+    Window,  // 每个时间窗口只转发窗口内最新的一条
+  };
+  Mode mode = Mode::Off;
+  double value = 0;
+
+  static bool parse(const std::string& spec, RatePolicy& policy) {
+    if (spec.empty() || spec == "off") {
+      policy = RatePolicy();
+      return true;
+    }
+    auto pos = spec.find('=');
+    if (pos == std::string::npos) {
+      return false;
+    }
+    std::string key = spec.substr(0, pos);
+    double value = 0;
+    try {
+      value = std::stod(spec.substr(pos + 1));
+    } catch (...) {
+      return false;
+    }
+    if (value <= 0) {
+      return false;
+    }
+    if (key == "max_hz") {
+      policy.mode = Mode::MaxHz;
+    } else if (key == "every_n") {
+      policy.mode = Mode::EveryN;
+    } else if (key == "window_ms") {
+      policy.mode = Mode::Window;
+    } else {
+      return false;
+    }
+    policy.value = value;
+    return true;
+  }
+
+  std::string toString() const {
+    switch (mode) {
+      case Mode::MaxHz:
+        return "max_hz=" + format(value);
+      case Mode::EveryN:
+        return "every_n=" + format(value);
+      case Mode::Window:
+        return "window_ms=" + format(value);
+      default:
+        return "off";
+    }
+  }
+
+private:
+  static std::string format(double value) {
+    std::string str = std::to_string(value);
+    str.erase(str.find_last_not_of('0') + 1);
+    if (!str.empty() && str.back() == '.') {
+      str.pop_back();
+    }
+    return str;
+  }
+};
+
+struct RateStats {
+  std::string topic;
+  std::string policy;
+  uint64_t forwarded = 0;
+  uint64_t suppressed = 0;
+};
+
+// 单个 topic 的限频器，在入队（转换、log）之前调用
+// admit 由该 topic 的 reader 回调串行调用；setPolicy / takeDue 可在其他线程调用
+template<typename T>
+class RateLimiter {
+public:
+  explicit RateLimiter(const RatePolicy& policy = RatePolicy()) {
+    setPolicy(policy);
+  }
+
+  void setPolicy(const RatePolicy& policy) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _value.store(policy.value, std::memory_order_relaxed);
+    _mode.store(policy.mode, std::memory_order_release);
+    _count.store(0, std::memory_order_relaxed);
+    if (policy.mode != RatePolicy::Mode::Window && _pending) {
+      _pending = T();
+      _suppressed.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  RatePolicy policy() const {
+    RatePolicy policy;
+    policy.mode = _mode.load(std::memory_order_acquire);
+    policy.value = _value.load(std::memory_order_relaxed);
+    return policy;
+  }
+
+  // 返回 true 表示立即转发；window 模式下未到窗口边界的消息会暂存，由 takeDue 取出
+  bool admit(const T& msg, uint64_t now_ns) {
+    switch (_mode.load(std::memory_order_acquire)) {
+      case RatePolicy::Mode::MaxHz: {
+        uint64_t interval = static_cast<uint64_t>(1e9 / _value.load(std::memory_order_relaxed));
+        uint64_t last = _last_ns.load(std::memory_order_relaxed);
+        if (last != 0 && now_ns - last < interval) {
+          return suppress();
+        }
+        _last_ns.store(now_ns, std::memory_order_relaxed);
+        return forward();
+      }
+      case RatePolicy::Mode::EveryN: {
+        uint64_t n = static_cast<uint64_t>(_value.load(std::memory_order_relaxed));
+        if (n > 1 && _count.fetch_add(1, std::memory_order_relaxed) % n != 0) {
+          return suppress();
+        }
+        return forward();
+      }
+      case RatePolicy::Mode::Window: {
+        std::lock_guard<std::mutex> lock(_mutex);
+        uint64_t last = _last_ns.load(std::memory_order_relaxed);
+        if (last == 0 || now_ns - last >= windowNs()) {
+          if (_pending) {
+            _pending = T();
+            _suppressed.fetch_add(1, std::memory_order_relaxed);
+          }
+          _last_ns.store(now_ns, std::memory_order_relaxed);
+          return forward();
+        }
+        if (_pending) {
+          _suppressed.fetch_add(1, std::memory_order_relaxed);
+        }
+        _pending = msg;
+        return false;
+      }
+      default:
+        return forward();
+    }
+  }
+
+  // window 模式下取出已到期的暂存消息，没有则返回空
+  T takeDue(uint64_t now_ns) {
+    if (_mode.load(std::memory_order_acquire) != RatePolicy::Mode::Window) {
+      return T();
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_pending || now_ns - _last_ns.load(std::memory_order_relaxed) < windowNs()) {
+      return T();
+    }
+    _last_ns.store(now_ns, std::memory_order_relaxed);
+    _forwarded.fetch_add(1, std::memory_order_relaxed);
+    T msg = std::move(_pending);
+    _pending = T();
+    return msg;
+  }
+
+  RateStats stats() const {
+    RateStats stats;
+    stats.policy = policy().toString();
+    stats.forwarded = _forwarded.load(std::memory_order_relaxed);
+    stats.suppressed = _suppressed.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+private:
+  bool forward() {
+    _forwarded.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool suppress() {
+    _suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  uint64_t windowNs() const {
+    return static_cast<uint64_t>(_value.load(std::memory_order_relaxed) * 1e6);
+  }
+
+  std::atomic<RatePolicy::Mode> _mode{RatePolicy::Mode::Off};
+  std::atomic<double> _value{0};
+  std::atomic<uint64_t> _last_ns{0};
+  std::atomic<uint64_t> _count{0};
+  std::atomic<uint64_t> _forwarded{0};
+  std::atomic<uint64_t> _suppressed{0};
+  std::mutex _mutex;  // window 模式的暂存消息
+  T _pending;
+};
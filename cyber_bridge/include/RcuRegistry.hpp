@@ -0,0 +1,174 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// 按 topic 与 channel id 双索引的并发注册表
+// 读侧（消息转发热路径）无锁：进入时登记到当前 epoch 的计数器，读取不可变快照；
+// 写侧（发现、订阅管理）串行化，复制快照修改后原子替换，等待旧 epoch 的读者退出后释放旧快照
+template<typename V>
+class RcuRegistry {
+public:
+  struct Snapshot {
+    std::unordered_map<std::string, std::shared_ptr<V>> by_topic;
+    std::unordered_map<uint64_t, std::shared_ptr<V>> by_id;
+
+    V* find(const std::string& topic) const {
+      auto it = by_topic.find(topic);
+      return it == by_topic.end() ? nullptr : it->second.get();
+    }
+
+    V* findId(uint64_t id) const {
+      auto it = by_id.find(id);
+      return it == by_id.end() ? nullptr : it->second.get();
+    }
+  };
+
+  // 读侧临界区，快照及其中的指针只在 guard 生命周期内有效；guard 内不能调用写接口
+  class ReadGuard {
+  public:
+    explicit ReadGuard(const RcuRegistry& registry)
+        : _registry(registry) {
+      for (;;) {
+        uint32_t epoch = _registry._epoch.load();
+        _slot = epoch & 1;
+        _registry._readers[_slot].count.fetch_add(1);
+        // 登记后 epoch 未变，之后的写者一定会等待该计数器
+        if (_registry._epoch.load() == epoch) {
+          break;
+        }
+        _registry._readers[_slot].count.fetch_sub(1);
+      }
+      _snapshot = _registry._current.load();
+    }
+
+    ~ReadGuard() {
+      _registry._readers[_slot].count.fetch_sub(1, std::memory_order_release);
+    }
+
+    ReadGuard(const ReadGuard&) = delete;
+    ReadGuard& operator=(const ReadGuard&) = delete;
+
+    const Snapshot& operator*() const {
+      return *_snapshot;
+    }
+
+    const Snapshot* operator->() const {
+      return _snapshot;
+    }
+
+  private:
+    const RcuRegistry& _registry;
+    const Snapshot* _snapshot = nullptr;
+    uint32_t _slot = 0;
+  };
+
+  RcuRegistry()
+      : _current(new Snapshot()) {}
+
+  ~RcuRegistry() {
+    delete _current.load();
+  }
+
+  RcuRegistry(const RcuRegistry&) = delete;
+  RcuRegistry& operator=(const RcuRegistry&) = delete;
+
+  ReadGuard read() const {
+    return ReadGuard(*this);
+  }
+
+  // 以下为写接口，会等待进行中的读者，不能在 ReadGuard 内调用
+
+  // id 为 0 时只按 topic 索引；topic 已存在时替换
+  void insert(const std::string& topic, uint64_t id, std::shared_ptr<V> value) {
+    update([&](Snapshot& next) {
+      eraseFrom(next, topic);
+      if (id != 0) {
+        next.by_id[id] = value;
+      }
+      next.by_topic[topic] = std::move(value);
+    });
+  }
+
+  std::shared_ptr<V> erase(const std::string& topic) {
+    std::shared_ptr<V> erased;
+    update([&](Snapshot& next) {
+      erased = eraseFrom(next, topic);
+    });
+    return erased;
+  }
+
+  void clear() {
+    update([](Snapshot& next) {
+      next.by_topic.clear();
+      next.by_id.clear();
+    });
+  }
+
+  // 控制路径使用：返回的 shared_ptr 可在 guard 外持有
+  std::shared_ptr<V> get(const std::string& topic) const {
+    auto guard = read();
+    auto it = guard->by_topic.find(topic);
+    return it == guard->by_topic.end() ? nullptr : it->second;
+  }
+
+  std::shared_ptr<V> getId(uint64_t id) const {
+    auto guard = read();
+    auto it = guard->by_id.find(id);
+    return it == guard->by_id.end() ? nullptr : it->second;
+  }
+
+  bool contains(const std::string& topic) const {
+    auto guard = read();
+    return guard->by_topic.count(topic) != 0;
+  }
+
+private:
+  template<typename F>
+  void update(F&& modify) {
+    std::lock_guard<std::mutex> lock(_write_mutex);
+    auto next = std::make_unique<Snapshot>(*_current.load());
+    modify(*next);
+    const Snapshot* old = _current.exchange(next.release());
+    synchronize();
+    delete old;
+  }
+
+  // 切换 epoch 并等待旧 epoch 的读者全部退出
+  void synchronize() {
+    uint32_t epoch = _epoch.fetch_add(1);
+    const auto& readers = _readers[epoch & 1].count;
+    while (readers.load(std::memory_order_acquire) != 0) {
+      std::this_thread::yield();
+    }
+  }
+
+  static std::shared_ptr<V> eraseFrom(Snapshot& snapshot, const std::string& topic) {
+    auto it = snapshot.by_topic.find(topic);
+    if (it == snapshot.by_topic.end()) {
+      return nullptr;
+    }
+    auto value = std::move(it->second);
+    snapshot.by_topic.erase(it);
+    for (auto id_it = snapshot.by_id.begin(); id_it != snapshot.by_id.end(); ++id_it) {
+      if (id_it->second == value) {
+        snapshot.by_id.erase(id_it);
+        break;
+      }
+    }
+    return value;
+  }
+
+  struct alignas(64) ReaderCount {
+    std::atomic<uint64_t> count{0};
+  };
+
+  std::atomic<const Snapshot*> _current;
+  std::atomic<uint32_t> _epoch{0};
+  mutable ReaderCount _readers[2];
+  std::mutex _write_mutex;
+};
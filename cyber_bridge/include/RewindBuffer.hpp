@@ -0,0 +1,94 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <foxglove/channel.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+#include "BridgeMetrics.hpp"
+
+struct RewindOptions {
+  bool enabled = false;   // 是否缓存最近的消息
+  uint16_t port = 0;      // 回看服务端口，0 表示主服务端口 + 100
+  uint32_t window_s = 60;  // 每个 topic 保留的时长
+  uint64_t max_mb = 512;   // 所有 topic 的总大小上限
+  std::vector<std::string> topics = {"*"};  // 缓存的 topic，支持通配
+
+  static RewindOptions fromJson(const nlohmann::json& j);
+};
+
+// 冻结的回看窗口：各 topic 的 schema 与按时间排序的消息，消息数据与环形缓冲共享
+struct RewindSnapshot {
+  struct Channel {
+    std::string topic;
+    std::string encoding;
+    std::string schema_name;
+    std::string schema_encoding;
+    std::string schema_data;
+  };
+  struct Message {
+    uint64_t time_ns;  // bridge 收到的时间（system clock）
+    uint32_t channel;  // channels 的下标
+    std::shared_ptr<const std::string> data;
+  };
+  std::vector<Channel> channels;
+  std::vector<Message> messages;
+  uint64_t begin_ns = 0;
+  uint64_t end_ns = 0;
+  size_t bytes = 0;
+};
+
+class RewindBuffer;
+
+// 单个 topic 的消息环，按收到的时间排列，超出时长的消息在写入时丢弃
+class RewindTrack {
+public:
+  RewindTrack(RewindBuffer& owner, std::string topic, const foxglove::RawChannel& channel);
+
+  // 在该 topic 的分发线程中调用
+  void push(const std::string& message);
+
+private:
+  friend class RewindBuffer;
+
+  RewindBuffer& _owner;
+  RewindSnapshot::Channel _channel;
+  std::mutex _mutex;
+  std::deque<RewindSnapshot::Message> _entries;
+};
+
+// 按 topic 保存最近 window_s 的原始消息，总大小超过 max_mb 时淘汰全局最旧的消息
+// topic 消失后保留其缓存，直到超时或被淘汰，便于回看出问题前的数据
+class RewindBuffer {
+public:
+  explicit RewindBuffer(RewindOptions options);
+
+  const RewindOptions& options() const {
+    return _options;
+  }
+  bool matches(const std::string& topic) const;
+  // topic 的消息环，已存在时复用，reader 重建后历史仍在
+  std::shared_ptr<RewindTrack> track(const std::string& topic, const foxglove::RawChannel& channel);
+  // 冻结当前窗口内的消息
+  RewindSnapshot snapshot();
+  // 输出到 BridgeMetrics：fox_bridge_rewind_{topics,bytes,evicted}
+  void collect(BridgeMetrics::Values& values);
+
+private:
+  friend class RewindTrack;
+
+  void evict();
+
+  const RewindOptions _options;
+  const uint64_t _window_ns;
+  const size_t _limit;
+  std::atomic<size_t> _bytes{0};
+  std::atomic<uint64_t> _evicted{0};
+  std::mutex _mutex;  // 先于 RewindTrack::_mutex 加锁
+  std::map<std::string, std::shared_ptr<RewindTrack>> _tracks;
+};
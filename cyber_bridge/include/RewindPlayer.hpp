@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <foxglove/channel.hpp>
+#include <foxglove/context.hpp>
+#include <foxglove/server.hpp>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PlaybackClock.hpp"
+#include "RewindBuffer.hpp"
+
+// 回看服务：独立的 Context 与端口，按 RewindSnapshot 的时间范围开启 RangedPlayback，
+// 客户端通过播放控制暂停、拖动与倍速回放；消息按原始接收时间 log，实时转发不受影响
+class RewindPlayer {
+public:
+  explicit RewindPlayer(RewindSnapshot snapshot);
+  ~RewindPlayer();
+
+  bool start(const std::string& host, uint16_t port);
+  void stop();
+
+  uint16_t port() const {
+    return _port;
+  }
+  const RewindSnapshot& snapshot() const {
+    return _snapshot;
+  }
+
+private:
+  foxglove::PlaybackState onControl(const foxglove::PlaybackControlRequest& request);
+  // 以下调用方持有 _mutex
+  void logAt(size_t index);
+  // 拖动后补发各通道在该时刻之前的最后一条消息，暂停时面板也能显示该时刻的状态
+  void logLatestBefore(size_t cursor);
+  void run();
+
+  const RewindSnapshot _snapshot;
+  foxglove::Context _context;
+  std::vector<std::unique_ptr<foxglove::RawChannel>> _channels;  // 与 snapshot.channels 一一对应
+  std::unique_ptr<foxglove::WebSocketServer> _server;
+  uint16_t _port = 0;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::thread _thread;
+  bool _running = false;
+  PlaybackClock _clock;
+  size_t _cursor = 0;  // 下一条要发送的消息
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ServiceStats {
+  std::string service;
+  uint32_t inflight = 0;   // 排队与执行中的请求数
+  uint64_t completed = 0;  // 已执行完的请求数（含失败）
+  uint64_t rejected = 0;   // 超出并发上限被拒绝的请求数
+};
+
+// 服务调用线程池：WebSocket 回调线程只负责投递，阻塞的 cyber 调用在 worker 中完成
+// 每个服务一个队列，worker 按服务轮流取任务，单个服务同时执行的请求数不超过 max_running，
+// 慢服务只占用自己的份额，其他服务的请求不会排在它后面
+class ServiceExecutor {
+public:
+  // cancelled 为 true 表示执行器已停止，任务应直接回复错误
+  using Task = std::function<void(bool cancelled)>;
+
+  // max_running 为单个服务同时执行的任务数上限，0 表示不限
+  explicit ServiceExecutor(size_t threads, size_t max_running = 0);
+  ~ServiceExecutor();
+
+  // 该服务排队与执行中的请求数达到 max_inflight 时返回 false，task 不会被调用
+  bool submit(const std::string& service, uint32_t max_inflight, Task task);
+  // 停止 worker，尚未执行的任务以 cancelled = true 调用
+  void stop();
+  std::vector<ServiceStats> stats();
+
+private:
+  struct Queue {
+    std::deque<Task> tasks;
+    size_t running = 0;
+  };
+
+  void workerLoop();
+  // 从 _ready 中取下一个未达到 max_running 的服务，调用方持有 _mutex
+  bool takeLocked(std::string& service, Task& task);
+  void finish(const std::string& service);
+
+  const size_t _max_running;
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::map<std::string, Queue> _queues;
+  std::deque<std::string> _ready;  // 有排队任务的服务，按轮转顺序
+  std::map<std::string, ServiceStats> _stats;
+  bool _stopped = false;
+};
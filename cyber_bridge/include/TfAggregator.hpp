@@ -0,0 +1,91 @@
+#pragma once
+#include <google/protobuf/message.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <foxglove/channel.hpp>
+#include <foxglove/schemas.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BridgeMetrics.hpp"
+#include "MessageConverter.hpp"
+
+struct TfOptions {
+  bool enabled = false;
+  // 默认不使用 /tf 与 /tf_static，避免与 Apollo 中同名的 cyber channel 冲突
+  std::string topic = "/bridge/tf";                // 动态变换，按 hz 发送有变化的变换
+  std::string static_topic = "/bridge/tf_static";  // 静态变换，变化时发送一次，新订阅者补发
+  double hz = 10;
+  std::vector<std::string> static_topics;  // 按静态变换处理的源 topic，支持通配
+
+  static TfOptions fromJson(const nlohmann::json& j);
+};
+
+// 把注册了 FrameTransform / FrameTransforms 结构体转换器的 topic 汇总到 topic 与 static_topic，
+// 消息类型为 foxglove.FrameTransforms，客户端不必分别订阅各 topic 的 /converted
+// 按 child_frame_id 保存最新的变换，父节点、平移或旋转变化时才发送，只有时间戳变化的不重复发送
+class TfAggregator {
+public:
+  explicit TfAggregator(TfOptions options);
+  ~TfAggregator();
+
+  const TfOptions& options() const {
+    return _options;
+  }
+  bool isStaticSource(const std::string& topic) const;
+  // 是否为汇总通道的 topic 名，同名的 cyber topic 不再桥接
+  bool isOutput(const std::string& topic) const {
+    return topic == _options.topic || topic == _options.static_topic;
+  }
+  // 在默认 Context 上创建汇总通道，并启动发送线程
+  bool start();
+  void stop();
+  // 是否为汇总通道的 channel id
+  bool owns(uint64_t channel_id) const;
+
+  // 在源 topic 的分发线程中调用，按 converter 转换后更新变换，静态变换有变化时立即发送
+  void update(const std::string& topic, bool is_static, const ConverterInfo& converter,
+    const std::string& message, const google::protobuf::Message* parsed);
+  // 源 topic 消失时移除其变换
+  void erase(const std::string& topic);
+  // 客户端订阅汇总通道时只发给该客户端当前全部变换
+  void onSubscribe(uint64_t channel_id, uint64_t sink_id);
+  // 输出 fox_bridge_tf_{frames,static_frames,updates,sent,errors}
+  void collect(BridgeMetrics::Values& values);
+
+private:
+  struct Entry {
+    std::string topic;  // 来源 topic
+    foxglove::schemas::FrameTransform transform;
+    bool dirty = false;  // 上次发送后有变化
+  };
+  using Frames = std::map<std::string, Entry>;  // child_frame_id -> 变换
+
+  void run();
+  // 调用方持有 _mutex；dirty_only 时只取有变化的变换并清除标记
+  static void collectLocked(
+    Frames& frames, bool dirty_only, foxglove::schemas::FrameTransforms& output);
+  bool log(foxglove::RawChannel& channel, foxglove::schemas::FrameTransforms& transforms,
+    std::optional<uint64_t> sink_id = std::nullopt);
+
+  const TfOptions _options;
+  std::shared_ptr<foxglove::RawChannel> _channel;
+  std::shared_ptr<foxglove::RawChannel> _static_channel;
+
+  std::mutex _mutex;
+  std::condition_variable _cv;
+  std::thread _thread;
+  bool _running = false;
+  Frames _frames;
+  Frames _static_frames;
+  uint64_t _updates = 0;  // 有变化的变换数
+  uint64_t _sent = 0;     // 发送的 FrameTransforms 消息数
+  uint64_t _errors = 0;   // 转换或 log 失败数
+};
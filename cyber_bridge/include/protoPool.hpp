@@ -5,8 +5,13 @@
 #include <google/protobuf/util/json_util.h>
 #include <logger/log.h>
 
+#include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <queue>
+#include <unordered_map>
+
+#include "MessageConverter.hpp"
 
 using json = nlohmann::json;
 
@@ -33,15 +38,220 @@ inline static std::string SerializeFdSet(const google::protobuf::Descriptor* des
   }
   return fdSet.SerializeAsString();
 }
+
+// 获取 JSON Schema（通过 descriptor）
+inline static json buildJsonSchemaFromDescriptor(const google::protobuf::Descriptor* descriptor) {
+  if (!descriptor) {
+    return json{};
+  }
+
+  json schema;
+  schema["type"] = "object";
+  json properties = json::object();
+
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const google::protobuf::FieldDescriptor* field = descriptor->field(i);
+    json fieldSchema;
+
+    switch (field->type()) {
+      case google::protobuf::FieldDescriptor::TYPE_INT32:
+      case google::protobuf::FieldDescriptor::TYPE_INT64:
+      case google::protobuf::FieldDescriptor::TYPE_UINT32:
+      case google::protobuf::FieldDescriptor::TYPE_UINT64:
+      case google::protobuf::FieldDescriptor::TYPE_SINT32:
+      case google::protobuf::FieldDescriptor::TYPE_SINT64:
+      case google::protobuf::FieldDescriptor::TYPE_FIXED32:
+      case google::protobuf::FieldDescriptor::TYPE_FIXED64:
+      case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
+      case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
+        fieldSchema["type"] = "integer";
+        break;
+
+      case google::protobuf::FieldDescriptor::TYPE_FLOAT:
+      case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
+        fieldSchema["type"] = "number";
+        break;
+
+      case google::protobuf::FieldDescriptor::TYPE_BOOL:
+        fieldSchema["type"] = "boolean";
+        break;
+
+      case google::protobuf::FieldDescriptor::TYPE_STRING:
+      case google::protobuf::FieldDescriptor::TYPE_BYTES:
+        fieldSchema["type"] = "string";
+        break;
+
+      case google::protobuf::FieldDescriptor::TYPE_ENUM: {
+        fieldSchema["type"] = "string";
+        json enumValues = json::array();
+        const auto* enumDesc = field->enum_type();
+        for (int j = 0; j < enumDesc->value_count(); j++) {
+          enumValues.push_back(enumDesc->value(j)->name());
+        }
+        fieldSchema["enum"] = enumValues;
+        break;
+      }
+
+      case google::protobuf::FieldDescriptor::TYPE_MESSAGE: {
+        // 递归构建嵌套 message
+        fieldSchema = buildJsonSchemaFromDescriptor(field->message_type());
+        break;
+      }
+
+      default:
+        fieldSchema["type"] = "string";  // 兜底
+        break;
+    }
+
+    if (field->is_repeated()) {
+      json arrSchema;
+      arrSchema["type"] = "array";
+      arrSchema["items"] = fieldSchema;
+      properties[field->name()] = arrSchema;
+    } else {
+      properties[field->name()] = fieldSchema;
+    }
+  }
+  schema["properties"] = properties;
+  return schema;
+}
+
 // using namespace gwm::adcos;
 using namespace apollo;
 using MessageBase = cyber::message::RawMessage;
 
+// 单个消息类型的描述信息，进程内按类型共享；FdSet 与 JSON Schema 首次使用时生成
+class TypeInfo {
+public:
+  TypeInfo(const google::protobuf::Descriptor* descriptor,
+    std::unique_ptr<google::protobuf::Message> prototype)
+      : descriptor_(descriptor)
+      , prototype_(std::move(prototype)) {}
+
+  const std::string& name() const {
+    return descriptor_->full_name();
+  }
+
+  const google::protobuf::Descriptor* descriptor() const {
+    return descriptor_;
+  }
+
+  // 默认实例，通过 New() / New(arena) 创建消息
+  const google::protobuf::Message* prototype() const {
+    return prototype_.get();
+  }
+
+  const std::string& fdSet() const {
+    std::call_once(fd_set_once_, [this]() {
+      fd_set_ = SerializeFdSet(descriptor_);
+    });
+    return fd_set_;
+  }
+
+  const std::string& jsonSchema() const {
+    std::call_once(json_schema_once_, [this]() {
+      json_schema_ = buildJsonSchemaFromDescriptor(descriptor_).dump();
+    });
+    return json_schema_;
+  }
+
+private:
+  const google::protobuf::Descriptor* descriptor_;
+  std::unique_ptr<google::protobuf::Message> prototype_;
+  mutable std::once_flag fd_set_once_;
+  mutable std::string fd_set_;
+  mutable std::once_flag json_schema_once_;
+  mutable std::string json_schema_;
+};
+
+// 进程内的消息类型注册表，同类型的 topic 共享同一份 TypeInfo
+class TypeRegistry {
+public:
+  static TypeRegistry& instance() {
+    static TypeRegistry inst;
+    return inst;
+  }
+
+  // 查找失败返回 nullptr 且不缓存，proto 描述可能稍后才同步到 cyber
+  std::shared_ptr<const TypeInfo> get(const std::string& msg_type) {
+    if (msg_type.empty()) {
+      return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = types_.find(msg_type);
+    if (it != types_.end()) {
+      return it->second;
+    }
+    auto info = resolve(msg_type);
+    if (info) {
+      types_.emplace(msg_type, info);
+    }
+    return info;
+  }
+
+  // 转换器目标类型（/converted 通道的 schema），未注册转换器或为结构体转换器时返回 nullptr
+  std::shared_ptr<const TypeInfo> converterTarget(const std::string& msg_type) {
+    const auto* converter = MessageConverter::instance().find(msg_type);
+    if (!converter || converter->target_schema) {
+      return nullptr;
+    }
+    return get(MessageConverter::instance().getTargetTypeName(msg_type));
+  }
+
+private:
+  TypeRegistry() = default;
+
+  // 使用 Protobuf 原生机制查找消息描述符
+  static std::shared_ptr<const TypeInfo> resolve(const std::string& msg_type) {
+    // 先尝试使用 cyber 机制查找消息描述符
+    static const auto cyber_factory = cyber::message::ProtobufFactory::Instance();
+    const auto* descriptor = cyber_factory->FindMessageTypeByName(msg_type);
+    auto prototype =
+      std::unique_ptr<google::protobuf::Message>(cyber_factory->GenerateMessageByType(msg_type));
+    if (descriptor && prototype) {
+      return std::make_shared<TypeInfo>(descriptor, std::move(prototype));
+    }
+    // 如果 cyber 机制查找失败，则使用 Protobuf 原生机制查找消息描述符
+    static auto pool = google::protobuf::DescriptorPool::generated_pool();
+    descriptor = pool->FindMessageTypeByName(msg_type);
+    prototype = createMessageInstance(descriptor);
+    if (!descriptor || !prototype) {
+      LOG_WARN << "Failed to find descriptor for msg_type: " << msg_type;
+      return nullptr;
+    }
+    cyber_factory->RegisterMessage(*prototype);  // 注册消息描述符到 cyber
+    return std::make_shared<TypeInfo>(descriptor, std::move(prototype));
+  }
+
+  // 创建消息实例
+  static std::unique_ptr<google::protobuf::Message> createMessageInstance(
+    const google::protobuf::Descriptor* descriptor) {
+    if (!descriptor) {
+      return nullptr;
+    }
+    // 尝试使用静态工厂创建消息实例
+    static const auto factory = google::protobuf::MessageFactory::generated_factory();
+    const google::protobuf::Message* prototype = factory->GetPrototype(descriptor);
+    if (!prototype) {
+      // 尝试使用动态工厂创建消息实例
+      static const auto dynamic_factory =
+        std::make_unique<google::protobuf::DynamicMessageFactory>();
+      prototype = dynamic_factory->GetPrototype(descriptor);
+      if (!prototype) {
+        return nullptr;
+      }
+    }
+    return std::unique_ptr<google::protobuf::Message>(prototype->New());
+  }
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const TypeInfo>> types_;
+};
+
+// 单个 topic 的消息类型句柄，类型信息来自 TypeRegistry，可在多个 topic 间共享
 class mssageManage {
 public:
-  mssageManage()
-      : raw_msg_class_(nullptr)
-      , descriptor_(nullptr) {}
+  mssageManage() = default;
 
   ~mssageManage() = default;
 
@@ -51,7 +261,6 @@ public:
       return false;
     }
     auto topology = cyber::service_discovery::TopologyManager::Instance();
-    // std::this_thread::sleep_for(std::chrono::seconds(2));
     auto channel_manager = topology->channel_manager();
     std::string msg_type;
     channel_manager->GetMsgType(topic, &msg_type);
@@ -63,7 +272,8 @@ public:
       LOG_WARN << "msg_type is empty";
       return false;
     }
-    if (!createMessageInstance(msg_type)) {
+    info_ = TypeRegistry::instance().get(msg_type);
+    if (!info_) {
       LOG_WARN << "Failed to create message instance: " << msg_type;
       return false;
     }
@@ -71,23 +281,29 @@ public:
     return true;
   }
 
-  // 将消息转换为 Protobuf 字符串
-  std::string getMsgProtoString(const std::shared_ptr<MessageBase> raw_msg) {
-    raw_msg_class_->ParseFromString(raw_msg->message);
-    return raw_msg_class_->SerializeAsString();
+  // 在 arena 上解析消息，失败返回 nullptr；可多线程调用
+  google::protobuf::Message* parse(const std::string& bytes, google::protobuf::Arena* arena) const {
+    auto* msg = info_->prototype()->New(arena);
+    if (!msg->ParseFromString(bytes)) {
+      if (!arena) {
+        delete msg;
+      }
+      return nullptr;
+    }
+    return msg;
   }
 
   // 将消息转换为 JSON 字符串
-  std::string getMsgJsonString(const std::shared_ptr<MessageBase> raw_msg) {
-    raw_msg_class_->ParseFromString(raw_msg->message);
+  std::string getMsgJsonString(const std::shared_ptr<MessageBase> raw_msg) const {
+    std::unique_ptr<google::protobuf::Message> msg(info_->prototype()->New());
+    msg->ParseFromString(raw_msg->message);
     google::protobuf::util::JsonPrintOptions options;
     options.add_whitespace = true;
     options.always_print_primitive_fields = false;
     options.preserve_proto_field_names = false;
     options.always_print_enums_as_ints = true;
     std::string json_string;
-    auto status =
-      google::protobuf::util::MessageToJsonString(*raw_msg_class_, &json_string, options);
+    auto status = google::protobuf::util::MessageToJsonString(*msg, &json_string, options);
     if (!status.ok()) {
       LOG_WARN << "Failed to convert message to JSON: " << status.error_message();
       return "";
@@ -97,14 +313,14 @@ public:
 
   // 从 JSON 字符串创建消息
   bool getMsgFromJsonString(
-    const std::string& msg_json_string, std::shared_ptr<MessageBase>& raw_msg) {
-    auto status =
-      google::protobuf::util::JsonStringToMessage(msg_json_string, raw_msg_class_.get());
+    const std::string& msg_json_string, std::shared_ptr<MessageBase>& raw_msg) const {
+    std::unique_ptr<google::protobuf::Message> msg(info_->prototype()->New());
+    auto status = google::protobuf::util::JsonStringToMessage(msg_json_string, msg.get());
     if (!status.ok()) {
       LOG_WARN << "Failed to convert JSON to message: " << status.error_message();
       return false;
     }
-    if (!raw_msg_class_->SerializeToString(&raw_msg->message)) {
+    if (!msg->SerializeToString(&raw_msg->message)) {
       LOG_WARN << "Failed to serialize message";
       return false;
     }
@@ -113,147 +329,26 @@ public:
 
   // 获取消息类型
   const std::string getType() const {
-    return descriptor_ ? descriptor_->full_name() : "";
+    return info_ ? info_->name() : "";
   }
 
   // 获取文件描述符集合
-  const std::string getFdSet() const {
-    return SerializeFdSet(descriptor_);
+  const std::string& getFdSet() const {
+    static const std::string empty;
+    return info_ ? info_->fdSet() : empty;
   }
 
   // 获取 JSON Schema
-  const std::string getJsonSchema() {
-    auto schema = buildJsonSchemaFromDescriptor(descriptor_);
-    return schema.dump();
+  const std::string& getJsonSchema() const {
+    static const std::string empty;
+    return info_ ? info_->jsonSchema() : empty;
   }
 
   // 获取消息描述符
-  const auto getDescriptor() const {
-    return descriptor_;
-  }
-
-private:
-  // 使用 Protobuf 原生机制查找消息描述符
-  bool createMessageInstance(const std::string& msg_type) {
-    // 先尝试使用 cyber 机制查找消息描述符
-    static const auto cyber_factory = cyber::message::ProtobufFactory::Instance();
-    descriptor_ = cyber_factory->FindMessageTypeByName(msg_type);
-    raw_msg_class_ =
-      std::unique_ptr<google::protobuf::Message>(cyber_factory->GenerateMessageByType(msg_type));
-    if (descriptor_ && raw_msg_class_) {
-      return true;
-    }
-    // 如果 cyber 机制查找失败，则使用 Protobuf 原生机制查找消息描述符
-    static auto pool = google::protobuf::DescriptorPool::generated_pool();
-    descriptor_ = pool->FindMessageTypeByName(msg_type);
-    raw_msg_class_ = createMessageInstance(descriptor_);
-    if (!descriptor_ || !raw_msg_class_) {
-      LOG_WARN << "Failed to find descriptor for msg_type: " << msg_type;
-      return false;
-    }
-    cyber_factory->RegisterMessage(*raw_msg_class_.get());  // 注册消息描述符到 cyber
-    return true;
-  }
-
-  // 创建消息实例
-  std::unique_ptr<google::protobuf::Message> createMessageInstance(
-    const google::protobuf::Descriptor* descriptor) {
-    if (!descriptor) {
-      return nullptr;
-    }
-    // 尝试使用静态工厂创建消息实例
-    static const auto factory = google::protobuf::MessageFactory::generated_factory();
-    const google::protobuf::Message* prototype = factory->GetPrototype(descriptor);
-    if (!prototype) {
-      // 尝试使用动态工厂创建消息实例
-      static const auto dynamic_factory =
-        std::make_unique<google::protobuf::DynamicMessageFactory>();
-      prototype = dynamic_factory->GetPrototype(descriptor);
-      if (!prototype) {
-        return nullptr;
-      }
-    }
-    return std::unique_ptr<google::protobuf::Message>(prototype->New());
-  }
-
-  // 获取 JSON Schema（通过 descriptor）
-  const json buildJsonSchemaFromDescriptor(const google::protobuf::Descriptor* descriptor) {
-    if (!descriptor) {
-      return json{};
-    }
-
-    json schema;
-    schema["type"] = "object";
-    json properties = json::object();
-
-    for (int i = 0; i < descriptor->field_count(); i++) {
-      const google::protobuf::FieldDescriptor* field = descriptor->field(i);
-      json fieldSchema;
-
-      switch (field->type()) {
-        case google::protobuf::FieldDescriptor::TYPE_INT32:
-        case google::protobuf::FieldDescriptor::TYPE_INT64:
-        case google::protobuf::FieldDescriptor::TYPE_UINT32:
-        case google::protobuf::FieldDescriptor::TYPE_UINT64:
-        case google::protobuf::FieldDescriptor::TYPE_SINT32:
-        case google::protobuf::FieldDescriptor::TYPE_SINT64:
-        case google::protobuf::FieldDescriptor::TYPE_FIXED32:
-        case google::protobuf::FieldDescriptor::TYPE_FIXED64:
-        case google::protobuf::FieldDescriptor::TYPE_SFIXED32:
-        case google::protobuf::FieldDescriptor::TYPE_SFIXED64:
-          fieldSchema["type"] = "integer";
-          break;
-
-        case google::protobuf::FieldDescriptor::TYPE_FLOAT:
-        case google::protobuf::FieldDescriptor::TYPE_DOUBLE:
-          fieldSchema["type"] = "number";
-          break;
-
-        case google::protobuf::FieldDescriptor::TYPE_BOOL:
-          fieldSchema["type"] = "boolean";
-          break;
-
-        case google::protobuf::FieldDescriptor::TYPE_STRING:
-        case google::protobuf::FieldDescriptor::TYPE_BYTES:
-          fieldSchema["type"] = "string";
-          break;
-
-        case google::protobuf::FieldDescriptor::TYPE_ENUM: {
-          fieldSchema["type"] = "string";
-          json enumValues = json::array();
-          const auto* enumDesc = field->enum_type();
-          for (int j = 0; j < enumDesc->value_count(); j++) {
-            enumValues.push_back(enumDesc->value(j)->name());
-          }
-          fieldSchema["enum"] = enumValues;
-          break;
-        }
-
-        case google::protobuf::FieldDescriptor::TYPE_MESSAGE: {
-          // 递归构建嵌套 message
-          fieldSchema = buildJsonSchemaFromDescriptor(field->message_type());
-          break;
-        }
-
-        default:
-          fieldSchema["type"] = "string";  // 兜底
-          break;
-      }
-
-      if (field->is_repeated()) {
-        json arrSchema;
-        arrSchema["type"] = "array";
-        arrSchema["items"] = fieldSchema;
-        properties[field->name()] = arrSchema;
-      } else {
-        properties[field->name()] = fieldSchema;
-      }
-    }
-    schema["properties"] = properties;
-    return schema;
+  const google::protobuf::Descriptor* getDescriptor() const {
+    return info_ ? info_->descriptor() : nullptr;
   }
 
 private:
-  std::unique_ptr<google::protobuf::Message> raw_msg_class_;  // 用于存储解析后的消息
-  const google::protobuf::Descriptor* descriptor_;
+  std::shared_ptr<const TypeInfo> info_;
 };
@@ -1,11 +1,12 @@
 #!/usr/bin/env bash
 # set -euxo pipefail # enable for debug
 
-# 使用方法: ./run.sh -i 192.168.1.1 -p 8765
+# 使用方法: ./run.sh -i 192.168.1.1 -p 8765 -c ../config/bridge_config.json
 
 #设置传入参数
 fox_addr=127.0.0.1
 fox_port=8765
+fox_config=""
 
 while [[ $# -gt 0 ]]; do
     key="$1"
@@ -20,6 +21,11 @@ while [[ $# -gt 0 ]]; do
         shift
         shift
         ;;
+        -c|--config)
+        fox_config="$2"
+        shift
+        shift
+        ;;
         *)
         echo "Unknown option: $key"
         exit 1
@@ -34,6 +40,15 @@ SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
 ROOT_DIR="$(cd "$SCRIPT_DIR/.." && pwd)"
 echo "Project root directory: $ROOT_DIR"
 
+# 未指定配置文件时使用安装目录下的默认配置
+if [ -z "$fox_config" ] && [ -f "$ROOT_DIR/config/bridge_config.json" ]; then
+    fox_config=$ROOT_DIR/config/bridge_config.json
+fi
+fox_args="-i $fox_addr -p $fox_port"
+if [ -n "$fox_config" ]; then
+    fox_args="$fox_args -c $fox_config"
+fi
+
 # 根据当前系统架构及ubuntu版本选择合适的二进制文件
 source /etc/os-release
 if [[ "$VERSION_ID" == "22.04" ]]; then
@@ -57,9 +72,9 @@ export HAVP_LOG_PATH=/data/log/$current_time
 # 添加链接库
 if [ -d "$ROOT_DIR/lib" ]; then
     # export LD_LIBRARY_PATH=$ROOT_DIR/lib:$LD_LIBRARY_PATH
-    $ROOT_DIR/bin/fox_bridge -i $fox_addr -p $fox_port
+    $ROOT_DIR/bin/fox_bridge $fox_args
 else
     # export LD_LIBRARY_PATH=$ROOT_DIR/../../lib:$LD_LIBRARY_PATH
     # 运行
-    $ROOT_DIR/../../bin/fox_bridge -i $fox_addr -p $fox_port
+    $ROOT_DIR/../../bin/fox_bridge $fox_args
 fi
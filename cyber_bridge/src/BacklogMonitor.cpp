@@ -0,0 +1,302 @@
+#include "BacklogMonitor.hpp"
+
+#include <algorithm>
+#include <set>
+#include <string>
+
+#ifdef __linux__
+#include <linux/inet_diag.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/tcp.h>  // glibc 的 netinet/tcp.h 没有 tcpi_bytes_acked
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstring>
+#endif
+
+#include "logger/log.h"
+
+namespace {
+
+// 连接建立后 SDK 才开始订阅，查找若干次仍无法唯一对应时退回带宽预算
+constexpr uint32_t kMaxProbes = 20;
+
+#ifdef __linux__
+// 内核 tcp_states.h 中的 TCP_ESTABLISHED，用户态头文件与 linux/tcp.h 冲突
+constexpr uint32_t kTcpEstablished = 1;
+
+using PortSockets = std::map<uint64_t, SocketSample>;  // socket inode -> 发送状态
+
+// 通过 sock_diag 一次取得本地端口在 ports 中的已建立 TCP 连接的发送状态，按本地端口分组
+// 只读取内核的连接表，不访问 SDK 持有的 fd
+std::map<uint16_t, PortSockets> diagSockets(const std::set<uint16_t>& ports) {
+  std::map<uint16_t, PortSockets> result;
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+  if (fd < 0) {
+    return result;
+  }
+  for (uint8_t family : {AF_INET, AF_INET6}) {
+    struct {
+      nlmsghdr header;
+      inet_diag_req_v2 request;
+    } message;
+    std::memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.request.sdiag_family = family;
+    message.request.sdiag_protocol = IPPROTO_TCP;
+    message.request.idiag_states = 1u << kTcpEstablished;
+    message.request.idiag_ext = 1 << (INET_DIAG_INFO - 1);
+    if (send(fd, &message, sizeof(message), 0) < 0) {
+      break;
+    }
+    alignas(nlmsghdr) char buffer[32768];
+    bool done = false;
+    while (!done) {
+      ssize_t len = recv(fd, buffer, sizeof(buffer), 0);
+      if (len <= 0) {
+        break;
+      }
+      auto* header = reinterpret_cast<nlmsghdr*>(buffer);
+      for (; NLMSG_OK(header, len); header = NLMSG_NEXT(header, len)) {
+        if (header->nlmsg_type == NLMSG_DONE || header->nlmsg_type == NLMSG_ERROR) {
+          done = true;
+          break;
+        }
+        auto* diag = reinterpret_cast<inet_diag_msg*>(NLMSG_DATA(header));
+        uint16_t port = ntohs(diag->id.idiag_sport);
+        if (!ports.count(port) || diag->idiag_inode == 0) {
+          continue;
+        }
+        auto* attr = reinterpret_cast<rtattr*>(diag + 1);
+        int attr_len = static_cast<int>(header->nlmsg_len - NLMSG_LENGTH(sizeof(*diag)));
+        for (; RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len)) {
+          if (attr->rta_type != INET_DIAG_INFO ||
+              RTA_PAYLOAD(attr) < offsetof(tcp_info, tcpi_bytes_acked) + sizeof(uint64_t)) {
+            continue;
+          }
+          tcp_info info;
+          std::memset(&info, 0, sizeof(info));
+          std::memcpy(&info, RTA_DATA(attr), std::min<size_t>(RTA_PAYLOAD(attr), sizeof(info)));
+          // idiag_wqueue 为已写入未确认的字节数，与 SIOCOUTQ 相同
+          result[port][diag->idiag_inode] = {info.tcpi_bytes_acked, diag->idiag_wqueue};
+        }
+      }
+    }
+  }
+  close(fd);
+  return result;
+}
+#endif
+
+}  // namespace
+
+BacklogMonitor::BacklogMonitor(
+  uint64_t drain_bytes_per_s, uint32_t threshold_ms, uint32_t interval_ms)
+    : _drain_bytes_per_s(drain_bytes_per_s)
+    , _threshold_ms(threshold_ms)
+    , _interval_ms(interval_ms > 0 ? interval_ms : 1) {}
+
+BacklogMonitor::~BacklogMonitor() {
+  stop();
+}
+
+std::shared_ptr<ClientBacklog> BacklogMonitor::acquire(
+  uint32_t client_id, uint64_t sink_id, uint16_t port) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& entry = _clients[client_id];
+  if (!entry.backlog) {
+    entry.backlog =
+      std::make_shared<ClientBacklog>(client_id, sink_id, _drain_bytes_per_s, _threshold_ms);
+    entry.port = port;
+    LOG_INFO << "track backlog for client: " << client_id << " sink: " << sink_id;
+  }
+  ++entry.refs;
+  return entry.backlog;
+}
+
+void BacklogMonitor::release(uint32_t client_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _clients.find(client_id);
+  if (it != _clients.end() && --it->second.refs == 0) {
+    _clients.erase(it);
+  }
+}
+
+std::shared_ptr<ClientBacklog> BacklogMonitor::find(uint32_t client_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto it = _clients.find(client_id);
+  return it == _clients.end() ? nullptr : it->second.backlog;
+}
+
+void BacklogMonitor::start(Tick tick, StatusCallback status) {
+  std::lock_guard<std::mutex> lock(_run_mutex);
+  if (_running) {
+    return;
+  }
+  _tick = std::move(tick);
+  _status = std::move(status);
+  _running = true;
+  _thread = std::thread(&BacklogMonitor::run, this);
+  LOG_INFO << "backlog monitor started, budget: " << _drain_bytes_per_s
+           << " B/s threshold: " << _threshold_ms << "ms";
+}
+
+void BacklogMonitor::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_run_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+std::vector<BacklogStats> BacklogMonitor::stats() {
+  uint64_t now = ClientBacklog::nowNs();
+  std::vector<BacklogStats> result;
+  for (auto& backlog : snapshot()) {
+    result.push_back(backlog->stats(now));
+  }
+  return result;
+}
+
+void BacklogMonitor::collect(BridgeMetrics::Values& values) {
+  auto all = stats();
+  values["fox_bridge_client_count"] = all.size();
+  for (const auto& stats : all) {
+    std::string name = "fox_bridge_client_" + std::to_string(stats.client_id);
+    values[name + "_backlog_bytes"] = stats.queued_bytes;
+    values[name + "_backlog_ms"] = stats.oldest_age_ms;
+    values[name + "_sent_bytes"] = stats.sent_bytes;
+    values[name + "_rate_bytes_per_s"] = stats.rate_bytes_per_s;
+    values[name + "_socket"] = stats.measured ? 1 : 0;
+    values[name + "_dropped_msgs"] = stats.dropped;
+    values[name + "_collapsed_msgs"] = stats.collapsed;
+    values[name + "_lagging"] = stats.lagging ? 1 : 0;
+  }
+}
+
+std::vector<std::shared_ptr<ClientBacklog>> BacklogMonitor::snapshot() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<std::shared_ptr<ClientBacklog>> result;
+  result.reserve(_clients.size());
+  for (const auto& [client_id, entry] : _clients) {
+    result.push_back(entry.backlog);
+  }
+  return result;
+}
+
+void BacklogMonitor::run() {
+  std::unique_lock<std::mutex> lock(_run_mutex);
+  while (_running) {
+    if (_cv.wait_for(lock, std::chrono::milliseconds(_interval_ms), [this]() {
+          return !_running;
+        })) {
+      break;
+    }
+    lock.unlock();
+    uint64_t now = ClientBacklog::nowNs();
+    if (_tick) {
+      _tick(now);
+    }
+    probeSockets(now);
+    for (auto& backlog : snapshot()) {
+      bool changed = false;
+      bool lagging = backlog->refresh(now, changed);
+      if (!changed) {
+        continue;
+      }
+      auto stats = backlog->stats(now);
+      if (lagging) {
+        LOG_WARN << "client " << stats.client_id << " is lagging, backlog: " << stats.queued_bytes
+                 << " bytes " << stats.oldest_age_ms << "ms";
+      } else {
+        LOG_INFO << "client " << stats.client_id << " recovered, dropped: " << stats.dropped
+                 << " collapsed: " << stats.collapsed;
+      }
+      if (_status) {
+        _status(stats, lagging);
+      }
+    }
+    lock.lock();
+  }
+}
+
+void BacklogMonitor::probeSockets(uint64_t now_ns) {
+#ifdef __linux__
+  std::set<uint16_t> ports;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (const auto& [client_id, entry] : _clients) {
+      if (entry.port != 0 && (entry.inode != 0 || entry.probes < kMaxProbes)) {
+        ports.insert(entry.port);
+      }
+    }
+  }
+  if (ports.empty()) {
+    return;
+  }
+  auto sockets = diagSockets(ports);
+  std::vector<std::pair<std::shared_ptr<ClientBacklog>, SocketSample>> samples;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::map<uint16_t, std::vector<Entry*>> pending;  // 端口 -> 尚未对应 socket 的客户端
+    std::set<uint64_t> claimed;
+    for (auto& [client_id, entry] : _clients) {
+      if (entry.inode == 0) {
+        if (entry.port != 0 && entry.probes < kMaxProbes) {
+          ++entry.probes;
+          pending[entry.port].push_back(&entry);
+        }
+        continue;
+      }
+      claimed.insert(entry.inode);
+      auto& port_sockets = sockets[entry.port];
+      if (auto it = port_sockets.find(entry.inode); it != port_sockets.end()) {
+        samples.emplace_back(entry.backlog, it->second);
+        continue;
+      }
+      // 连接已关闭，客户端断开后由 release 移除
+      entry.inode = 0;
+      entry.probes = kMaxProbes;
+      entry.backlog->detach();
+    }
+    // SDK 不提供客户端的对端地址，只有端口上恰好一个待对应的客户端与一个未被占用的连接时才对应，
+    // 多个客户端同时连接时无法区分，继续按带宽预算估算
+    for (auto& [port, entries] : pending) {
+      if (entries.size() != 1) {
+        continue;
+      }
+      std::vector<uint64_t> free;
+      for (const auto& [inode, sample] : sockets[port]) {
+        if (!claimed.count(inode)) {
+          free.push_back(inode);
+        }
+      }
+      if (free.size() != 1) {
+        continue;
+      }
+      auto* entry = entries.front();
+      entry->inode = free.front();
+      samples.emplace_back(entry->backlog, sockets[port][entry->inode]);
+      LOG_INFO << "client " << entry->backlog->clientId() << " socket inode: " << entry->inode
+               << " port: " << port;
+    }
+  }
+  for (auto& [backlog, sample] : samples) {
+    backlog->observe(sample, now_ns);
+  }
+#else
+  (void)now_ns;
+#endif
+}
@@ -0,0 +1,175 @@
+#include "BridgeMetrics.hpp"
+
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+
+#include "logger/log.h"
+
+namespace {
+
+constexpr const char* kPrefix = "fox_bridge_";
+
+// 与 bvar 一致：非字母数字替换为 '_'，去掉首尾的 '_'
+std::string toVariableName(const std::string& topic) {
+  std::string name;
+  name.reserve(topic.size());
+  for (char c : topic) {
+    name.push_back(std::isalnum(static_cast<unsigned char>(c))
+                     ? static_cast<char>(std::tolower(static_cast<unsigned char>(c)))
+                     : '_');
+  }
+  auto begin = name.find_first_not_of('_');
+  if (begin == std::string::npos) {
+    return "";
+  }
+  return name.substr(begin, name.find_last_not_of('_') - begin + 1);
+}
+
+void exposeLatency(BridgeMetrics::Values& values, BridgeMetrics::Values& latencies,
+  const std::string& name, LatencyRecorder& recorder) {
+  auto snapshot = recorder.collect();
+  latencies[name + "_latency"] = snapshot.average();
+  latencies[name + "_latency_80"] = snapshot.percentile(0.8);
+  latencies[name + "_latency_90"] = snapshot.percentile(0.9);
+  latencies[name + "_latency_99"] = snapshot.percentile(0.99);
+  latencies[name + "_latency_999"] = snapshot.percentile(0.999);
+  latencies[name + "_latency_9999"] = snapshot.percentile(0.9999);
+  latencies[name + "_max_latency"] = snapshot.max;
+  values[name + "_count"] = recorder.total();
+}
+
+}  // namespace
+
+std::string BridgeMetrics::topicName(const std::string& topic) {
+  return std::string(kPrefix) + "cyber_bridge_channel_" + toVariableName(topic);
+}
+
+std::shared_ptr<TopicMetrics> BridgeMetrics::topic(const std::string& topic) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& metrics = _topics[topic];
+  if (!metrics) {
+    metrics = std::make_shared<TopicMetrics>();
+    metrics->name = topicName(topic);
+  }
+  return metrics;
+}
+
+void BridgeMetrics::removeTopic(const std::string& topic) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _topics.erase(topic);
+}
+
+void BridgeMetrics::setPublisher(Publisher publisher) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _publisher = std::move(publisher);
+}
+
+void BridgeMetrics::addCollector(Collector collector) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _collectors.push_back(std::move(collector));
+}
+
+void BridgeMetrics::clearCollectors() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _collectors.clear();
+}
+
+void BridgeMetrics::collect(Values& values, Values& latencies) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  values[std::string(kPrefix) + "bvar_dump_interval"] = _interval_s;
+  for (auto& collector : _collectors) {
+    collector(values);
+  }
+  for (auto& [topic, metrics] : _topics) {
+    exposeLatency(values, latencies, metrics->name + "_cyber", metrics->cyber_latency);
+    exposeLatency(values, latencies, metrics->name + "_proc", metrics->proc_latency);
+    exposeLatency(values, latencies, metrics->name + "_tran", metrics->tran_latency);
+    // 只有图像与点云 topic 有 encode 延迟
+    if (metrics->encode_latency.total() > 0) {
+      exposeLatency(values, latencies, metrics->name + "_encode", metrics->encode_latency);
+    }
+    values[metrics->name + "_recv_msgs_nums"] = metrics->recv_msgs.load(std::memory_order_relaxed);
+    values[metrics->name + "_total_msgs_nums"] =
+      metrics->total_msgs.load(std::memory_order_relaxed);
+  }
+}
+
+void BridgeMetrics::start(uint32_t interval_s, const std::string& dump_dir) {
+  std::lock_guard<std::mutex> lock(_run_mutex);
+  if (_running || interval_s == 0) {
+    return;
+  }
+  _interval_s = interval_s;
+  _dump_dir = dump_dir;
+  if (!_dump_dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(_dump_dir, ec);
+    if (ec) {
+      LOG_WARN << "Failed to create stats dir: " << _dump_dir << " " << ec.message();
+      _dump_dir.clear();
+    }
+  }
+  _running = true;
+  _thread = std::thread(&BridgeMetrics::run, this);
+  LOG_INFO << "bridge stats interval: " << _interval_s << "s dump dir: " << _dump_dir;
+}
+
+void BridgeMetrics::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_run_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+void BridgeMetrics::run() {
+  std::unique_lock<std::mutex> lock(_run_mutex);
+  while (_running) {
+    if (_cv.wait_for(lock, std::chrono::seconds(_interval_s), [this]() {
+          return !_running;
+        })) {
+      break;
+    }
+    lock.unlock();
+    Values values;
+    Values latencies;
+    collect(values, latencies);
+    if (!_dump_dir.empty()) {
+      dump(values, _dump_dir + "/bvar.fox_bridge.data");
+      dump(latencies, _dump_dir + "/bvar.fox_bridge.latency.data");
+    }
+    Publisher publisher;
+    {
+      std::lock_guard<std::mutex> guard(_mutex);
+      publisher = _publisher;
+    }
+    if (publisher) {
+      publisher(values, latencies);
+    }
+    lock.lock();
+  }
+}
+
+void BridgeMetrics::dump(const Values& values, const std::string& file) const {
+  // 先写临时文件再替换，避免读到写了一半的文件
+  std::string tmp = file + ".tmp";
+  {
+    std::ofstream ofs(tmp, std::ios::trunc);
+    if (!ofs.is_open()) {
+      LOG_WARN << "Failed to write stats: " << tmp;
+      return;
+    }
+    for (const auto& [key, value] : values) {
+      ofs << key << " : " << value << "\n";
+    }
+  }
+  std::error_code ec;
+  std::filesystem::rename(tmp, file, ec);
+}
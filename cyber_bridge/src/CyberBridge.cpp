@@ -1,8 +1,13 @@
 #include "CyberBridge.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <vector>
 
+#include "BridgeConfig.hpp"
+#include "BridgeMetrics.hpp"
+#include "ProtoArena.hpp"
 #include "cyber/service_discovery/specific_manager/node_manager.h"
 #include "protoPool.hpp"
 #include "service_impl.hpp"
@@ -15,14 +20,26 @@ CyberBridge::~CyberBridge() {
 
 void CyberBridge::startDiscoverTimer(const adCallback& topic_adCb,
   const unScribeCallback& topic_unadCb, const adCallback& service_adCb) {
-  // init timer
+  {
+    std::lock_guard<std::mutex> lock(_discover_mutex);
+    _topic_adCb = topic_adCb;
+    _topic_unadCb = topic_unadCb;
+    _service_adCb = service_adCb;
+  }
+  auto topology = cyber::service_discovery::TopologyManager::Instance();
+  if (!_change_conn.IsConnected()) {
+    _change_conn = topology->AddChangeListener([this](const cyber::proto::ChangeMsg& msg) {
+      onTopologyChange(msg);
+    });
+    LOG_INFO << "listen topology change";
+  }
+  // 监听注册前已存在的 topic 由首次对账补齐
+  reconcile();
   if (!_timer) {
-    std::this_thread::sleep_for(std::chrono::seconds(2));  // wait for node manager init
     _timer = std::make_shared<cyber::Timer>(
-      500,
-      [&]() {
-        discoverTopics(topic_adCb, topic_unadCb);
-        discoverServices(service_adCb);
+      BridgeConfig::instance().global().value("discover_interval_ms", 5000u),
+      [this]() {
+        reconcile();
       },
       false);
     LOG_INFO << "create timer ";
@@ -30,57 +47,117 @@ void CyberBridge::startDiscoverTimer(const adCallback& topic_adCb,
   _timer->Start();
 }
 
-void CyberBridge::discoverTopics(const adCallback& adCb, const unScribeCallback& unScribeCb) {
+void CyberBridge::onTopologyChange(const cyber::proto::ChangeMsg& msg) {
+  // bridge 自身创建 reader/writer 时会在同一线程同步收到通知，直接忽略
+  if (_node && msg.role_attr().node_name() == _node->Name()) {
+    return;
+  }
+  if (msg.change_type() == cyber::proto::CHANGE_SERVICE &&
+      msg.role_type() == cyber::proto::ROLE_SERVER &&
+      msg.operate_type() == cyber::proto::OPT_JOIN) {
+    std::lock_guard<std::mutex> lock(_discover_mutex);
+    discoverServices();
+    return;
+  }
+  if (msg.change_type() != cyber::proto::CHANGE_CHANNEL ||
+      msg.role_type() != cyber::proto::ROLE_WRITER) {
+    return;
+  }
+  const std::string& channel = msg.role_attr().channel_name();
+  std::lock_guard<std::mutex> lock(_discover_mutex);
+  if (msg.operate_type() == cyber::proto::OPT_JOIN) {
+    addTopic(channel);
+    return;
+  }
+  // 同一 channel 可能有多个 writer，最后一个离开时才移除
+  auto channel_manager = cyber::service_discovery::TopologyManager::Instance()->channel_manager();
+  if (!channel_manager->HasWriter(channel)) {
+    removeTopic(channel);
+  }
+}
+
+void CyberBridge::reconcile() {
+  std::lock_guard<std::mutex> lock(_discover_mutex);
+  discoverTopics();
+  discoverServices();
+}
+
+void CyberBridge::discoverTopics() {
   auto topology = cyber::service_discovery::TopologyManager::Instance();
-  // std::this_thread::sleep_for(std::chrono::seconds(2));
   auto channel_manager = topology->channel_manager();
   std::vector<std::string> topics;
   channel_manager->GetChannelNames(&topics);
-  if (topics == _topics) {
+  // 只广播存在 writer 的 topic
+  std::set<std::string> live;
+  for (const auto& channel : topics) {
+    if (channel_manager->HasWriter(channel)) {
+      live.insert(channel);
+    }
+  }
+  std::vector<std::string> stale;
+  std::set_difference(_topics.begin(), _topics.end(), live.begin(), live.end(),
+    std::back_inserter(stale));
+  for (const auto& channel : stale) {
+    removeTopic(channel);
+  }
+  for (const auto& channel : live) {
+    addTopic(channel);
+  }
+}
+
+void CyberBridge::addTopic(const std::string& channel) {
+  if (!_topic_adCb || _topics.count(channel)) {
     return;
   }
-  _topics = topics;
-  // 遍历_msg_manages并移除不在_topics中的元素
-  std::unordered_set<std::string> topics_set(_topics.begin(), _topics.end());
-  for (auto it = _msg_manages.begin(); it != _msg_manages.end();) {
-    if (topics_set.find(it->first) == topics_set.end()) {
-      onUnsubscribe(it->first);
-      unScribeCb(it->first);
-      LOG_INFO << "remove topic: " << it->first;
-      it = _msg_manages.erase(it);
-    } else {
-      ++it;
+  {
+    std::lock_guard<std::mutex> lock(_topic_mutex);
+    if (_writers.find(channel) != _writers.end()) {
+      return;
     }
   }
-  // 添加新的topics到_msg_manages
-  for (const auto& channel : _topics) {
-    if (_writers.find(channel) != _writers.end()) continue;
-    if (_msg_manages.find(channel) == _msg_manages.end()) {
-      auto message = std::make_shared<mssageManage>();
-      if (!message->init_topic(channel)) {
-        continue;
-      }
-      _msg_manages.insert({channel, message});
-      // 只广播存在 writer 的 topic
-      if (!channel_manager->HasWriter(channel)) continue;
-      std::string shema_desc = _msg_manages[channel]->getFdSet();
-      if (shema_desc.empty()) continue;
-      Schema schema = {_msg_manages[channel]->getType(), shema_desc};
-      std::optional<Schema> opt_schema = std::nullopt;
-      adCb(channel, schema, opt_schema);
-      LOG_INFO << "add topic: " << channel << " msg_type: " << _msg_manages[channel]->getType();
-    }
+  // 初始化失败（如 proto 描述尚未同步）时不记录，由下次事件或对账重试
+  auto message = std::make_shared<mssageManage>();
+  if (!message->init_topic(channel)) {
+    return;
+  }
+  std::string shema_desc = message->getFdSet();
+  if (shema_desc.empty()) {
+    return;
+  }
+  _msg_manages.insert(channel, 0, message);
+  _topics.insert(channel);
+  Schema schema = {message->getType(), shema_desc};
+  std::optional<Schema> opt_schema = std::nullopt;
+  _topic_adCb(channel, schema, opt_schema);
+  LOG_INFO << "add topic: " << channel << " msg_type: " << message->getType();
+}
+
+void CyberBridge::removeTopic(const std::string& channel) {
+  if (_topics.erase(channel) == 0) {
+    return;
   }
+  onUnsubscribe(channel);
+  _topic_unadCb(channel);
+  _msg_manages.erase(channel);
+  LOG_INFO << "remove topic: " << channel;
 }
 
-void CyberBridge::discoverServices(const adCallback& adCb) {
+void CyberBridge::discoverServices() {
+  if (!_service_adCb) {
+    return;
+  }
   auto topology = cyber::service_discovery::TopologyManager::Instance();
   auto service_manager = topology->service_manager();
   std::vector<std::string> srv_names;
   std::vector<cyber::RoleAttributes> services;
   service_manager->GetServers(&services);
   for (auto& service : services) {
-    if (_services.find(service.service_name()) == _services.end()) {
+    bool known = false;
+    {
+      std::lock_guard<std::mutex> lock(_client_mutex);
+      known = _services.find(service.service_name()) != _services.end();
+    }
+    if (!known) {
       if (service_map_impl_.find(service.service_name()) != service_map_impl_.end()) {
         const auto& ser_type = service_map_impl_.at(service.service_name());
         auto request = std::make_shared<mssageManage>();
@@ -91,8 +168,11 @@ void CyberBridge::discoverServices(const adCallback& adCb) {
           Schema request_schema = {ser_type.first, request->getJsonSchema()};
           auto response_schema =
             std::optional<Schema>({ser_type.second, response->getJsonSchema()});
-          adCb(service.service_name(), request_schema, response_schema);
-          _services.emplace(service.service_name(), std::make_pair(request, response));
+          {
+            std::lock_guard<std::mutex> lock(_client_mutex);
+            _services.emplace(service.service_name(), std::make_pair(request, response));
+          }
+          _service_adCb(service.service_name(), request_schema, response_schema);
         } else {
           LOG_WARN << "service: " << service.service_name()
                << " create failed, please check the service_impl.hpp";
@@ -108,6 +188,7 @@ void CyberBridge::discoverServices(const adCallback& adCb) {
 // 该 sub 为 cyber 侧的 pub 的 topic，bridge 端为 sub
 void CyberBridge::onUnsubscribe(const std::string& topic) {
   // auto reader = _node->GetReader<MessageBase>(topic);
+  std::lock_guard<std::mutex> topic_lock(_topic_mutex);
   if (_readers.find(topic) == _readers.end()) {
     return;
   }
@@ -119,83 +200,225 @@ void CyberBridge::onUnsubscribe(const std::string& topic) {
   reader->Shutdown();
   _node->DeleteReader(topic);
   _readers.erase(topic);
+  {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    if (auto it = _queues.find(topic); it != _queues.end()) {
+      it->second->close();
+      auto stats = it->second->stats();
+      LOG_INFO << "topic: " << topic << " enqueued: " << stats.enqueued
+               << " dropped: " << stats.dropped;
+      _queues.erase(it);
+    }
+    if (auto it = _limiters.find(topic); it != _limiters.end()) {
+      auto stats = it->second->stats();
+      LOG_INFO << "topic: " << topic << " rate: " << stats.policy
+               << " forwarded: " << stats.forwarded << " suppressed: " << stats.suppressed;
+      _limiters.erase(it);
+    }
+  }
   LOG_INFO << "unsubscribe topic: " << topic;
 }
 // 该 sub 为 cyber 侧的 pub 的 topic，bridge 端为 sub
 void CyberBridge::onSubscribe(const std::string& topic, const msgCallback& cb) {
-  if (_readers.find(topic) != _readers.end() || _msg_manages[topic] == nullptr) {
+  auto msg_manage = _msg_manages.get(topic);
+  std::lock_guard<std::mutex> topic_lock(_topic_mutex);
+  if (_readers.find(topic) != _readers.end() || !msg_manage) {
     return;
   }
-  auto callback = [this, topic, cb](const std::shared_ptr<MessageBase> msg) {
-    cb(topic, _msg_manages[topic]->getMsgProtoString(msg));
+  auto options = BridgeConfig::instance().resolve(topic);
+  // 每条消息最多解析一次，解析结果放在分发线程的 arena 上，随 bytes 一起交给转换器
+  // 返回 false 表示消息被丢弃
+  std::function<bool(const std::shared_ptr<MessageBase>&)> callback;
+  if (options.passthrough) {
+    // 透传：RawMessage::message 原样交给 RawChannel::log，每 N 帧抽样解析一次
+    callback = [topic, cb, msg_manage, n = options.validate_every_n, seq = uint64_t(0)](
+                 const std::shared_ptr<MessageBase>& msg) mutable {
+      auto& scratch = ProtoArena::local();
+      scratch.reset();
+      const google::protobuf::Message* parsed = nullptr;
+      if (n > 0 && seq++ % n == 0) {
+        parsed = msg_manage->parse(msg->message, scratch.arena());
+        if (!parsed) {
+          LOG_WARN << "drop invalid message, topic: " << topic
+                   << " msg_type: " << msg_manage->getType();
+          return false;
+        }
+      }
+      cb(topic, msg->message, parsed);
+      return true;
+    };
+  } else {
+    callback = [topic, cb, msg_manage](const std::shared_ptr<MessageBase>& msg) {
+      auto& scratch = ProtoArena::local();
+      scratch.reset();
+      auto* parsed = msg_manage->parse(msg->message, scratch.arena());
+      if (!parsed) {
+        LOG_WARN << "drop invalid message, topic: " << topic
+                 << " msg_type: " << msg_manage->getType();
+        return false;
+      }
+      auto& bytes = scratch.rawBuffer();
+      parsed->SerializeToString(&bytes);
+      cb(topic, bytes, parsed);
+      return true;
+    };
+  }
+  auto metrics = BridgeMetrics::instance().topic(topic);
+  auto handler = [callback = std::move(callback), metrics](const InboundMessage& in) {
+    if (!callback(in.msg)) {
+      return;
+    }
+    metrics->total_msgs.fetch_add(1, std::memory_order_relaxed);
+    uint64_t now = cyber::Time::Now().ToNanosecond();
+    metrics->tran_latency.record(now > in.recv_ns ? (now - in.recv_ns) / 1000 : 0);
   };
-  auto reader = _node->CreateReader<MessageBase>(topic, callback);
+  // reader 回调只负责计时、限频与入队，转换与发送由 dispatcher 的 worker 完成
+  auto queue = std::make_shared<InboundQueue>(
+    topic, options.queue_size, options.overflow, std::move(handler),
+    dispatcherFor(options.server));
+  auto limiter = std::make_shared<InboundLimiter>(options.rate);
+  {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    _queues[topic] = queue;
+    _limiters[topic] = limiter;
+  }
+  auto reader = _node->CreateReader<MessageBase>(
+    topic, [queue, limiter, metrics](const std::shared_ptr<MessageBase>& msg) {
+      InboundMessage in{msg, cyber::Time::Now().ToNanosecond()};
+      metrics->recv_msgs.fetch_add(1, std::memory_order_relaxed);
+      // RawMessage::timestamp 为发布时间，未设置时不统计
+      if (msg->timestamp > 0 && in.recv_ns > msg->timestamp) {
+        metrics->cyber_latency.record((in.recv_ns - msg->timestamp) / 1000);
+      }
+      if (limiter->admit(in, InboundLimiter::nowNs())) {
+        queue->push(std::move(in));
+      }
+    });
   _readers[topic] = std::move(reader);
-  LOG_INFO << "subscribe topic: " << topic;
+  LOG_INFO << "subscribe topic: " << topic << " passthrough: " << options.passthrough
+           << " queue: " << options.queue_size << " " << overflowPolicyName(options.overflow)
+           << " rate: " << options.rate.toString();
+}
+
+std::vector<QueueStats> CyberBridge::getQueueStats() {
+  std::vector<QueueStats> result;
+  std::lock_guard<std::mutex> lock(_queue_mutex);
+  result.reserve(_queues.size());
+  for (const auto& [topic, queue] : _queues) {
+    result.push_back(queue->stats());
+  }
+  return result;
 }
 
-void CyberBridge::onWriterCreate(const std::string& topic, const std::string& msg_type) {
-  for (auto& it : _msg_manages) {
-    if (!it.second) {
-      continue;
+void CyberBridge::setRatePolicy(const std::string& pattern, const RatePolicy& policy) {
+  BridgeConfig::instance().setRate(pattern, policy);
+  std::lock_guard<std::mutex> lock(_queue_mutex);
+  for (auto& [topic, limiter] : _limiters) {
+    if (BridgeConfig::match(pattern, topic)) {
+      limiter->setPolicy(BridgeConfig::instance().resolve(topic).rate);
+      LOG_INFO << "topic: " << topic << " rate: " << limiter->policy().toString();
     }
-    if (it.second->getType() == msg_type) {
-      _msg_manages.insert({topic, it.second});
-      break;
+  }
+}
+
+std::vector<RateStats> CyberBridge::getRateStats() {
+  std::vector<RateStats> result;
+  std::lock_guard<std::mutex> lock(_queue_mutex);
+  result.reserve(_limiters.size());
+  for (const auto& [topic, limiter] : _limiters) {
+    result.push_back(limiter->stats());
+    result.back().topic = topic;
+  }
+  return result;
+}
+
+void CyberBridge::flushRateWindows() {
+  auto now = InboundLimiter::nowNs();
+  std::vector<std::pair<std::shared_ptr<InboundQueue>, InboundMessage>> due;
+  {
+    std::lock_guard<std::mutex> lock(_queue_mutex);
+    for (auto& [topic, limiter] : _limiters) {
+      if (auto msg = limiter->takeDue(now)) {
+        if (auto it = _queues.find(topic); it != _queues.end()) {
+          due.emplace_back(it->second, std::move(msg));
+        }
+      }
     }
   }
-  if (_msg_manages.find(topic) == _msg_manages.end()) {
+  // block 策略下 push 可能等待，不持锁
+  for (auto& [queue, msg] : due) {
+    queue->push(std::move(msg));
+  }
+}
+
+std::shared_ptr<ClientPublisher> CyberBridge::onWriterCreate(
+  const std::string& topic, const std::string& msg_type, const std::string& encoding) {
+  if (encoding != "json" && encoding != "protobuf") {
+    LOG_WARN << "unsupported client encoding: " << encoding << " topic: " << topic;
+    return nullptr;
+  }
+  std::lock_guard<std::mutex> lock(_topic_mutex);
+  auto info = TypeRegistry::instance().get(msg_type);
+  if (!info) {
+    return nullptr;
+  }
+  bool owns_manage = false;
+  if (!_msg_manages.contains(topic)) {
+    // 类型信息由 TypeRegistry 共享，这里只创建轻量句柄
     auto message = std::make_shared<mssageManage>();
     if (!message->init_type(msg_type)) {
       LOG_WARN << "subscribe topic: " << topic << " not found, please subscribe first";
-      return;
+      return nullptr;
     }
-    _msg_manages.insert({topic, message});
+    _msg_manages.insert(topic, 0, message);
+    owns_manage = true;
   }
-  if (_writers.find(topic) == _writers.end()) {
+  auto& writer = _writers[topic];
+  if (!writer) {
     cyber::proto::RoleAttributes attr;
     attr.set_channel_name(topic);
     attr.set_message_type(msg_type);
-    auto writer = _node->CreateWriter<MessageBase>(attr);
-    _writers[topic] = writer;
+    writer = _node->CreateWriter<MessageBase>(attr);
     LOG_INFO << "create writer for topic: " << topic << " msg_type: " << msg_type;
   } else {
     LOG_INFO << "writer for topic: " << topic << " already exists";
   }
-}
-void CyberBridge::onWriterDelete(const std::string& topic) {
-  if (_msg_manages.find(topic) != _msg_manages.end()) {
-    _msg_manages.erase(topic);
-  }
-  if (_writers.find(topic) != _writers.end()) {
-    _writers.erase(topic);
-    LOG_INFO << "delete writer for topic: " << topic;
-  } else {
-    LOG_INFO << "writer for topic: " << topic << " not found";
+  auto typed = std::dynamic_pointer_cast<cyber::Writer<MessageBase>>(writer);
+  auto& ref = _writer_refs[topic];
+  ref.owns_manage = ref.owns_manage || owns_manage;
+  if (!typed) {
+    if (ref.count == 0) {
+      _writers.erase(topic);
+      if (ref.owns_manage) {
+        _msg_manages.erase(topic);
+      }
+      _writer_refs.erase(topic);
+    }
+    return nullptr;
   }
+  ++ref.count;
+  return std::make_shared<ClientPublisher>(topic, info, encoding == "protobuf", typed);
 }
 
-void CyberBridge::onReceiveMsg(const std::string& topic, const std::string& msg) {
-  if (_writers.find(topic) == _writers.end()) {
-    LOG_WARN << "subscribe topic: " << topic << " not found, please subscribe first";
-    return;
-  }
-  auto msg_manage = _msg_manages[topic];
-  if (!msg_manage) {
+void CyberBridge::onWriterDelete(const std::string& topic) {
+  std::lock_guard<std::mutex> lock(_topic_mutex);
+  auto it = _writer_refs.find(topic);
+  if (it == _writer_refs.end()) {
+    LOG_INFO << "writer for topic: " << topic << " not found";
     return;
   }
-  auto raw_msg = std::make_shared<MessageBase>();
-  if (!msg_manage->getMsgFromJsonString(msg, raw_msg)) {
-    LOG_WARN << "receive msg for topic: " << topic << " msg_type: " << msg_manage->getType();
+  if (--it->second.count > 0) {
+    LOG_INFO << "writer for topic: " << topic << " still advertised by "
+             << it->second.count << " client channel(s)";
     return;
   }
-
-  auto write = std::dynamic_pointer_cast<cyber::Writer<MessageBase>>(_writers[topic]);
-  if (!write) {
-    return;
+  // 发现的 topic 的句柄由发现线程管理，只移除 advertise 时创建的句柄
+  if (it->second.owns_manage) {
+    _msg_manages.erase(topic);
   }
-  write->Write(raw_msg);
-  LOG_INFO << "receive msg for topic: " << topic << " msg_type: " << msg_manage->getType();
+  _writer_refs.erase(it);
+  _writers.erase(topic);
+  LOG_INFO << "delete writer for topic: " << topic;
 }
 
 void CyberBridge::onServiceRegister(const std::string& service_name) {
@@ -217,6 +440,7 @@ void CyberBridge::onServiceUnregister(const std::string& service_name) {
 }
 
 void CyberBridge::onClientRegister(const std::string& client_name) {
+  std::lock_guard<std::mutex> lock(_client_mutex);
   if (_clients.find(client_name) != _clients.end()) {
     return;
   }
@@ -225,27 +449,44 @@ void CyberBridge::onClientRegister(const std::string& client_name) {
   LOG_INFO << "register client: " << client_name;
 }
 
-void CyberBridge::onClientCall(const std::string& topic, const std::string& req, std::string& res) {
-  if (_clients.find(topic) != _clients.end()) {
-    auto& req_mgr = _services[topic].first;
-    auto& resp_mgr = _services[topic].second;
-    auto request = std::make_shared<MessageBase>();
-    req_mgr->getMsgFromJsonString(req, request);
-    auto response = std::make_shared<MessageBase>();
-    auto client =
-      std::dynamic_pointer_cast<cyber::Client<MessageBase, MessageBase>>(_clients[topic]);
-    response = client->SendRequest(request);
-    if (response) {
-      LOG_INFO << "client call success :" << response->TypeName();
-      res = resp_mgr->getMsgJsonString(response);
-    } else {
-      LOG_WARN << "client call failed";
-      return;
+bool CyberBridge::onClientCall(const std::string& topic, const std::string& req, std::string& res,
+  std::chrono::milliseconds timeout, std::string& error) {
+  std::shared_ptr<mssageManage> req_mgr;
+  std::shared_ptr<mssageManage> resp_mgr;
+  std::shared_ptr<cyber::Client<MessageBase, MessageBase>> client;
+  {
+    std::lock_guard<std::mutex> lock(_client_mutex);
+    auto client_it = _clients.find(topic);
+    auto service_it = _services.find(topic);
+    if (client_it == _clients.end() || service_it == _services.end()) {
+      LOG_WARN << "client: " << topic << " not found";
+      error = "service not found: " + topic;
+      return false;
     }
-
-  } else {
-    LOG_WARN << "client: " << topic << " not found";
+    req_mgr = service_it->second.first;
+    resp_mgr = service_it->second.second;
+    client =
+      std::dynamic_pointer_cast<cyber::Client<MessageBase, MessageBase>>(client_it->second);
+  }
+  auto request = std::make_shared<MessageBase>();
+  if (!client || !req_mgr->getMsgFromJsonString(req, request)) {
+    error = "invalid request for service: " + topic;
+    return false;
+  }
+  auto future = client->AsyncSendRequest(request);
+  if (!future.valid() || future.wait_for(timeout) != std::future_status::ready) {
+    LOG_WARN << "client call timeout: " << topic << " after " << timeout.count() << "ms";
+    error = "service call timed out after " + std::to_string(timeout.count()) + "ms: " + topic;
+    return false;
   }
+  auto response = future.get();
+  if (!response) {
+    LOG_WARN << "client call failed: " << topic;
+    error = "service call failed: " + topic;
+    return false;
+  }
+  res = resp_mgr->getMsgJsonString(response);
+  return true;
 }
 
 void CyberBridge::onClientUnregister(const std::string& client_name) {
@@ -301,12 +542,50 @@ bool CyberBridge::start() {
     _node = cyber::CreateNode("cyber_bridge");
     LOG_INFO << "create node: " << _node->Name();
   }
+  if (!_dispatcher) {
+    _dispatcher = std::make_unique<Dispatcher>(
+      BridgeConfig::instance().global().value("dispatch_threads", 2u));
+  }
+  for (const auto& server : BridgeConfig::instance().servers()) {
+    if (!_server_dispatchers.count(server.name)) {
+      _server_dispatchers[server.name] = std::make_unique<Dispatcher>(server.dispatch_threads);
+    }
+  }
+  if (!_rate_timer) {
+    // window 模式的尾部消息由该定时器补发，精度即窗口边界的最大延迟
+    _rate_timer = std::make_shared<cyber::Timer>(
+      10,
+      [this]() {
+        flushRateWindows();
+      },
+      false);
+    _rate_timer->Start();
+  }
   LOG_INFO << "start cyber bridge";
   return true;
 }
 
 void CyberBridge::stop() {
-  _timer->Stop();
+  if (_change_conn.IsConnected()) {
+    cyber::service_discovery::TopologyManager::Instance()->RemoveChangeListener(_change_conn);
+  }
+  if (_timer) {
+    _timer->Stop();
+  }
+  if (_rate_timer) {
+    _rate_timer->Stop();
+  }
   _node->ClearData();
+  if (_dispatcher) {
+    _dispatcher->stop();
+  }
+  for (auto& [name, dispatcher] : _server_dispatchers) {
+    dispatcher->stop();
+  }
   LOG_INFO << "stop cyber bridge";
 }
+
+Dispatcher* CyberBridge::dispatcherFor(const std::string& server) {
+  auto it = _server_dispatchers.find(server);
+  return it == _server_dispatchers.end() ? _dispatcher.get() : it->second.get();
+}
@@ -0,0 +1,76 @@
+#include "Dispatcher.hpp"
+
+#include "logger/log.h"
+
+Dispatcher::Dispatcher(size_t threads, size_t budget)
+    : _budget(budget > 0 ? budget : 1) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back(&Dispatcher::workerLoop, this);
+  }
+  LOG_INFO << "dispatcher started, threads: " << threads;
+}
+
+Dispatcher::~Dispatcher() {
+  stop();
+}
+
+void Dispatcher::schedule(DispatchQueue& queue) {
+  // 已在就绪队列或正在被消费，由当前消费者负责处理新数据
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (queue._scheduled.exchange(true)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopped) {
+      return;
+    }
+    _ready.push_back(queue.shared_from_this());
+  }
+  _cv.notify_one();
+}
+
+void Dispatcher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopped) {
+      return;
+    }
+    _stopped = true;
+    _ready.clear();
+  }
+  _cv.notify_all();
+  for (auto& worker : _workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  LOG_INFO << "dispatcher stopped";
+}
+
+void Dispatcher::workerLoop() {
+  for (;;) {
+    std::shared_ptr<DispatchQueue> queue;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [this]() {
+        return _stopped || !_ready.empty();
+      });
+      if (_stopped) {
+        return;
+      }
+      queue = std::move(_ready.front());
+      _ready.pop_front();
+    }
+    queue->drain(_budget);
+    queue->_scheduled.store(false);
+    // 释放标记后再次检查，避免生产者在 drain 结束前写入的数据无人处理
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!queue->empty()) {
+      schedule(*queue);
+    }
+  }
+}
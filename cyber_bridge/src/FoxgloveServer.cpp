@@ -3,16 +3,20 @@
 #include <foxglove/context.hpp>
 #include <foxglove/error.hpp>
 #include <foxglove/foxglove.hpp>
+#include <foxglove/schemas.hpp>
 #include <foxglove/server/parameter.hpp>
 
+#include "BridgeConfig.hpp"
 #include "MessageConverter.hpp"
+#include "protoPool.hpp"
 #ifdef USE_CYBER_BRIDGE
 #include "CyberBridge.hpp"
 #else
 #include "FastDDSBridge.hpp"
 #endif
-#include <filesystem>
+#include <algorithm>
 #include <nlohmann/json.hpp>
+#include <sstream>
 
 #include "logger/log.h"
 
@@ -21,6 +25,53 @@ using namespace std::chrono_literals;
 using namespace std::string_literals;
 using namespace std::string_view_literals;
 
+// 限频参数名：rate.<topic 或通配>，值为 max_hz=10 / every_n=5 / window_ms=100 / off
+constexpr std::string_view kRateParamPrefix = "rate.";
+// 点云降采样参数名：cloud.<topic 或通配>，值为 voxel=0.1,range=1:80,roi=...,intensity=1 / off
+constexpr std::string_view kCloudParamPrefix = "cloud.";
+// 派生通道参数名：projection.<输出 topic>，值为 <source>:<field>,<name>=<expr>,... / off
+constexpr std::string_view kProjectionParamPrefix = "projection.";
+// 录制参数：record.enabled 开关录制，record.topics 为逗号分隔的 topic 通配，record.file 只读
+constexpr std::string_view kRecordEnabledParam = "record.enabled";
+constexpr std::string_view kRecordTopicsParam = "record.topics";
+constexpr std::string_view kRecordFileParam = "record.file";
+// 回看参数：rewind.snapshot 设为 true 冻结缓冲并启动回看服务，false 关闭；rewind.status 只读
+constexpr std::string_view kRewindSnapshotParam = "rewind.snapshot";
+constexpr std::string_view kRewindStatusParam = "rewind.status";
+
+std::string joinTopics(const std::vector<std::string>& topics) {
+  std::string result;
+  for (const auto& topic : topics) {
+    if (!result.empty()) {
+      result += ",";
+    }
+    result += topic;
+  }
+  return result;
+}
+
+std::vector<std::string> splitTopics(const std::string& value) {
+  std::vector<std::string> result;
+  std::stringstream stream(value);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    item.erase(0, item.find_first_not_of(" \t"));
+    item.erase(item.find_last_not_of(" \t") + 1);
+    if (!item.empty()) {
+      result.push_back(item);
+    }
+  }
+  return result;
+}
+
+// 开关类参数，支持 bool 与 "true" 字符串
+bool paramFlag(const foxglove::ParameterView& param) {
+  if (param.is<bool>()) {
+    return param.get<bool>();
+  }
+  return param.is<std::string>() && param.get<std::string>() == "true";
+}
+
 std::vector<std::byte> makeBytes(std::string_view sv) {
   const auto* data = reinterpret_cast<const std::byte*>(sv.data());
   return {data, data + sv.size()};
@@ -39,11 +90,9 @@ FoxgloveServer::~FoxgloveServer() {
   stop();
 }
 
-bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
+foxglove::WebSocketServerOptions FoxgloveServer::serverOptions(uint8_t index) {
   foxglove::WebSocketServerOptions ws_options;
   ws_options.name = "FoxgloveServer";
-  ws_options.host = ipAddress;
-  ws_options.port = port;
   // hack for foxglove studio
   std::map<std::string, std::string> serverInfo = {{"ROS_DISTRO", "humble"}};
   ws_options.server_info = std::move(serverInfo);
@@ -53,62 +102,85 @@ bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
                             foxglove::WebSocketServerCapabilities::Parameters;
   // ws_options.capabilities = foxglove::WebSocketServerCapabilities::Services;
   ws_options.supported_encodings = {"json", "protobuf"};
+  if (index > 0) {
+    // 服务、参数与连接图只在主服务上提供
+    ws_options.name += "/" + _endpoints[index - 1].name;
+    ws_options.capabilities = foxglove::WebSocketServerCapabilities::ClientPublish;
+  }
   ws_options.callbacks.onConnectionGraphSubscribe = []() {
     LOG_INFO << "Connection graph subscribed";
   };
   ws_options.callbacks.onConnectionGraphUnsubscribe = []() {
     LOG_INFO << "Connection graph unsubscribed";
   };
-  ws_options.callbacks.onClientAdvertise = [this](uint32_t clientId,
+  ws_options.callbacks.onClientAdvertise = [this, index](uint32_t clientId,
                                              const foxglove::ClientChannel& channel) {
-    _client_channels.insert(std::make_pair(channel.id, std::string(channel.topic)));
-    _bridge->onWriterCreate(std::string(channel.topic), std::string(channel.schema_name));
+    auto publisher = _bridge->onWriterCreate(std::string(channel.topic),
+      std::string(channel.schema_name), std::string(channel.encoding));
+    if (!publisher) {
+      LOG_WARN << "Failed to create client channel: " << channel.topic
+               << " type:" << channel.schema_name << " encoding:" << channel.encoding;
+      return;
+    }
+    std::shared_ptr<ClientPublisher> replaced;
+    {
+      std::lock_guard<std::mutex> lock(_client_mutex);
+      auto& slot = _client_channels[{clientKey(index, clientId), channel.id}];
+      replaced = std::move(slot);
+      slot = publisher;
+    }
+    // 同一客户端通道重复 advertise 时释放旧句柄的引用，writer 计数保持一致
+    if (replaced) {
+      _bridge->onWriterDelete(replaced->topic());
+    }
     LOG_INFO << "Client id: " << clientId << " channel:" << channel.id << " topic:" << channel.topic
          << " type:" << channel.schema_name << " encoding:" << channel.encoding;
   };
-  ws_options.callbacks.onClientUnadvertise = [this](uint32_t clientId, uint32_t clientChannelId) {
-    if (_client_channels.find(clientChannelId) == _client_channels.end()) return;
-    _bridge->onWriterDelete(_client_channels[clientChannelId]);
-    _client_channels.erase(clientChannelId);
-    LOG_INFO << "Client unadvertised: " << clientId << " " << clientChannelId;
+  ws_options.callbacks.onClientUnadvertise = [this, index](
+                                               uint32_t clientId, uint32_t clientChannelId) {
+    std::shared_ptr<ClientPublisher> publisher;
+    {
+      std::lock_guard<std::mutex> lock(_client_mutex);
+      auto it = _client_channels.find({clientKey(index, clientId), clientChannelId});
+      if (it == _client_channels.end()) {
+        return;
+      }
+      publisher = std::move(it->second);
+      _client_channels.erase(it);
+    }
+    _bridge->onWriterDelete(publisher->topic());
+    LOG_INFO << "Client unadvertised: " << clientId << " " << clientChannelId
+         << " published: " << publisher->published() << " errors: " << publisher->errors();
   };
+  // 每条消息只查一次表，数据直接交给 advertise 时解析好的 ClientPublisher
   ws_options.callbacks.onMessageData =
-    [this](uint32_t clientId, uint32_t clientChannelId, const std::byte* data, size_t dataLen) {
-      if (_client_channels.find(clientChannelId) == _client_channels.end()) {
+    [this, index](
+      uint32_t clientId, uint32_t clientChannelId, const std::byte* data, size_t dataLen) {
+      std::shared_ptr<ClientPublisher> publisher;
+      {
+        std::lock_guard<std::mutex> lock(_client_mutex);
+        auto it = _client_channels.find({clientKey(index, clientId), clientChannelId});
+        if (it != _client_channels.end()) {
+          publisher = it->second;
+        }
+      }
+      if (!publisher) {
         LOG_WARN << "Client channel not found: " << clientChannelId << " client id:" << clientId;
         return;
       }
-      std::string msg = std::string(reinterpret_cast<const char*>(data), dataLen);
-      _bridge->onReceiveMsg(_client_channels[clientChannelId], msg);
-      LOG_INFO << "Received message: " << clientId << " " << clientChannelId << " " << dataLen
-           << " bytes";
+      publisher->publish(data, dataLen);
     };
-  ws_options.callbacks.onSubscribe = [this](uint64_t channel_id,
+  ws_options.callbacks.onSubscribe = [this, index](uint64_t channel_id,
                                        const foxglove::ClientMetadata& client) {
-    for (auto& [topic, channel] : _channels) {
-      LOG_INFO << "Subscribed to channel: " << channel_id << " client id:" << client.id
-           << " name:" << topic;
-      if (channel.channel->id() == channel_id) {
-        if (channel.sub_count++ > 1) return;
-        _bridge->onSubscribe(topic,
-          std::bind(
-            &FoxgloveServer::sendMessage, this, std::placeholders::_1, std::placeholders::_2));
-        return;
-      }
-    }
+    onChannelSubscribe(channel_id, {clientKey(index, client.id), client.sink_id});
   };
-  ws_options.callbacks.onUnsubscribe = [this](uint64_t channel_id,
+  ws_options.callbacks.onUnsubscribe = [this, index](uint64_t channel_id,
                                          const foxglove::ClientMetadata& client) {
-    for (auto& [topic, channel] : _channels) {
-      if (channel.channel->id() == channel_id) {
-        LOG_INFO << "Unsubscribed from channel: " << channel_id << " client id:" << client.id
-             << " name:" << topic;
-        if (channel.sub_count-- > 0) return;
-        _bridge->onUnsubscribe(topic);
-        return;
-      }
-    }
+    onChannelUnsubscribe(channel_id, {clientKey(index, client.id), client.sink_id});
   };
+  if (index > 0) {
+    return ws_options;
+  }
   ws_options.callbacks.onParametersSubscribe =
     [this](const std::vector<std::string_view>& parameterNames) {
       LOG_INFO << "Parameters subscribed: " << parameterNames.size();
@@ -155,6 +227,11 @@ bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
           result.emplace_back(param.Name());
       }
     }
+    getRateParameters(param_names, result);
+    getCloudParameters(param_names, result);
+    getProjectionParameters(param_names, result);
+    getRecordParameters(param_names, result);
+    getRewindParameters(param_names, result);
     return result;
   };
   ws_options.callbacks.onSetParameters =
@@ -171,6 +248,78 @@ bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
     for (const auto& param : params) {
       std::cerr << " - " << param.name();
       const std::string name(param.name());
+      if (name.rfind(kRateParamPrefix, 0) == 0) {
+        RatePolicy policy;
+        if (!param.is<std::string>() || !RatePolicy::parse(param.get<std::string>(), policy)) {
+          std::cerr << " - invalid rate policy\n";
+          continue;
+        }
+        _bridge->setRatePolicy(name.substr(kRateParamPrefix.size()), policy);
+        std::cerr << " - rate: " << policy.toString() << "\n";
+        result.emplace_back(name, policy.toString());
+        continue;
+      }
+      if (name.rfind(kCloudParamPrefix, 0) == 0) {
+        CloudOptions options;
+        if (!param.is<std::string>() || !CloudOptions::parse(param.get<std::string>(), options)) {
+          std::cerr << " - invalid cloud options\n";
+          continue;
+        }
+        size_t matched = setCloudOptions(name.substr(kCloudParamPrefix.size()), options);
+        std::cerr << " - cloud: " << options.toString() << " topics: " << matched << "\n";
+        result.emplace_back(name, options.toString());
+        continue;
+      }
+      if (name.rfind(kProjectionParamPrefix, 0) == 0) {
+        std::string error;
+        if (!param.is<std::string>()) {
+          std::cerr << " - invalid projection\n";
+          continue;
+        }
+        const std::string& text = param.get<std::string>();
+        if (!setProjection(name.substr(kProjectionParamPrefix.size()), text, error)) {
+          std::cerr << " - invalid projection: " << error << "\n";
+          continue;
+        }
+        std::cerr << " - projection: " << text << "\n";
+        result.emplace_back(name, text);
+        continue;
+      }
+      if (name == kRecordEnabledParam) {
+        bool enabled = paramFlag(param);
+        bool ok = true;
+        if (enabled) {
+          ok = startRecording();
+        } else {
+          stopRecording();
+        }
+        std::cerr << (ok ? " - updated\n" : " - failed\n");
+        result.emplace_back(name, _recorder && _recorder->recording());
+        continue;
+      }
+      if (name == kRewindSnapshotParam) {
+        bool enabled = paramFlag(param);
+        std::string message = "stopped";
+        bool ok = true;
+        if (enabled) {
+          ok = startRewind(message);
+        } else {
+          stopRewind();
+        }
+        std::cerr << " - " << message << "\n";
+        result.emplace_back(name, ok && enabled);
+        continue;
+      }
+      if (name == kRecordTopicsParam) {
+        if (!param.is<std::string>()) {
+          std::cerr << " - invalid topics\n";
+          continue;
+        }
+        setRecordTopics(splitTopics(param.get<std::string>()));
+        std::cerr << " - updated\n";
+        result.emplace_back(name, joinTopics(_recorder->options().topics));
+        continue;
+      }
       if (auto it = _param_store.find(name); it != _param_store.end()) {
         if (name.find("read_only_") == 0) {
           std::cerr << " - not updated\n";
@@ -185,13 +334,91 @@ bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
     return result;
   };
 
+  return ws_options;
+}
+
+bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
+  _host = ipAddress;
+  _port = port;
+  // 服务回调会用到录制、执行器与缓存，全部创建后再开始接受连接，主服务最后启动
+  auto record_options =
+    RecordOptions::fromJson(BridgeConfig::instance().global().value("record", Json::object()));
+  _recorder = std::make_unique<McapRecorder>(record_options);
+  // 单个服务最多占用一半 worker，慢服务不会让其他服务的请求等到超时
+  size_t service_threads = BridgeConfig::instance().global().value("service_threads", 4u);
+  _service_executor = std::make_unique<ServiceExecutor>(
+    service_threads, std::max<size_t>(1, service_threads / 2));
+  _image_executor = std::make_unique<ServiceExecutor>(
+    BridgeConfig::instance().global().value("image_threads", 2u));
+  _latch = std::make_unique<LatchCache>(
+    static_cast<size_t>(BridgeConfig::instance().global().value("latch_max_mb", 64u)) << 20);
+  _batch_flusher = std::make_unique<BatchFlusher>();
+  auto tf_options =
+    TfOptions::fromJson(BridgeConfig::instance().global().value("tf", Json::object()));
+  if (tf_options.enabled) {
+    _tf = std::make_shared<TfAggregator>(tf_options);
+    if (!_tf->start()) {
+      _tf.reset();
+    }
+  }
+  auto rewind_options =
+    RewindOptions::fromJson(BridgeConfig::instance().global().value("rewind", Json::object()));
+  if (rewind_options.enabled) {
+    _rewind = std::make_unique<RewindBuffer>(rewind_options);
+  }
+  BridgeMetrics::instance().addCollector([this](BridgeMetrics::Values& values) {
+    _latch->collect(values);
+    _batch_flusher->collect(values);
+    if (_tf) {
+      _tf->collect(values);
+    }
+    if (_rewind) {
+      _rewind->collect(values);
+    }
+    for (const auto& stats : getForwardStats()) {
+      const std::string name = BridgeMetrics::topicName(stats.topic) + "_forward";
+      values[name + "_msgs"] = stats.messages;
+      values[name + "_bytes"] = stats.bytes;
+      values[name + "_converted"] = stats.converted;
+      values[name + "_errors"] = stats.errors;
+    }
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    for (const auto& [topic, stage] : _stages) {
+      stage->collect(values);
+    }
+  });
+  startBacklogMonitor();
+  startStats();
+  startEndpoints(ipAddress, port);
+  for (const auto& endpoint : _endpoints) {
+    _recorder->addContext(endpoint.name, endpoint.context);
+  }
+  _recorder->setFileCallback([this](const std::string& path) {
+    if (_server) {
+      (void)_server->publishStatus(
+        foxglove::WebSocketServerStatusLevel::Info, "recording to " + path, "record");
+    }
+  });
+  auto ws_options = serverOptions(0);
+  ws_options.host = ipAddress;
+  ws_options.port = port;
   auto server_result = foxglove::WebSocketServer::create(std::move(ws_options));
   if (!server_result.has_value()) {
     LOG_ERROR << "Failed to create server: " << foxglove::strerror(server_result.error());
+    shutdown();
     return false;
   }
   _server = std::make_unique<foxglove::WebSocketServer>(std::move(server_result.value()));
   LOG_INFO << "conncet to :" << ipAddress << ":" << port;
+  if (record_options.enabled && !startRecording()) {
+    LOG_WARN << "Failed to start recording in: " << record_options.dir;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    for (const auto& spec : BridgeConfig::instance().projections()) {
+      _projection_specs[spec.topic] = spec;
+    }
+  }
   _bridge->startDiscoverTimer(
     [this](const std::string& topic,
       Schema& schema_1,
@@ -209,108 +436,1069 @@ bool FoxgloveServer::start(const std::string& ipAddress, uint16_t port) {
   return true;
 }
 
-bool FoxgloveServer::start(const std::string& filePath, const std::string& filename) {
-  std::string full_filePath = std::filesystem::path(filePath).append(filename).string();
-  foxglove::McapWriterOptions options;
-  options.path = full_filePath;
-  auto result = foxglove::McapWriter::create(options);
-  if (!result.has_value()) {
-    LOG_ERROR << "Failed to create MCAP writer: " << foxglove::strerror(result.error());
+bool FoxgloveServer::startRecording() {
+  if (!_recorder->start()) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  syncRecordedSources();
+  return true;
+}
+
+void FoxgloveServer::stopRecording() {
+  if (!_recorder->recording()) {
+    return;
+  }
+  _recorder->stop();
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    syncRecordedSources();
+  }
+  if (_server) {
+    (void)_server->publishStatus(
+      foxglove::WebSocketServerStatusLevel::Info, "recording stopped", "record");
+  }
+}
+
+void FoxgloveServer::setRecordTopics(const std::vector<std::string>& topics) {
+  _recorder->setTopics(topics);
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  syncRecordedSources();
+}
+
+bool FoxgloveServer::isRecorded(std::string_view topic) {
+  return _recorder && _recorder->recording() && _recorder->matches(std::string(topic));
+}
+
+void FoxgloveServer::syncRecordedSources() {
+  std::set<std::string> wanted;
+  bool recording = _recorder && _recorder->recording();
+  if (recording || _rewind) {
+    auto channels = _channels.read();
+    for (const auto& [topic, channel] : channels->by_topic) {
+      if ((recording && _recorder->matches(topic)) || (_rewind && _rewind->matches(topic))) {
+        wanted.insert(channel->source);
+      }
+    }
+  }
+  for (auto it = _recorded_sources.begin(); it != _recorded_sources.end();) {
+    if (wanted.count(*it)) {
+      ++it;
+      continue;
+    }
+    releaseSource(*it);
+    it = _recorded_sources.erase(it);
+  }
+  for (const auto& source : wanted) {
+    if (!_recorded_sources.count(source) && acquireSource(source)) {
+      _recorded_sources.insert(source);
+    }
+  }
+  // 录制范围变化后，录制中的通道改回直接 log，否则按 sink id 发送的消息不会进入 MCAP
+  for (const auto& [source, handle] : _handles) {
+    refreshClients(*handle);
+  }
+}
+
+void FoxgloveServer::getRecordParameters(
+  const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result) {
+  if (!_recorder) {
+    return;
+  }
+  auto wanted = [&names](std::string_view name) {
+    return names.empty() || std::find(names.begin(), names.end(), name) != names.end();
+  };
+  if (wanted(kRecordEnabledParam)) {
+    result.emplace_back(kRecordEnabledParam, _recorder->recording());
+  }
+  if (wanted(kRecordTopicsParam)) {
+    result.emplace_back(kRecordTopicsParam, joinTopics(_recorder->options().topics));
+  }
+  if (wanted(kRecordFileParam)) {
+    result.emplace_back(kRecordFileParam, joinTopics(_recorder->currentFiles()));
+  }
+}
+
+bool FoxgloveServer::startRewind(std::string& message) {
+  if (!_rewind) {
+    message = "rewind is not enabled";
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(_rewind_mutex);
+  if (_rewind_player) {
+    _rewind_player->stop();
+    _rewind_player.reset();
+  }
+  auto player = std::make_unique<RewindPlayer>(_rewind->snapshot());
+  uint16_t port = _rewind->options().port > 0 ? _rewind->options().port
+                                              : static_cast<uint16_t>(_port + 100);
+  if (!player->start(_host, port)) {
+    message = "failed to start rewind server on port " + std::to_string(port);
+    return false;
+  }
+  const auto& snapshot = player->snapshot();
+  std::stringstream stream;
+  stream << "rewind " << (snapshot.end_ns - snapshot.begin_ns) / 1000000000.0 << " s, "
+         << snapshot.channels.size() << " topics on port " << player->port();
+  message = stream.str();
+  _rewind_player = std::move(player);
+  if (_server) {
+    (void)_server->publishStatus(foxglove::WebSocketServerStatusLevel::Info, message, "rewind");
+  }
+  return true;
+}
+
+void FoxgloveServer::stopRewind() {
+  std::lock_guard<std::mutex> lock(_rewind_mutex);
+  if (_rewind_player) {
+    _rewind_player->stop();
+    _rewind_player.reset();
+  }
+}
+
+void FoxgloveServer::getRewindParameters(
+  const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result) {
+  if (!_rewind) {
+    return;
+  }
+  auto wanted = [&names](std::string_view name) {
+    return names.empty() || std::find(names.begin(), names.end(), name) != names.end();
+  };
+  std::lock_guard<std::mutex> lock(_rewind_mutex);
+  if (wanted(kRewindSnapshotParam)) {
+    result.emplace_back(kRewindSnapshotParam, _rewind_player != nullptr);
+  }
+  if (wanted(kRewindStatusParam)) {
+    std::string status = "idle";
+    if (_rewind_player) {
+      const auto& snapshot = _rewind_player->snapshot();
+      status = "port " + std::to_string(_rewind_player->port()) + ", " +
+               std::to_string((snapshot.end_ns - snapshot.begin_ns) / 1000000) + " ms, " +
+               std::to_string(snapshot.messages.size()) + " messages";
+    }
+    result.emplace_back(kRewindStatusParam, status);
+  }
+}
+
+void FoxgloveServer::getRateParameters(
+  const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result) {
+  auto& config = BridgeConfig::instance();
+  if (!names.empty()) {
+    for (const auto& name : names) {
+      if (name.rfind(kRateParamPrefix, 0) != 0) {
+        continue;
+      }
+      std::string pattern(name.substr(kRateParamPrefix.size()));
+      std::string spec = config.resolve(pattern).rate.toString();
+      for (const auto& [rule, policy] : config.rateOverrides()) {
+        if (rule == pattern) {
+          spec = policy.toString();
+        }
+      }
+      result.emplace_back(name, spec);
+    }
+    return;
+  }
+  // 列出所有运行时设置的通配规则及每个原始通道当前生效的策略，便于在 Parameters 面板中修改
+  std::set<std::string> listed;
+  for (const auto& [pattern, policy] : config.rateOverrides()) {
+    result.emplace_back(std::string(kRateParamPrefix) + pattern, policy.toString());
+    listed.insert(pattern);
+  }
+  auto channels = _channels.read();
+  for (const auto& [topic, channel] : channels->by_topic) {
+    if (channel->source != topic || listed.count(topic)) {
+      continue;
+    }
+    result.emplace_back(
+      std::string(kRateParamPrefix) + topic, config.resolve(topic).rate.toString());
+  }
+}
+
+void FoxgloveServer::onChannelSubscribe(
+  uint64_t channel_id, const foxglove::ClientMetadata& client) {
+  // tf 汇总通道不对应 cyber topic，源 topic 在创建时已保持订阅，只需补发当前的变换
+  if (_tf && _tf->owns(channel_id)) {
+    if (client.sink_id) {
+      _tf->onSubscribe(channel_id, *client.sink_id);
+    }
+    return;
+  }
+  auto channel = _channels.getId(channel_id);
+  if (!channel) {
+    return;
+  }
+  std::shared_ptr<ForwardHandle> handle;
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    channel->sub_count++;
+    LOG_INFO << "Subscribed to channel: " << channel_id << " client id:" << client.id
+             << " name:" << channel->channel->topic() << " subscribers:" << channel->sub_count;
+    _channel_clients[channel_id].insert(client.id);
+    if (_backlog && client.sink_id) {
+      auto* server = serverOf(client.id);
+      _backlog->acquire(client.id, *client.sink_id, server ? server->port() : 0);
+    }
+    if (acquireSource(channel->source)) {
+      if (auto it = _handles.find(channel->source); it != _handles.end()) {
+        handle = it->second;
+      }
+    }
+  }
+  // 只发给新订阅的客户端，其他客户端不会重复收到；转换在锁外进行
+  if (handle && handle->latch && client.sink_id) {
+    handle->sendLatched(channel->channel, *client.sink_id);
+  }
+}
+
+bool FoxgloveServer::acquireSource(const std::string& source) {
+  if (_source_refs[source]++ > 0) {
+    if (auto it = _handles.find(source); it != _handles.end()) {
+      refreshClients(*it->second);
+    }
+    return true;
+  }
+  auto handle = makeForwardHandle(source);
+  if (!handle) {
+    _source_refs.erase(source);
     return false;
   }
-  _mcapWriter = std::make_unique<foxglove::McapWriter>(std::move(result.value()));
-  LOG_INFO << "Created MCAP writer for file: " << full_filePath;
+  _handles[source] = handle;
+  refreshClients(*handle);
+  _bridge->onSubscribe(source,
+    [handle](const std::string& /*topic*/, const std::string& message,
+      const google::protobuf::Message* parsed) {
+      handle->forward(message, parsed);
+    });
   return true;
 }
 
+void FoxgloveServer::releaseSource(const std::string& source) {
+  auto it = _source_refs.find(source);
+  if (it == _source_refs.end() || --it->second > 0) {
+    return;
+  }
+  _source_refs.erase(it);
+  _bridge->onUnsubscribe(source);
+  if (auto handle_it = _handles.find(source); handle_it != _handles.end()) {
+    auto stats = handle_it->second->stats();
+    LOG_INFO << "topic: " << stats.topic << " forwarded: " << stats.messages
+             << " bytes: " << stats.bytes << " converted: " << stats.converted
+             << " errors: " << stats.errors;
+    _handles.erase(handle_it);
+  }
+}
+
+void FoxgloveServer::refreshClients(ForwardHandle& handle) {
+  if (!_backlog) {
+    return;
+  }
+  auto build = [this](const std::shared_ptr<foxglove::RawChannel>& channel) {
+    auto clients = std::make_shared<ForwardHandle::ClientList>();
+    if (isRecorded(channel->topic())) {
+      // 录制中的通道需要经过 MCAP sink，不做按客户端背压
+      return std::shared_ptr<const ForwardHandle::ClientList>();
+    }
+    auto it = _channel_clients.find(channel->id());
+    if (it == _channel_clients.end()) {
+      return std::shared_ptr<const ForwardHandle::ClientList>(clients);
+    }
+    for (uint32_t client_id : it->second) {
+      auto backlog = _backlog->find(client_id);
+      if (!backlog) {
+        // 没有 sink id 的客户端无法单独发送，该通道退回为直接 log 给所有 sink
+        return std::shared_ptr<const ForwardHandle::ClientList>();
+      }
+      clients->push_back(std::move(backlog));
+    }
+    return std::shared_ptr<const ForwardHandle::ClientList>(clients);
+  };
+  handle.setClients(false, build(handle.raw));
+  if (handle.converted) {
+    handle.setClients(true, build(handle.converted));
+  }
+}
+
+void FoxgloveServer::startEndpoints(const std::string& ipAddress, uint16_t port) {
+  auto servers = BridgeConfig::instance().servers();
+  // 回调按序号访问 _endpoints，创建过程中不能重新分配
+  _endpoints.reserve(servers.size());
+  for (const auto& options : servers) {
+    if (_endpoints.size() >= kMaxEndpoints) {
+      LOG_WARN << "Too many servers, skip: " << options.name;
+      continue;
+    }
+    uint8_t index = static_cast<uint8_t>(_endpoints.size() + 1);
+    Endpoint endpoint;
+    endpoint.name = options.name;
+    endpoint.context = foxglove::Context::create();
+    _endpoints.push_back(std::move(endpoint));
+    auto ws_options = serverOptions(index);
+    ws_options.host = ipAddress;
+    ws_options.port = options.port > 0 ? options.port : static_cast<uint16_t>(port + index);
+    ws_options.context = _endpoints.back().context;
+    uint16_t server_port = ws_options.port;
+    auto server_result = foxglove::WebSocketServer::create(std::move(ws_options));
+    if (!server_result.has_value()) {
+      // 该分类的 topic 回退到主服务
+      LOG_ERROR << "Failed to create server " << options.name << ": "
+                << foxglove::strerror(server_result.error());
+      _endpoints.pop_back();
+      continue;
+    }
+    _endpoints.back().server =
+      std::make_unique<foxglove::WebSocketServer>(std::move(server_result.value()));
+    LOG_INFO << "server " << options.name << " listening on: " << ipAddress << ":" << server_port;
+  }
+  BridgeMetrics::instance().addCollector([this](BridgeMetrics::Values& values) {
+    collectEndpoints(values);
+  });
+}
+
+uint8_t FoxgloveServer::endpointFor(const std::string& topic) {
+  std::string name = BridgeConfig::instance().resolve(topic).server;
+  if (name.empty()) {
+    return 0;
+  }
+  for (size_t i = 0; i < _endpoints.size(); ++i) {
+    if (_endpoints[i].name == name) {
+      return static_cast<uint8_t>(i + 1);
+    }
+  }
+  LOG_WARN << "Server not found: " << name << " topic: " << topic << ", use main server";
+  return 0;
+}
+
+foxglove::Context FoxgloveServer::contextOf(uint8_t index) const {
+  return index == 0 ? foxglove::Context() : _endpoints[index - 1].context;
+}
+
+foxglove::WebSocketServer* FoxgloveServer::serverOf(uint32_t client_key) const {
+  size_t index = client_key >> kClientIdBits;
+  if (index == 0) {
+    return _server.get();
+  }
+  return index <= _endpoints.size() ? _endpoints[index - 1].server.get() : nullptr;
+}
+
+void FoxgloveServer::collectEndpoints(BridgeMetrics::Values& values) {
+  size_t count = _endpoints.size() + 1;
+  std::vector<uint64_t> channels(count), clients(count), messages(count), bytes(count);
+  auto snapshot = _channels.read();
+  for (const auto& [topic, channel] : snapshot->by_topic) {
+    channels[channel->server]++;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    std::set<uint32_t> keys;
+    for (const auto& [channel_id, ids] : _channel_clients) {
+      keys.insert(ids.begin(), ids.end());
+    }
+    for (uint32_t key : keys) {
+      if ((key >> kClientIdBits) < count) {
+        clients[key >> kClientIdBits]++;
+      }
+    }
+    for (const auto& [source, handle] : _handles) {
+      auto* channel = snapshot->find(source);
+      if (!channel) {
+        continue;
+      }
+      auto stats = handle->stats();
+      messages[channel->server] += stats.messages;
+      bytes[channel->server] += stats.bytes;
+    }
+  }
+  for (size_t i = 0; i < count; ++i) {
+    std::string name = "fox_bridge_server_" + (i == 0 ? "main"s : _endpoints[i - 1].name);
+    values[name + "_channels"] = channels[i];
+    values[name + "_clients"] = clients[i];
+    values[name + "_msgs"] = messages[i];
+    values[name + "_bytes"] = bytes[i];
+  }
+}
+
+void FoxgloveServer::startBacklogMonitor() {
+  const auto& config = BridgeConfig::instance().global();
+  double budget_mbps = config.value("client_budget_mbps", 0.0);
+  if (budget_mbps <= 0) {
+    return;
+  }
+  uint32_t threshold_ms = config.value("client_backlog_ms", 500u);
+  _backlog = std::make_unique<BacklogMonitor>(
+    static_cast<uint64_t>(budget_mbps * 1000 * 1000 / 8), threshold_ms);
+  BridgeMetrics::instance().addCollector([backlog = _backlog.get()](BridgeMetrics::Values& values) {
+    backlog->collect(values);
+  });
+  _backlog->start(
+    [this](uint64_t now_ns) {
+      std::vector<std::shared_ptr<ForwardHandle>> handles;
+      {
+        std::lock_guard<std::mutex> lock(_sub_mutex);
+        for (const auto& [topic, handle] : _handles) {
+          handles.push_back(handle);
+        }
+      }
+      for (auto& handle : handles) {
+        handle->flushLatest(now_ns);
+      }
+    },
+    [this](const BacklogStats& stats, bool lagging) {
+      // SDK 的 status 会发给该服务的所有客户端，消息中带上客户端 id
+      auto* server = serverOf(stats.client_id);
+      if (!server) {
+        return;
+      }
+      std::string id = "backlog." + std::to_string(stats.client_id);
+      if (!lagging) {
+        (void)server->removeStatus({id});
+        return;
+      }
+      std::string message = "client " + std::to_string(stats.client_id & kClientIdMask) +
+                            " is lagging: backlog " + std::to_string(stats.queued_bytes / 1024) +
+                            " KB (~" + std::to_string(stats.oldest_age_ms) +
+                            " ms), state topics keep latest, other topics drop frames";
+      (void)server->publishStatus(foxglove::WebSocketServerStatusLevel::Warning, message, id);
+    });
+}
+
+std::shared_ptr<ForwardHandle> FoxgloveServer::makeForwardHandle(const std::string& source) {
+  auto raw = _channels.get(source);
+  if (!raw || !raw->channel) {
+    LOG_WARN << "Channel not found: " << source;
+    return nullptr;
+  }
+  auto handle = std::make_shared<ForwardHandle>();
+  handle->topic = source;
+  auto options = BridgeConfig::instance().resolve(source);
+  if (_latch && options.latch) {
+    handle->latch = _latch->slot(source);
+  }
+  handle->lag_policy = options.lag_policy;
+  if (_rewind && _rewind->matches(source)) {
+    handle->rewind = _rewind->track(source, *raw->channel);
+  }
+  handle->msg_type = raw->type;
+  handle->raw = raw->channel;
+  handle->converter = MessageConverter::instance().find(raw->type);
+  if (_tf && handle->converter && handle->converter->transforms) {
+    handle->tf = _tf;
+    handle->tf_static = _tf->isStaticSource(source);
+  }
+  handle->metrics = BridgeMetrics::instance().topic(source);
+  if (auto it = _stages.find(source); it != _stages.end()) {
+    handle->async_converter = it->second;
+  }
+  if (auto it = _batches.find(source); it != _batches.end()) {
+    handle->batch = it->second;
+  }
+  handle->setProjections(projectionsOf(source));
+  if (handle->converter || handle->async_converter) {
+    if (auto converted = _channels.get(source + "/converted")) {
+      handle->converted = converted->channel;
+    }
+  }
+  return handle;
+}
+
+std::shared_ptr<AsyncConverter> FoxgloveServer::makeStage(
+  const std::string& topic, const std::string& type, foxglove::Schema& schema) {
+  auto options = BridgeConfig::instance().resolve(topic);
+  if (!options.cloud.enabled && !options.image.enabled()) {
+    return nullptr;
+  }
+  auto info = TypeRegistry::instance().get(type);
+  const auto* descriptor = info ? info->descriptor() : nullptr;
+  if (options.cloud.enabled && PointCloudStage::isCloudType(descriptor)) {
+    schema = foxglove::schemas::PointCloud::schema();
+    return std::make_shared<PointCloudStage>(
+      topic, info, options.cloud, BridgeMetrics::instance().topic(topic));
+  }
+  if (options.image.enabled() && ImageStage::isImageType(descriptor)) {
+    if (options.image.format == "jpeg" && !ImageEncoder::jpegSupported()) {
+      LOG_WARN << "Built without libjpeg, compress as png: " << topic;
+    }
+    schema = foxglove::schemas::CompressedImage::schema();
+    return std::make_shared<ImageStage>(topic, info, options.image, _image_executor.get(),
+      BridgeMetrics::instance().topic(topic));
+  }
+  LOG_WARN << "Skip cloud / image conversion, unsupported type: " << topic << " type: " << type;
+  return nullptr;
+}
+
+void FoxgloveServer::getCloudParameters(
+  const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result) {
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  for (const auto& [topic, stage] : _stages) {
+    auto cloud = std::dynamic_pointer_cast<PointCloudStage>(stage);
+    if (!cloud) {
+      continue;
+    }
+    std::string name = std::string(kCloudParamPrefix) + topic;
+    if (names.empty() || std::find(names.begin(), names.end(), name) != names.end()) {
+      result.emplace_back(name, cloud->options().toString());
+    }
+  }
+}
+
+size_t FoxgloveServer::setCloudOptions(const std::string& pattern, const CloudOptions& options) {
+  size_t matched = 0;
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  for (const auto& [topic, stage] : _stages) {
+    auto cloud = std::dynamic_pointer_cast<PointCloudStage>(stage);
+    if (cloud && BridgeConfig::match(pattern, topic)) {
+      cloud->setOptions(options);
+      ++matched;
+    }
+  }
+  return matched;
+}
+
+std::vector<ForwardStats> FoxgloveServer::getForwardStats() {
+  std::vector<ForwardStats> result;
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  result.reserve(_handles.size());
+  for (const auto& [topic, handle] : _handles) {
+    result.push_back(handle->stats());
+  }
+  return result;
+}
+
+void FoxgloveServer::onChannelUnsubscribe(
+  uint64_t channel_id, const foxglove::ClientMetadata& client) {
+  auto channel = _channels.getId(channel_id);
+  if (!channel) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  if (channel->sub_count == 0) {
+    return;
+  }
+  channel->sub_count--;
+  if (auto it = _channel_clients.find(channel_id); it != _channel_clients.end()) {
+    it->second.erase(client.id);
+    if (it->second.empty()) {
+      _channel_clients.erase(it);
+    }
+  }
+  if (_backlog && client.sink_id) {
+    _backlog->release(client.id);
+  }
+  if (auto it = _handles.find(channel->source); it != _handles.end()) {
+    refreshClients(*it->second);
+  }
+  LOG_INFO << "Unsubscribed from channel: " << channel_id << " client id:" << client.id
+           << " name:" << channel->channel->topic() << " subscribers:" << channel->sub_count;
+  releaseSource(channel->source);
+}
+
+void FoxgloveServer::startStats() {
+  const auto& config = BridgeConfig::instance().global();
+  std::string schema_data = R"({"type":"object","additionalProperties":{"type":"number"}})";
+  foxglove::Schema schema;
+  schema.name = "BridgeStats";
+  schema.encoding = "jsonschema";
+  schema.data = reinterpret_cast<const std::byte*>(schema_data.data());
+  schema.data_len = schema_data.size();
+  auto channel_result = foxglove::RawChannel::create("/bridge/stats", "json", schema);
+  if (!channel_result.has_value()) {
+    LOG_ERROR << "Failed to create channel: " << foxglove::strerror(channel_result.error());
+  } else {
+    _stats_channel = std::make_shared<foxglove::RawChannel>(std::move(channel_result.value()));
+    BridgeMetrics::instance().setPublisher(
+      [channel = _stats_channel](
+        const BridgeMetrics::Values& values, const BridgeMetrics::Values& latencies) {
+        if (!channel->has_sinks()) {
+          return;
+        }
+        Json stats = Json::object();
+        for (const auto& [key, value] : values) {
+          stats[key] = value;
+        }
+        for (const auto& [key, value] : latencies) {
+          stats[key] = value;
+        }
+        std::string data = stats.dump();
+        channel->log(reinterpret_cast<const std::byte*>(data.data()), data.size());
+      });
+  }
+#ifdef USE_CYBER_BRIDGE
+  BridgeMetrics::instance().addCollector([bridge = _bridge](BridgeMetrics::Values& values) {
+    for (const auto& stats : bridge->getQueueStats()) {
+      const std::string name = BridgeMetrics::topicName(stats.topic) + "_queue";
+      values[name + "_depth"] = stats.depth;
+      values[name + "_enqueued"] = stats.enqueued;
+      values[name + "_dropped"] = stats.dropped;
+    }
+    for (const auto& stats : bridge->getRateStats()) {
+      const std::string name = BridgeMetrics::topicName(stats.topic) + "_rate";
+      values[name + "_forwarded"] = stats.forwarded;
+      values[name + "_suppressed"] = stats.suppressed;
+    }
+  });
+#endif
+  BridgeMetrics::instance().start(
+    config.value("stats_interval_s", 10u), config.value("stats_dump_dir", std::string("stats")));
+}
+
 void FoxgloveServer::stop() {
-  _server->stop();
-  _server.reset();
-  _server = nullptr;
-  _channels.clear();
+  // 析构时会再次调用，未启动或已停止时直接返回
+  if (!_server) {
+    return;
+  }
+  shutdown();
   LOG_INFO << "Server stopped";
 }
 
+void FoxgloveServer::shutdown() {
+#ifdef USE_CYBER_BRIDGE
+  // 先停止 cyber reader 与分发线程，之后不会再有消息进入 forward()、各 stage 与执行器
+  _bridge->stop();
+#endif
+  if (_backlog) {
+    _backlog->stop();
+  }
+  if (_recorder) {
+    _recorder->stop();
+  }
+  stopRewind();
+  if (_batch_flusher) {
+    _batch_flusher->stop();
+  }
+  if (_tf) {
+    _tf->stop();
+  }
+  if (_server) {
+    _server->stop();
+    _server.reset();
+  }
+  for (auto& endpoint : _endpoints) {
+    endpoint.server->stop();
+  }
+  if (_service_executor) {
+    _service_executor->stop();
+  }
+  if (_image_executor) {
+    _image_executor->stop();
+  }
+  BridgeMetrics::instance().stop();
+  BridgeMetrics::instance().setPublisher(nullptr);
+  BridgeMetrics::instance().clearCollectors();
+  _stats_channel.reset();
+  _endpoints.clear();
+  _channels.clear();
+}
+
 bool FoxgloveServer::createChannel(const std::string& topic, Schema& sch_data) {
-  if (_channels.find(topic) != _channels.end()) {
+  if (_channels.contains(topic)) {
     // LOG_ERROR << "Channel already exists: " << topic;
     return false;
   }
+  if (_tf && _tf->isOutput(topic)) {
+    LOG_ERROR << "Topic conflicts with tf aggregation, skip: " << topic;
+    return false;
+  }
   foxglove::Schema schema;
   schema.name = sch_data.name;
   schema.data_len = sch_data.desc.length();
   schema.data = reinterpret_cast<const std::byte*>(sch_data.desc.c_str());
   schema.encoding = "protobuf";
-  auto channel_result = foxglove::RawChannel::create(topic, "protobuf", schema);
+  uint8_t server = endpointFor(topic);
+  auto context = contextOf(server);
+  auto channel_result = foxglove::RawChannel::create(topic, "protobuf", schema, context);
   if (!channel_result.has_value()) {
     LOG_ERROR << "Failed to create channel: " << foxglove::strerror(channel_result.error());
     return false;
   }
-  ChannelConfig channel_config;
-  channel_config.type = sch_data.name;
-  channel_config.channel =
+  auto channel_config = std::make_shared<ChannelConfig>();
+  channel_config->type = sch_data.name;
+  channel_config->source = topic;
+  channel_config->server = server;
+  channel_config->channel =
     std::make_shared<foxglove::RawChannel>(std::move(channel_result.value()));
-  _channels.insert({topic, std::move(channel_config)});
-  LOG_INFO << "Created channel: " << topic << " with type: " << sch_data.name;
-
-  if (MessageConverter::instance().hasConverter(sch_data.name) &&
-      (_channels.find(topic + "/converted") == _channels.end())) {
-    schema.name = MessageConverter::instance().getTargetTypeName(sch_data.name);
-    std::string data = MessageConverter::instance().getTargetDescriptorString(sch_data.name);
-    schema.data_len = data.length();
-    schema.data = reinterpret_cast<const std::byte*>(data.c_str());
-    channel_result = foxglove::RawChannel::create(topic + "/converted", "protobuf", schema);
+  _channels.insert(topic, channel_config->channel->id(), channel_config);
+  LOG_INFO << "Created channel: " << topic << " with type: " << sch_data.name
+           << " server: " << (server == 0 ? "main" : _endpoints[server - 1].name);
+
+  const auto* converter = MessageConverter::instance().find(sch_data.name);
+  auto target = TypeRegistry::instance().converterTarget(sch_data.name);
+  // 已注册转换器的类型不再做点云降采样或图像压缩
+  auto stage = converter ? nullptr : makeStage(topic, sch_data.name, schema);
+  bool typed = converter && converter->target_schema;
+  if ((typed || target || stage) && !_channels.contains(topic + "/converted")) {
+    if (typed) {
+      schema = *converter->target_schema;
+    } else if (target) {
+      schema.name = target->name();
+      const std::string& data = target->fdSet();
+      schema.data_len = data.length();
+      schema.data = reinterpret_cast<const std::byte*>(data.c_str());
+    }
+    channel_result =
+      foxglove::RawChannel::create(topic + "/converted", "protobuf", schema, context);
     if (!channel_result.has_value()) {
       LOG_ERROR << "Failed to create channel: " << foxglove::strerror(channel_result.error());
       return false;
     }
-    ChannelConfig converted_channel_config;
-    converted_channel_config.type = sch_data.name;
-    converted_channel_config.channel =
+    auto converted_channel_config = std::make_shared<ChannelConfig>();
+    converted_channel_config->type = sch_data.name;
+    converted_channel_config->source = topic;
+    converted_channel_config->server = server;
+    converted_channel_config->channel =
       std::make_shared<foxglove::RawChannel>(std::move(channel_result.value()));
-    _channels.insert({topic + "/converted", std::move(converted_channel_config)});
+    _channels.insert(topic + "/converted", converted_channel_config->channel->id(),
+      converted_channel_config);
     LOG_INFO << "Created converted channel: " << topic << " with type: " << schema.name;
   }
+  // 在 latch / 录制引用 source 之前创建，ForwardHandle 创建时即可拿到 batch
+  createBatch(topic, sch_data.name, server);
+  if (stage) {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    _stages[topic] = stage;
+  }
+  if (isRecorded(topic) || isRecorded(topic + "/converted") ||
+      (_rewind && _rewind->matches(topic))) {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    syncRecordedSources();
+  }
+  if (BridgeConfig::instance().resolve(topic).latch) {
+    // latch 的 topic 多为低频，保持订阅才能在客户端订阅前收到最近一条消息
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (_latched_sources.insert(topic).second && !acquireSource(topic)) {
+      _latched_sources.erase(topic);
+    }
+  }
+  if (_tf && converter && converter->transforms) {
+    // 各 pose topic 的最新变换在客户端订阅 tf 汇总通道前就需要保存
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (_tf_sources.insert(topic).second && !acquireSource(topic)) {
+      _tf_sources.erase(topic);
+    }
+  }
+  createProjections(topic);
   return true;
 }
 
 void FoxgloveServer::closeChannel(const std::string& topic) {
-  if (_channels.find(topic) == _channels.end()) {
+  // 等待正在发送的消息结束后才释放通道，不阻塞其他 topic 的转发
+  auto raw = _channels.erase(topic);
+  if (!raw) {
     LOG_ERROR << "Channel not found: " << topic;
     return;
   }
-  _channels.erase(topic);
+  std::vector<std::shared_ptr<ChannelConfig>> closed = {
+    raw, _channels.erase(topic + "/converted"), _channels.erase(topic + "/batch")};
+  // 派生通道随源通道关闭，定义保留，源通道重新出现时重新创建
+  std::vector<std::string> derived;
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    for (auto it = _projections.begin(); it != _projections.end();) {
+      if (it->second->spec().source != topic) {
+        ++it;
+        continue;
+      }
+      derived.push_back(it->first);
+      it = _projections.erase(it);
+    }
+  }
+  for (const auto& name : derived) {
+    closed.push_back(_channels.erase(name));
+  }
+  std::shared_ptr<MessageBatch> batch;
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (auto it = _batches.find(topic); it != _batches.end()) {
+      batch = it->second;
+      _batches.erase(it);
+    }
+    _source_refs.erase(topic);
+    _handles.erase(topic);
+    _recorded_sources.erase(topic);
+    _latched_sources.erase(topic);
+    _tf_sources.erase(topic);
+    _stages.erase(topic);
+    for (const auto& config : closed) {
+      if (config && config->channel) {
+        releaseChannelClients(config->channel->id());
+      }
+    }
+  }
+  if (_latch) {
+    _latch->erase(topic);
+  }
+  if (batch) {
+    _batch_flusher->remove(batch);
+  }
+  if (_tf) {
+    _tf->erase(topic);
+  }
+  BridgeMetrics::instance().removeTopic(topic);
   LOG_INFO << "Closed channel: " << topic;
 }
 
-bool FoxgloveServer::sendMessage(const std::string& topic, const std::string& message) {
+void FoxgloveServer::createBatch(
+  const std::string& topic, const std::string& type, uint8_t server) {
+  uint32_t window_ms = BridgeConfig::instance().resolve(topic).batch_ms;
+  std::string name = topic + "/batch";
+  if (window_ms == 0 || !_batch_flusher || _channels.contains(name)) {
+    return;
+  }
+  auto info = TypeRegistry::instance().get(type);
+  if (!info) {
+    LOG_WARN << "Skip batch channel, unknown type: " << topic << " type: " << type;
+    return;
+  }
+  std::string error;
+  auto batch = MessageBatch::create(
+    topic, info->descriptor(), info->fdSet(), window_ms, _batch_flusher->totals(), error);
+  if (!batch) {
+    LOG_WARN << "Failed to create batch channel: " << name << " " << error;
+    return;
+  }
+  foxglove::Schema schema;
+  schema.name = batch->typeName();
+  schema.encoding = "protobuf";
+  schema.data = reinterpret_cast<const std::byte*>(batch->fdSet().data());
+  schema.data_len = batch->fdSet().size();
+  auto channel_result = foxglove::RawChannel::create(name, "protobuf", schema, contextOf(server));
+  if (!channel_result.has_value()) {
+    LOG_ERROR << "Failed to create channel: " << foxglove::strerror(channel_result.error());
+    return;
+  }
+  batch->attach(std::make_shared<foxglove::RawChannel>(std::move(channel_result.value())));
+  auto config = std::make_shared<ChannelConfig>();
+  config->type = batch->typeName();
+  config->source = topic;
+  config->server = server;
+  config->channel = batch->channel();
+  _channels.insert(name, config->channel->id(), config);
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    _batches[topic] = batch;
+  }
+  _batch_flusher->add(batch);
+  LOG_INFO << "Created batch channel: " << name << " window_ms: " << window_ms;
+}
+
+void FoxgloveServer::releaseChannelClients(uint64_t channel_id) {
+  auto it = _channel_clients.find(channel_id);
+  if (it == _channel_clients.end()) {
+    return;
+  }
+  for (uint32_t client_id : it->second) {
+    if (_backlog) {
+      _backlog->release(client_id);
+    }
+  }
+  _channel_clients.erase(it);
+}
+
+std::shared_ptr<const ForwardHandle::ProjectionList> FoxgloveServer::projectionsOf(
+  const std::string& source) {
+  auto projections = std::make_shared<ForwardHandle::ProjectionList>();
+  for (const auto& [topic, projection] : _projections) {
+    if (projection->spec().source == source) {
+      projections->push_back(projection);
+    }
+  }
+  if (projections->empty()) {
+    return nullptr;
+  }
+  return projections;
+}
+
+std::shared_ptr<Projection> FoxgloveServer::compileProjection(
+  const ProjectionSpec& spec, const std::string& type, std::string& error) {
+  // 与 mssageManage 共用 TypeRegistry 中的描述符与原型
+  auto info = TypeRegistry::instance().get(type);
+  std::shared_ptr<const google::protobuf::Message> prototype;
+  if (info) {
+    prototype = std::shared_ptr<const google::protobuf::Message>(info, info->prototype());
+  }
+  return Projection::compile(spec, prototype, error);
+}
+
+bool FoxgloveServer::createProjection(const ProjectionSpec& spec, std::string& error) {
+  auto source = _channels.get(spec.source);
+  if (!source || !source->channel) {
+    error = "source channel not found: " + spec.source;
+    return false;
+  }
+  if (_channels.contains(spec.topic)) {
+    error = "topic already exists: " + spec.topic;
+    return false;
+  }
+  auto projection = compileProjection(spec, source->type, error);
+  if (!projection) {
+    return false;
+  }
+  foxglove::Schema schema;
+  schema.name = projection->typeName();
+  schema.encoding = "protobuf";
+  schema.data = reinterpret_cast<const std::byte*>(projection->fdSet().data());
+  schema.data_len = projection->fdSet().size();
+  auto channel_result =
+    foxglove::RawChannel::create(spec.topic, "protobuf", schema, contextOf(source->server));
+  if (!channel_result.has_value()) {
+    error = foxglove::strerror(channel_result.error());
+    return false;
+  }
+  projection->attach(std::make_shared<foxglove::RawChannel>(std::move(channel_result.value())));
+  auto config = std::make_shared<ChannelConfig>();
+  config->type = projection->typeName();
+  config->source = spec.source;
+  config->server = source->server;
+  config->channel = projection->channel();
+  _channels.insert(spec.topic, config->channel->id(), config);
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    _projections[spec.topic] = projection;
+    if (auto it = _handles.find(spec.source); it != _handles.end()) {
+      it->second->setProjections(projectionsOf(spec.source));
+    }
+    if (isRecorded(spec.topic)) {
+      syncRecordedSources();
+    }
+  }
+  LOG_INFO << "Created projection: " << spec.topic << " from: " << spec.source
+           << " fields: " << projection->outputs().size();
+  return true;
+}
+
+void FoxgloveServer::createProjections(const std::string& source) {
+  std::vector<ProjectionSpec> specs;
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    for (const auto& [topic, spec] : _projection_specs) {
+      if (spec.source == source) {
+        specs.push_back(spec);
+      }
+    }
+  }
+  for (const auto& spec : specs) {
+    std::string error;
+    if (!createProjection(spec, error)) {
+      LOG_WARN << "Failed to create projection: " << spec.topic << " " << error;
+    }
+  }
+}
+
+void FoxgloveServer::removeProjection(const std::string& topic) {
+  std::shared_ptr<Projection> projection;
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    auto it = _projections.find(topic);
+    if (it == _projections.end()) {
+      return;
+    }
+    projection = it->second;
+    _projections.erase(it);
+    const auto& source = projection->spec().source;
+    if (auto handle_it = _handles.find(source); handle_it != _handles.end()) {
+      handle_it->second->setProjections(projectionsOf(source));
+    }
+  }
+  auto closed = _channels.erase(topic);
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (closed && closed->channel) {
+      releaseChannelClients(closed->channel->id());
+      // 通道关闭后不会再收到 unsubscribe，归还这些订阅对 source 的引用
+      for (int32_t i = 0; i < closed->sub_count; ++i) {
+        releaseSource(closed->source);
+      }
+    }
+    syncRecordedSources();
+  }
+  projection->channel()->close();
+  LOG_INFO << "Removed projection: " << topic << " forwarded: " << projection->count()
+           << " errors: " << projection->errors();
+}
+
+bool FoxgloveServer::setProjection(
+  const std::string& topic, const std::string& text, std::string& error) {
+  bool remove = text.empty() || text == "off";
+  ProjectionSpec spec;
+  if (!remove && !ProjectionSpec::parse(topic, text, spec)) {
+    error = "expected <source>:<field>,<name>=<expr>,...";
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (!_projections.count(topic) && _channels.contains(topic)) {
+      error = "topic already exists: " + topic;
+      return false;
+    }
+  }
+  // 源通道已存在时先编译校验，失败时保留原派生通道
+  if (!remove) {
+    auto source = _channels.get(spec.source);
+    if (source && !compileProjection(spec, source->type, error)) {
+      return false;
+    }
+  }
+  removeProjection(topic);
+  {
+    std::lock_guard<std::mutex> lock(_sub_mutex);
+    if (remove) {
+      _projection_specs.erase(topic);
+      return true;
+    }
+    _projection_specs[topic] = spec;
+  }
+  if (_channels.contains(spec.source) && !createProjection(spec, error)) {
+    return false;
+  }
+  return true;
+}
+
+void FoxgloveServer::getProjectionParameters(
+  const std::vector<std::string_view>& names, std::vector<foxglove::Parameter>& result) {
+  std::lock_guard<std::mutex> lock(_sub_mutex);
+  for (const auto& [topic, spec] : _projection_specs) {
+    std::string name = std::string(kProjectionParamPrefix) + topic;
+    if (names.empty() || std::find(names.begin(), names.end(), name) != names.end()) {
+      result.emplace_back(name, spec.toString());
+    }
+  }
+}
+
+bool FoxgloveServer::sendMessage(
+  const std::string& topic, const std::string& message, const google::protobuf::Message* parsed) {
   if (topic.empty() || message.empty()) {
     // LOG_ERROR << "topic or message is empty !" << topic;
     return false;
   }
-  if (_channels.find(topic) == _channels.end()) {
+  auto channels = _channels.read();
+  auto* channel = channels->find(topic);
+  if (!channel) {
     LOG_ERROR << "Channel not found: " << topic;
     return false;
   }
-  auto& channel = _channels[topic];
-  if (!channel.channel) {
+  if (!channel->channel) {
     return false;
   }
-  foxglove::FoxgloveError message_result =
-    channel.channel->log(reinterpret_cast<const std::byte*>(message.c_str()), message.length());
-  if (message_result != foxglove::FoxgloveError::Ok) {
-    LOG_ERROR << "Failed to log message: " << foxglove::strerror(message_result);
-    return false;
+  // 只对有 sink（客户端订阅或录制）的通道做 log，无人订阅的 /converted 通道不做转换
+  if (channel->channel->has_sinks()) {
+    foxglove::FoxgloveError message_result = channel->channel->log(
+      reinterpret_cast<const std::byte*>(message.c_str()), message.length());
+    if (message_result != foxglove::FoxgloveError::Ok) {
+      LOG_ERROR << "Failed to log message: " << foxglove::strerror(message_result);
+      return false;
+    }
   }
-  if (MessageConverter::instance().hasConverter(channel.type)) {
-    auto& repeat = _channels[topic + "/converted"];
-    std::string converted_message;
-    MessageConverter::instance().convert(message, channel.type, converted_message);
-    if (converted_message.empty() || !repeat.channel) {
+  if (MessageConverter::instance().hasConverter(channel->type)) {
+    auto* repeat = channels->find(topic + "/converted");
+    if (!repeat || !repeat->channel || !repeat->channel->has_sinks()) {
+      return true;
+    }
+    std::string& converted_message = ProtoArena::local().convertedBuffer();
+    if (!MessageConverter::instance().convert(message, parsed, channel->type, converted_message) ||
+        converted_message.empty()) {
       // LOG_WARN << "Failed convert message: " << channel.type;
       return false;
     }
-    message_result = repeat.channel->log(
+    auto message_result = repeat->channel->log(
       reinterpret_cast<const std::byte*>(converted_message.c_str()), converted_message.length());
     if (message_result != foxglove::FoxgloveError::Ok) {
       LOG_ERROR << "Failed to log message: " << foxglove::strerror(message_result);
@@ -344,15 +1532,41 @@ bool FoxgloveServer::createService(
   response.encoding = "json";
   schema_s.response.emplace(response);
 
-  static foxglove::ServiceHandler handler = [this](const foxglove::ServiceRequest& request,
-                                              foxglove::ServiceResponder&& responder) {
-    std::string res_str;
-    _bridge->onClientCall(request.service_name, std::string(request.payloadStr()), res_str);
-    std::move(responder).respondOk(
-      reinterpret_cast<const std::byte*>(res_str.c_str()), res_str.length());
-  };
+  // 回调线程只投递请求，cyber 调用在 _service_executor 中完成，responder 随任务转移
+  auto options = BridgeConfig::instance().resolve(topic);
+  auto timeout = std::chrono::milliseconds(options.service_timeout_ms);
+  uint32_t concurrency = options.service_concurrency;
+  auto handler = std::make_unique<foxglove::ServiceHandler>(
+    [this, timeout, concurrency](
+      const foxglove::ServiceRequest& request, foxglove::ServiceResponder&& responder) {
+      auto shared = std::make_shared<foxglove::ServiceResponder>(std::move(responder));
+      std::string service = request.service_name;
+      std::string payload(request.payloadStr());
+      bool accepted = _service_executor->submit(service, concurrency,
+        [this, shared, service, payload, timeout](bool cancelled) {
+          if (cancelled) {
+            std::move(*shared).respondError("bridge stopped");
+            return;
+          }
+          std::string res_str;
+          std::string error;
+          if (!_bridge->onClientCall(service, payload, res_str, timeout, error)) {
+            std::move(*shared).respondError(error);
+            return;
+          }
+          std::move(*shared).respondOk(
+            reinterpret_cast<const std::byte*>(res_str.c_str()), res_str.length());
+        });
+      if (!accepted) {
+        LOG_WARN << "service busy: " << service << " concurrency: " << concurrency;
+        std::move(*shared).respondError(
+          "service busy: " + service + " has " + std::to_string(concurrency) +
+          " requests in flight");
+      }
+    });
   _bridge->onClientRegister(topic);
-  auto service_result = foxglove::Service::create(topic, schema_s, handler);
+  // Service 只保存 handler 的地址，handler 需要与服务同生命周期
+  auto service_result = foxglove::Service::create(topic, schema_s, *handler);
   if (!service_result.has_value()) {
     LOG_ERROR << "Failed to create service: " << foxglove::strerror(service_result.error());
     return false;
@@ -365,5 +1579,6 @@ bool FoxgloveServer::createService(
     return false;
   }
   _services_set.insert(topic);
+  _service_handlers[topic] = std::move(handler);
   return true;
 }
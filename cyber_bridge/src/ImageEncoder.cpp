@@ -0,0 +1,307 @@
+#include "ImageEncoder.hpp"
+
+#include <zlib.h>
+
+#include <cstring>
+
+#ifdef FOX_BRIDGE_WITH_JPEG
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+
+#include <jpeglib.h>
+#endif
+
+namespace {
+
+enum class PixelLayout { Mono8, Mono16, Rgb8, Bgr8, Rgba8, Bgra8, Yuyv, Uyvy };
+
+struct Layout {
+  PixelLayout type;
+  uint32_t bytes_per_pixel;
+  uint32_t channels;  // 输出通道数：1 为灰度，3 为 RGB
+};
+
+bool layoutOf(std::string_view encoding, Layout& layout) {
+  if (encoding == "mono8" || encoding == "8UC1") {
+    layout = {PixelLayout::Mono8, 1, 1};
+  } else if (encoding == "mono16" || encoding == "16UC1") {
+    layout = {PixelLayout::Mono16, 2, 1};
+  } else if (encoding == "rgb8") {
+    layout = {PixelLayout::Rgb8, 3, 3};
+  } else if (encoding == "bgr8" || encoding == "8UC3") {
+    layout = {PixelLayout::Bgr8, 3, 3};
+  } else if (encoding == "rgba8") {
+    layout = {PixelLayout::Rgba8, 4, 3};
+  } else if (encoding == "bgra8" || encoding == "8UC4") {
+    layout = {PixelLayout::Bgra8, 4, 3};
+  } else if (encoding == "yuyv" || encoding == "yuv422_yuy2") {
+    layout = {PixelLayout::Yuyv, 2, 3};
+  } else if (encoding == "uyvy" || encoding == "yuv422") {
+    layout = {PixelLayout::Uyvy, 2, 3};
+  } else {
+    return false;
+  }
+  return true;
+}
+
+inline uint8_t clampByte(int value) {
+  return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+// BT.601，整数运算
+inline void yuvToRgb(int y, int u, int v, uint8_t* rgb) {
+  int c = 298 * (y - 16) + 128;
+  int d = u - 128;
+  int e = v - 128;
+  rgb[0] = clampByte((c + 409 * e) >> 8);
+  rgb[1] = clampByte((c - 100 * d - 208 * e) >> 8);
+  rgb[2] = clampByte((c + 516 * d) >> 8);
+}
+
+// 一行原始像素转为紧密排列的灰度或 RGB，按 layout 分支在行外，行内为简单循环
+void convertRow(const Layout& layout, const uint8_t* src, uint32_t width, uint8_t* dst) {
+  switch (layout.type) {
+    case PixelLayout::Mono8:
+      std::memcpy(dst, src, width);
+      break;
+    case PixelLayout::Mono16:
+      for (uint32_t x = 0; x < width; ++x) {
+        dst[x] = src[x * 2 + 1];  // 小端，取高 8 位
+      }
+      break;
+    case PixelLayout::Rgb8:
+      std::memcpy(dst, src, size_t(width) * 3);
+      break;
+    case PixelLayout::Bgr8:
+      for (uint32_t x = 0; x < width; ++x) {
+        dst[x * 3] = src[x * 3 + 2];
+        dst[x * 3 + 1] = src[x * 3 + 1];
+        dst[x * 3 + 2] = src[x * 3];
+      }
+      break;
+    case PixelLayout::Rgba8:
+      for (uint32_t x = 0; x < width; ++x) {
+        std::memcpy(dst + x * 3, src + x * 4, 3);
+      }
+      break;
+    case PixelLayout::Bgra8:
+      for (uint32_t x = 0; x < width; ++x) {
+        dst[x * 3] = src[x * 4 + 2];
+        dst[x * 3 + 1] = src[x * 4 + 1];
+        dst[x * 3 + 2] = src[x * 4];
+      }
+      break;
+    case PixelLayout::Yuyv:
+    case PixelLayout::Uyvy: {
+      bool yuyv = layout.type == PixelLayout::Yuyv;
+      uint32_t x = 0;
+      for (; x + 1 < width; x += 2) {
+        const uint8_t* p = src + x * 2;
+        int u = yuyv ? p[1] : p[0];
+        int v = yuyv ? p[3] : p[2];
+        yuvToRgb(yuyv ? p[0] : p[1], u, v, dst + x * 3);
+        yuvToRgb(yuyv ? p[2] : p[3], u, v, dst + (x + 1) * 3);
+      }
+      if (x < width) {
+        // 宽度为奇数时最后一个像素没有配对的色度
+        yuvToRgb(src[x * 2 + (yuyv ? 0 : 1)], 128, 128, dst + x * 3);
+      }
+      break;
+    }
+  }
+}
+
+// 转换并按 scale x scale 块取平均缩小，输出紧密排列的像素
+void toPixels(const ImageEncoder::Frame& frame, const Layout& layout, uint32_t scale,
+  uint32_t step, std::vector<uint8_t>& pixels, uint32_t& out_width, uint32_t& out_height) {
+  const uint32_t channels = layout.channels;
+  out_width = frame.width / scale;
+  out_height = frame.height / scale;
+  const size_t out_row = size_t(out_width) * channels;
+  pixels.resize(out_row * out_height);
+  if (scale == 1) {
+    for (uint32_t y = 0; y < frame.height; ++y) {
+      convertRow(layout, frame.data + size_t(y) * step, frame.width, pixels.data() + y * out_row);
+    }
+    return;
+  }
+  thread_local std::vector<uint8_t> row;
+  thread_local std::vector<uint32_t> sums;
+  row.resize(size_t(frame.width) * channels);
+  sums.resize(out_row);
+  const uint32_t area = scale * scale;
+  for (uint32_t oy = 0; oy < out_height; ++oy) {
+    std::fill(sums.begin(), sums.end(), 0);
+    for (uint32_t sy = 0; sy < scale; ++sy) {
+      convertRow(layout, frame.data + size_t(oy * scale + sy) * step, frame.width, row.data());
+      for (uint32_t ox = 0; ox < out_width; ++ox) {
+        const uint8_t* block = row.data() + size_t(ox) * scale * channels;
+        uint32_t* sum = sums.data() + size_t(ox) * channels;
+        for (uint32_t k = 0; k < scale; ++k) {
+          for (uint32_t c = 0; c < channels; ++c) {
+            sum[c] += block[k * channels + c];
+          }
+        }
+      }
+    }
+    uint8_t* out = pixels.data() + oy * out_row;
+    for (size_t i = 0; i < out_row; ++i) {
+      out[i] = static_cast<uint8_t>(sums[i] / area);
+    }
+  }
+}
+
+void appendBytes(std::vector<std::byte>& output, const void* data, size_t size) {
+  const auto* begin = static_cast<const std::byte*>(data);
+  output.insert(output.end(), begin, begin + size);
+}
+
+void appendBe32(std::vector<std::byte>& output, uint32_t value) {
+  uint8_t bytes[4] = {uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8),
+    uint8_t(value)};
+  appendBytes(output, bytes, 4);
+}
+
+void appendChunk(
+  std::vector<std::byte>& output, const char* type, const uint8_t* data, size_t size) {
+  appendBe32(output, static_cast<uint32_t>(size));
+  appendBytes(output, type, 4);
+  if (size > 0) {
+    appendBytes(output, data, size);
+  }
+  uLong crc = crc32(0, reinterpret_cast<const Bytef*>(type), 4);
+  if (size > 0) {
+    crc = crc32(crc, data, static_cast<uInt>(size));
+  }
+  appendBe32(output, static_cast<uint32_t>(crc));
+}
+
+// 每行使用 Sub 过滤，zlib 最快压缩级别
+bool encodePng(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height,
+  uint32_t channels, std::vector<std::byte>& output, std::string& error) {
+  const size_t row = size_t(width) * channels;
+  thread_local std::vector<uint8_t> filtered;
+  thread_local std::vector<uint8_t> compressed;
+  filtered.resize((row + 1) * height);
+  for (uint32_t y = 0; y < height; ++y) {
+    const uint8_t* src = pixels.data() + y * row;
+    uint8_t* dst = filtered.data() + y * (row + 1);
+    dst[0] = 1;
+    std::memcpy(dst + 1, src, channels);
+    for (size_t i = channels; i < row; ++i) {
+      dst[1 + i] = static_cast<uint8_t>(src[i] - src[i - channels]);
+    }
+  }
+  uLongf compressed_size = compressBound(filtered.size());
+  compressed.resize(compressed_size);
+  int ret =
+    compress2(compressed.data(), &compressed_size, filtered.data(), filtered.size(), Z_BEST_SPEED);
+  if (ret != Z_OK) {
+    error = "zlib compress failed: " + std::to_string(ret);
+    return false;
+  }
+  static const uint8_t kSignature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+  uint8_t header[13] = {uint8_t(width >> 24), uint8_t(width >> 16), uint8_t(width >> 8),
+    uint8_t(width), uint8_t(height >> 24), uint8_t(height >> 16), uint8_t(height >> 8),
+    uint8_t(height), 8, uint8_t(channels == 1 ? 0 : 2), 0, 0, 0};
+  output.clear();
+  output.reserve(compressed_size + 64);
+  appendBytes(output, kSignature, sizeof(kSignature));
+  appendChunk(output, "IHDR", header, sizeof(header));
+  appendChunk(output, "IDAT", compressed.data(), compressed_size);
+  appendChunk(output, "IEND", nullptr, 0);
+  return true;
+}
+
+#ifdef FOX_BRIDGE_WITH_JPEG
+struct JpegError {
+  jpeg_error_mgr mgr;
+  jmp_buf jump;
+  char message[JMSG_LENGTH_MAX];
+};
+
+// libjpeg 默认出错时调用 exit，改为跳回调用处
+void onJpegError(j_common_ptr cinfo) {
+  auto* err = reinterpret_cast<JpegError*>(cinfo->err);
+  (*cinfo->err->format_message)(cinfo, err->message);
+  longjmp(err->jump, 1);
+}
+
+bool encodeJpeg(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height,
+  uint32_t channels, int quality, std::vector<std::byte>& output, std::string& error) {
+  jpeg_compress_struct cinfo;
+  JpegError err;
+  unsigned char* buffer = nullptr;
+  unsigned long size = 0;
+  cinfo.err = jpeg_std_error(&err.mgr);
+  err.mgr.error_exit = onJpegError;
+  if (setjmp(err.jump)) {
+    jpeg_destroy_compress(&cinfo);
+    std::free(buffer);
+    error = std::string("jpeg encode failed: ") + err.message;
+    return false;
+  }
+  jpeg_create_compress(&cinfo);
+  jpeg_mem_dest(&cinfo, &buffer, &size);
+  cinfo.image_width = width;
+  cinfo.image_height = height;
+  cinfo.input_components = static_cast<int>(channels);
+  cinfo.in_color_space = channels == 1 ? JCS_GRAYSCALE : JCS_RGB;
+  jpeg_set_defaults(&cinfo);
+  jpeg_set_quality(&cinfo, quality, TRUE);
+  cinfo.dct_method = JDCT_IFAST;
+  jpeg_start_compress(&cinfo, TRUE);
+  const size_t row = size_t(width) * channels;
+  while (cinfo.next_scanline < cinfo.image_height) {
+    JSAMPROW line = const_cast<JSAMPROW>(pixels.data() + cinfo.next_scanline * row);
+    jpeg_write_scanlines(&cinfo, &line, 1);
+  }
+  jpeg_finish_compress(&cinfo);
+  jpeg_destroy_compress(&cinfo);
+  output.clear();
+  appendBytes(output, buffer, size);
+  std::free(buffer);
+  return true;
+}
+#endif
+
+}  // namespace
+
+bool ImageEncoder::jpegSupported() {
+#ifdef FOX_BRIDGE_WITH_JPEG
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool ImageEncoder::encode(const Frame& frame, const ImageOptions& options,
+  std::vector<std::byte>& output, std::string& format, std::string& error) {
+  Layout layout;
+  if (!layoutOf(frame.encoding, layout)) {
+    error = "unsupported encoding: " + std::string(frame.encoding);
+    return false;
+  }
+  uint32_t scale = std::max(options.scale, 1u);
+  uint32_t step = frame.step > 0 ? frame.step : frame.width * layout.bytes_per_pixel;
+  if (frame.width / scale == 0 || frame.height / scale == 0 ||
+      step < frame.width * layout.bytes_per_pixel ||
+      frame.size < size_t(step) * (frame.height - 1) + size_t(frame.width) * layout.bytes_per_pixel) {
+    error = "invalid image: " + std::to_string(frame.width) + "x" + std::to_string(frame.height) +
+            " step " + std::to_string(step) + " size " + std::to_string(frame.size);
+    return false;
+  }
+  thread_local std::vector<uint8_t> pixels;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  toPixels(frame, layout, scale, step, pixels, width, height);
+#ifdef FOX_BRIDGE_WITH_JPEG
+  if (options.format == "jpeg") {
+    format = "jpeg";
+    return encodeJpeg(pixels, width, height, layout.channels, options.quality, output, error);
+  }
+#endif
+  format = "png";
+  return encodePng(pixels, width, height, layout.channels, output, error);
+}
@@ -0,0 +1,173 @@
+#include "ImageStage.hpp"
+
+#include <foxglove/schemas.hpp>
+
+#include <chrono>
+
+#include "HeaderFields.hpp"
+#include "logger/log.h"
+#include "protoPool.hpp"
+
+namespace {
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+uint64_t steadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+// width / height / step 在不同的图像 proto 中可能是有符号或 64 位整数
+uint64_t getInteger(const Message& msg, const char* name) {
+  const auto* field = msg.GetDescriptor()->FindFieldByName(name);
+  if (!field || field->is_repeated()) {
+    return 0;
+  }
+  const auto* reflection = msg.GetReflection();
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return reflection->GetUInt32(msg, field);
+    case FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<uint64_t>(std::max(reflection->GetInt32(msg, field), 0));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return reflection->GetUInt64(msg, field);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<uint64_t>(std::max<int64_t>(reflection->GetInt64(msg, field), 0));
+    default:
+      return 0;
+  }
+}
+
+}  // namespace
+
+ImageStage::ImageStage(std::string topic, std::shared_ptr<const TypeInfo> type,
+  ImageOptions options, ServiceExecutor* executor, std::shared_ptr<TopicMetrics> metrics)
+    : _topic(std::move(topic))
+    , _type(std::move(type))
+    , _options(std::move(options))
+    , _interval_ns(_options.max_hz > 0 ? static_cast<uint64_t>(1e9 / _options.max_hz) : 0)
+    , _executor(executor)
+    , _metrics(std::move(metrics)) {}
+
+bool ImageStage::isImageType(const google::protobuf::Descriptor* descriptor) {
+  if (!descriptor) {
+    return false;
+  }
+  const auto* data = descriptor->FindFieldByName("data");
+  const auto* encoding = descriptor->FindFieldByName("encoding");
+  return descriptor->FindFieldByName("width") && descriptor->FindFieldByName("height") && data &&
+         data->type() == FieldDescriptor::TYPE_BYTES && encoding &&
+         encoding->cpp_type() == FieldDescriptor::CPPTYPE_STRING;
+}
+
+bool ImageStage::offer(const std::string& message, Deliver deliver) {
+  if (_interval_ns > 0) {
+    uint64_t now = steadyNs();
+    uint64_t next = _next_ns.load(std::memory_order_relaxed);
+    if (now < next || !_next_ns.compare_exchange_strong(next, now + _interval_ns)) {
+      _skipped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+  }
+  // 消息缓冲区由分发线程复用，投递前复制一份
+  auto self = shared_from_this();
+  bool accepted = _executor->submit(_topic, _options.max_inflight,
+    [self, message, deliver = std::move(deliver)](bool cancelled) {
+      if (!cancelled) {
+        self->encode(message, deliver);
+      }
+    });
+  if (!accepted) {
+    _skipped.fetch_add(1, std::memory_order_relaxed);
+  }
+  return accepted;
+}
+
+void ImageStage::encode(const std::string& message, const Deliver& deliver) {
+  std::unique_ptr<Message> msg(_type->prototype()->New());
+  if (!msg->ParseFromString(message)) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const auto* reflection = msg->GetReflection();
+  std::string data_scratch;
+  const std::string& data = reflection->GetStringReference(
+    *msg, msg->GetDescriptor()->FindFieldByName("data"), &data_scratch);
+  std::string encoding =
+    reflection->GetString(*msg, msg->GetDescriptor()->FindFieldByName("encoding"));
+
+  ImageEncoder::Frame frame;
+  frame.width = static_cast<uint32_t>(getInteger(*msg, "width"));
+  frame.height = static_cast<uint32_t>(getInteger(*msg, "height"));
+  frame.step = static_cast<uint32_t>(getInteger(*msg, "step"));
+  frame.encoding = encoding;
+  frame.data = reinterpret_cast<const uint8_t*>(data.data());
+  frame.size = data.size();
+
+  foxglove::schemas::CompressedImage image;
+  std::string error;
+  auto begin = std::chrono::steady_clock::now();
+  if (!ImageEncoder::encode(frame, _options, image.data, image.format, error)) {
+    if (_errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+      LOG_WARN << "Failed to encode image: " << _topic << " " << error;
+    }
+    return;
+  }
+  uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - begin)
+                          .count();
+  _last_encode_us.store(elapsed_us, std::memory_order_relaxed);
+  if (_metrics) {
+    _metrics->encode_latency.record(elapsed_us);
+  }
+  image.frame_id = headerFrameId(*msg);
+  image.timestamp = headerTimestamp(*msg);
+
+  thread_local std::string output;
+  size_t encoded_len = 0;
+  output.resize(image.data.size() + 256);
+  auto result =
+    image.encode(reinterpret_cast<uint8_t*>(output.data()), output.size(), &encoded_len);
+  if (result == foxglove::FoxgloveError::BufferTooShort) {
+    output.resize(encoded_len);
+    result = image.encode(reinterpret_cast<uint8_t*>(output.data()), output.size(), &encoded_len);
+  }
+  if (result != foxglove::FoxgloveError::Ok) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN << "Failed to serialize CompressedImage: " << foxglove::strerror(result);
+    return;
+  }
+  output.resize(encoded_len);
+  _encoded.fetch_add(1, std::memory_order_relaxed);
+  _bytes_in.fetch_add(data.size(), std::memory_order_relaxed);
+  _bytes_out.fetch_add(image.data.size(), std::memory_order_relaxed);
+  deliver(output);
+}
+
+void ImageStage::collect(BridgeMetrics::Values& values) const {
+  if (!_metrics) {
+    return;
+  }
+  auto current = stats();
+  const std::string name = _metrics->name + "_image";
+  values[name + "_encoded"] = current.encoded;
+  values[name + "_skipped"] = current.skipped;
+  values[name + "_errors"] = current.errors;
+  values[name + "_bytes_in"] = current.bytes_in;
+  values[name + "_bytes_out"] = current.bytes_out;
+  values[name + "_encode_us"] = current.last_encode_us;
+}
+
+ImageStats ImageStage::stats() const {
+  ImageStats stats;
+  stats.topic = _topic;
+  stats.encoded = _encoded.load(std::memory_order_relaxed);
+  stats.skipped = _skipped.load(std::memory_order_relaxed);
+  stats.errors = _errors.load(std::memory_order_relaxed);
+  stats.bytes_in = _bytes_in.load(std::memory_order_relaxed);
+  stats.bytes_out = _bytes_out.load(std::memory_order_relaxed);
+  stats.last_encode_us = _last_encode_us.load(std::memory_order_relaxed);
+  return stats;
+}
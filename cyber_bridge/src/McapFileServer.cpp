@@ -0,0 +1,270 @@
+#include "McapFileServer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <vector>
+
+#include "logger/log.h"
+
+namespace {
+
+// 播放时 broadcastTime 与发送消息的周期
+constexpr auto kTick = std::chrono::milliseconds(10);
+
+}  // namespace
+
+McapServeOptions McapServeOptions::fromJson(const nlohmann::json& j) {
+  McapServeOptions options;
+  if (!j.is_object()) {
+    return options;
+  }
+  options.lookahead_ms = j.value("lookahead_ms", options.lookahead_ms);
+  options.lookahead_mb = j.value("lookahead_mb", options.lookahead_mb);
+  options.backfill_ms = j.value("backfill_ms", options.backfill_ms);
+  return options;
+}
+
+McapFileServer::McapFileServer(std::string path, McapServeOptions options)
+    : _path(std::move(path))
+    , _options(options)
+    , _context(foxglove::Context::create()) {}
+
+McapFileServer::~McapFileServer() {
+  stop();
+}
+
+bool McapFileServer::open() {
+  auto status = _reader.open(_path);
+  if (!status.ok()) {
+    LOG_ERROR << "Failed to open MCAP file: " << _path << " " << status.message;
+    return false;
+  }
+  // 没有 summary 的文件（如录制中断）退回全文件扫描
+  status = _reader.readSummary(mcap::ReadSummaryMethod::AllowFallbackScan);
+  if (!status.ok()) {
+    LOG_ERROR << "Failed to read MCAP summary: " << _path << " " << status.message;
+    return false;
+  }
+  const auto& statistics = _reader.statistics();
+  if (!statistics || statistics->messageCount == 0) {
+    LOG_ERROR << "MCAP file has no messages: " << _path;
+    return false;
+  }
+  const auto& chunks = _reader.chunkIndexes();
+  _indexed = std::any_of(chunks.begin(), chunks.end(),
+    [](const mcap::ChunkIndex& chunk) { return chunk.messageIndexLength > 0; });
+  if (!_indexed) {
+    LOG_WARN << "MCAP file has no message index, seeking reads from the start: " << _path;
+  }
+  _clock.emplace(statistics->messageStartTime, statistics->messageEndTime);
+  _decode_from = statistics->messageStartTime;
+  LOG_INFO << "Opened MCAP file: " << _path << " messages: " << statistics->messageCount
+           << " chunks: " << chunks.size() << " span_ms: "
+           << (statistics->messageEndTime - statistics->messageStartTime) / 1000000;
+  return true;
+}
+
+bool McapFileServer::createChannels() {
+  const auto schemas = _reader.schemas();
+  for (const auto& [id, channel] : _reader.channels()) {
+    std::optional<foxglove::Schema> schema;
+    if (auto it = schemas.find(channel->schemaId); it != schemas.end()) {
+      schema = foxglove::Schema{it->second->name, it->second->encoding, it->second->data.data(),
+        it->second->data.size()};
+    }
+    std::map<std::string, std::string> metadata(
+      channel->metadata.begin(), channel->metadata.end());
+    auto result = foxglove::RawChannel::create(
+      channel->topic, channel->messageEncoding, schema, _context, metadata);
+    if (!result.has_value()) {
+      LOG_WARN << "Failed to create channel: " << channel->topic << " "
+               << foxglove::strerror(result.error());
+      continue;
+    }
+    _channels[id] = std::make_unique<foxglove::RawChannel>(std::move(result.value()));
+  }
+  return !_channels.empty();
+}
+
+bool McapFileServer::start(const std::string& host, uint16_t port) {
+  if (!open() || !createChannels()) {
+    return false;
+  }
+  foxglove::WebSocketServerOptions options;
+  options.context = _context;
+  options.name = "FoxgloveServer/mcap";
+  options.host = host;
+  options.port = port;
+  options.capabilities = foxglove::WebSocketServerCapabilities::Time;
+  options.playback_time_range = std::make_pair(_clock->begin(), _clock->end());
+  options.callbacks.onPlaybackControlRequest =
+    [this](const foxglove::PlaybackControlRequest& request)
+    -> std::optional<foxglove::PlaybackState> {
+    return onControl(request);
+  };
+  auto server_result = foxglove::WebSocketServer::create(std::move(options));
+  if (!server_result.has_value()) {
+    LOG_ERROR << "Failed to create server: " << foxglove::strerror(server_result.error());
+    return false;
+  }
+  _server = std::make_unique<foxglove::WebSocketServer>(std::move(server_result.value()));
+  _running = true;
+  _decode_thread = std::thread(&McapFileServer::decode, this);
+  _play_thread = std::thread(&McapFileServer::play, this);
+  LOG_INFO << "Serving " << _path << " on: " << host << ":" << _server->port()
+           << " channels: " << _channels.size();
+  return true;
+}
+
+void McapFileServer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _decode_cv.notify_all();
+  _play_cv.notify_all();
+  if (_decode_thread.joinable()) {
+    _decode_thread.join();
+  }
+  if (_play_thread.joinable()) {
+    _play_thread.join();
+  }
+  _server->stop();
+  _server.reset();
+  _channels.clear();
+  _reader.close();
+}
+
+bool McapFileServer::fullLocked() const {
+  if (_pending.empty()) {
+    return false;
+  }
+  uint64_t lookahead_ns = static_cast<uint64_t>(_options.lookahead_ms) * 1000000ull;
+  return _pending_bytes >= (_options.lookahead_mb << 20) ||
+         _pending.back().time_ns > _clock->current() + lookahead_ns;
+}
+
+void McapFileServer::clearLocked() {
+  _pending.clear();
+  _pending_bytes = 0;
+  _decoded_all = false;
+}
+
+void McapFileServer::logPending(const Pending& message) {
+  message.channel->log(reinterpret_cast<const std::byte*>(message.data.data()),
+    message.data.size(), message.time_ns);
+}
+
+foxglove::PlaybackState McapFileServer::onControl(
+  const foxglove::PlaybackControlRequest& request) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto seek = _clock->apply(request);
+  if (seek) {
+    // 已解码的消息作废，解码线程从目标时刻重新读取
+    ++_generation;
+    _decode_from = *seek;
+    clearLocked();
+  }
+  _decode_cv.notify_all();
+  _play_cv.notify_all();
+  return _clock->state(seek.has_value(), request.request_id);
+}
+
+void McapFileServer::decode() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running) {
+    const uint64_t generation = _generation;
+    const uint64_t from = _decode_from;
+    lock.unlock();
+    bool finished = decodeFrom(generation, from);
+    lock.lock();
+    if (finished && generation == _generation) {
+      _decoded_all = true;
+    }
+    _decode_cv.wait(lock, [&] { return !_running || _generation != generation; });
+  }
+}
+
+bool McapFileServer::decodeFrom(uint64_t generation, uint64_t from) {
+  uint64_t backfill_ns = static_cast<uint64_t>(_options.backfill_ms) * 1000000ull;
+  uint64_t start = from > _clock->begin() + backfill_ns ? from - backfill_ns : _clock->begin();
+  // 有索引时按 log time 读取，只解压与读取范围重叠的 chunk，拖动不需要从头扫描
+  mcap::ReadMessageOptions read_options(start, mcap::MaxTime);
+  read_options.readOrder = _indexed ? mcap::ReadMessageOptions::ReadOrder::LogTimeOrder
+                                    : mcap::ReadMessageOptions::ReadOrder::FileOrder;
+  auto on_problem = [this](const mcap::Status& status) {
+    LOG_WARN << "MCAP read problem: " << _path << " " << status.message;
+  };
+
+  // 目标时刻之前各通道的最后一条消息，在第一条目标时刻之后的消息入队前发送
+  std::map<foxglove::RawChannel*, Pending> backfill;
+  auto flush_backfill = [&backfill]() {
+    std::vector<const Pending*> messages;
+    for (const auto& [channel, message] : backfill) {
+      messages.push_back(&message);
+    }
+    std::sort(messages.begin(), messages.end(),
+      [](const Pending* a, const Pending* b) { return a->time_ns < b->time_ns; });
+    for (const auto* message : messages) {
+      logPending(*message);
+    }
+    backfill.clear();
+  };
+
+  for (const auto& view : _reader.readMessages(on_problem, read_options)) {
+    auto it = _channels.find(view.message.channelId);
+    if (it == _channels.end()) {
+      continue;
+    }
+    Pending message{view.message.logTime, it->second.get(),
+      std::string(reinterpret_cast<const char*>(view.message.data), view.message.dataSize)};
+    if (message.time_ns < from) {
+      backfill[message.channel] = std::move(message);
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(_mutex);
+    _decode_cv.wait(
+      lock, [&] { return !_running || _generation != generation || !fullLocked(); });
+    if (!_running || _generation != generation) {
+      return false;
+    }
+    flush_backfill();
+    _pending_bytes += message.data.size();
+    _pending.push_back(std::move(message));
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_running || _generation != generation) {
+    return false;
+  }
+  flush_backfill();
+  return true;
+}
+
+void McapFileServer::play() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running) {
+    if (!_clock->playing()) {
+      _play_cv.wait(lock);
+      continue;
+    }
+    uint64_t current = _clock->current();
+    while (!_pending.empty() && _pending.front().time_ns <= current) {
+      logPending(_pending.front());
+      _pending_bytes -= _pending.front().data.size();
+      _pending.pop_front();
+    }
+    _server->broadcastTime(current);
+    if (_pending.empty() && _decoded_all) {
+      _clock->finish();
+      _server->broadcastPlaybackState(_clock->state(false));
+      continue;
+    }
+    // 回放时间推进后解码线程可以继续读取
+    _decode_cv.notify_all();
+    _play_cv.wait_for(lock, kTick);
+  }
+}
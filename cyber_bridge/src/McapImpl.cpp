@@ -0,0 +1,3 @@
+// mcap implementation file version mcap-releases-cpp-v2.1.1
+#define MCAP_IMPLEMENTATION
+#include <mcap/mcap.hpp>
@@ -0,0 +1,223 @@
+#include "McapRecorder.hpp"
+
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+
+#include "BridgeConfig.hpp"
+#include "logger/log.h"
+
+namespace {
+
+uint64_t steadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+foxglove::McapCompression compressionFromString(const std::string& name) {
+  if (name == "none") return foxglove::McapCompression::None;
+  if (name == "lz4") return foxglove::McapCompression::Lz4;
+  return foxglove::McapCompression::Zstd;
+}
+
+bool matchAny(const std::vector<std::string>& patterns, std::string_view topic) {
+  std::string name(topic);
+  for (const auto& pattern : patterns) {
+    if (BridgeConfig::match(pattern, name)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+RecordOptions RecordOptions::fromJson(const nlohmann::json& j) {
+  RecordOptions options;
+  if (!j.is_object()) {
+    return options;
+  }
+  options.enabled = j.value("enabled", options.enabled);
+  options.dir = j.value("dir", options.dir);
+  options.prefix = j.value("prefix", options.prefix);
+  options.max_size_mb = j.value("max_size_mb", options.max_size_mb);
+  options.max_duration_s = j.value("max_duration_s", options.max_duration_s);
+  options.compression = j.value("compression", options.compression);
+  if (j.contains("topics") && j["topics"].is_array()) {
+    options.topics = j["topics"].get<std::vector<std::string>>();
+  }
+  return options;
+}
+
+McapRecorder::McapRecorder(RecordOptions options)
+    : _options(std::move(options)) {
+  _contexts.emplace_back("", foxglove::Context());
+}
+
+McapRecorder::~McapRecorder() {
+  stop();
+}
+
+void McapRecorder::addContext(const std::string& name, const foxglove::Context& context) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _contexts.emplace_back(name, context);
+}
+
+bool McapRecorder::start() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_running) {
+      return true;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(_options.dir, ec);
+    if (ec) {
+      LOG_ERROR << "Failed to create record dir: " << _options.dir << " " << ec.message();
+      return false;
+    }
+    if (!openLocked()) {
+      return false;
+    }
+    _running = true;
+  }
+  _thread = std::thread(&McapRecorder::run, this);
+  return true;
+}
+
+void McapRecorder::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (size_t i = 0; i < _writers.size(); ++i) {
+    _writers[i]->close();
+    LOG_INFO << "Stopped recording: " << _paths[i];
+  }
+  _writers.clear();
+  _paths.clear();
+}
+
+bool McapRecorder::recording() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _running;
+}
+
+std::vector<std::string> McapRecorder::currentFiles() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _paths;
+}
+
+RecordOptions McapRecorder::options() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _options;
+}
+
+void McapRecorder::setTopics(const std::vector<std::string>& topics) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _options.topics = topics;
+  // sink_channel_filter 在创建 writer 时固定，换一个文件使新的 topic 生效
+  if (_running) {
+    openLocked();
+  }
+}
+
+bool McapRecorder::matches(const std::string& topic) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  return matchAny(_options.topics, topic);
+}
+
+void McapRecorder::setFileCallback(FileCallback callback) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _file_callback = std::move(callback);
+}
+
+bool McapRecorder::openLocked() {
+  std::vector<std::unique_ptr<foxglove::McapWriter>> writers;
+  std::vector<std::string> paths;
+  for (const auto& [name, context] : _contexts) {
+    std::string path = nextPath(name);
+    foxglove::McapWriterOptions options;
+    options.context = context;
+    options.path = path;
+    options.compression = compressionFromString(_options.compression);
+    options.truncate = true;
+    options.sink_channel_filter = [topics = _options.topics](
+                                    foxglove::ChannelDescriptor&& channel) {
+      return matchAny(topics, channel.topic());
+    };
+    auto result = foxglove::McapWriter::create(options);
+    if (!result.has_value()) {
+      LOG_ERROR << "Failed to create MCAP writer: " << path << " "
+                << foxglove::strerror(result.error());
+      for (auto& writer : writers) {
+        writer->close();
+      }
+      return false;
+    }
+    writers.push_back(std::make_unique<foxglove::McapWriter>(std::move(result.value())));
+    paths.push_back(path);
+  }
+  // 先打开新文件再关闭旧文件，切换期间的消息可能在两个文件中各有一份，但不会丢失
+  for (size_t i = 0; i < _writers.size(); ++i) {
+    _writers[i]->close();
+    LOG_INFO << "Closed record file: " << _paths[i];
+  }
+  _writers = std::move(writers);
+  _paths = std::move(paths);
+  _opened_ns = steadyNs();
+  for (const auto& path : _paths) {
+    LOG_INFO << "Recording to: " << path;
+    if (_file_callback) {
+      _file_callback(path);
+    }
+  }
+  return true;
+}
+
+std::string McapRecorder::nextPath(const std::string& name) const {
+  std::time_t now = std::time(nullptr);
+  std::tm tm{};
+  localtime_r(&now, &tm);
+  char stamp[32];
+  std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", &tm);
+  std::string file = _options.prefix + (name.empty() ? "" : "_" + name) + "_" + stamp;
+  std::string base = (std::filesystem::path(_options.dir) / file).string();
+  std::string path = base + ".mcap";
+  for (int i = 1; std::filesystem::exists(path); ++i) {
+    path = base + "_" + std::to_string(i) + ".mcap";
+  }
+  return path;
+}
+
+void McapRecorder::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running) {
+    if (_cv.wait_for(lock, std::chrono::seconds(1), [this]() {
+          return !_running;
+        })) {
+      break;
+    }
+    bool rotate = false;
+    if (_options.max_duration_s > 0 &&
+        steadyNs() - _opened_ns >= uint64_t(_options.max_duration_s) * 1000000000ull) {
+      rotate = true;
+    }
+    for (size_t i = 0; !rotate && _options.max_size_mb > 0 && i < _paths.size(); ++i) {
+      std::error_code ec;
+      auto size = std::filesystem::file_size(_paths[i], ec);
+      rotate = !ec && size >= _options.max_size_mb * 1024 * 1024;
+    }
+    if (rotate) {
+      openLocked();
+    }
+  }
+}
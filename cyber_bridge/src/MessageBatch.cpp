@@ -0,0 +1,211 @@
+#include "MessageBatch.hpp"
+
+#include <google/protobuf/descriptor.pb.h>
+#include <google/protobuf/descriptor_database.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "logger/log.h"
+
+namespace {
+
+constexpr const char* kPackage = "fox_bridge.batch";
+// 单帧大小上限，超出时不等窗口到期直接发送
+constexpr size_t kMaxFrameBytes = 256 * 1024;
+// BatchFlusher 的检查周期，帧的最大延迟约为 batch_ms + kFlushTick
+constexpr auto kFlushTick = std::chrono::milliseconds(5);
+
+uint64_t steadyNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch())
+    .count();
+}
+
+uint64_t systemNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+void writeVarint(std::string& output, uint64_t value) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+MessageBatch::MessageBatch(uint32_t window_ms, std::shared_ptr<BatchTotals> totals)
+    : _window_ns(static_cast<uint64_t>(window_ms) * 1000000ull)
+    , _totals(std::move(totals)) {}
+
+std::shared_ptr<MessageBatch> MessageBatch::create(const std::string& topic,
+  const google::protobuf::Descriptor* source, const std::string& source_fd_set,
+  uint32_t window_ms, std::shared_ptr<BatchTotals> totals, std::string& error) {
+  if (!source) {
+    error = "unknown message type";
+    return nullptr;
+  }
+  google::protobuf::FileDescriptorSet fd_set;
+  if (!fd_set.ParseFromString(source_fd_set)) {
+    error = "invalid source schema";
+    return nullptr;
+  }
+
+  // 输出消息引用源类型所在的文件，源类型及其依赖原样保留在 FileDescriptorSet 中
+  google::protobuf::FileDescriptorProto file;
+  std::string message_name = source->name() + "Batch";
+  file.set_name(std::string("fox_bridge/batch/") + source->full_name() + ".proto");
+  file.set_package(kPackage);
+  file.set_syntax("proto3");
+  file.add_dependency(source->file()->name());
+  auto* message = file.add_message_type();
+  message->set_name(message_name);
+  auto* messages = message->add_field();
+  messages->set_name("messages");
+  messages->set_number(1);
+  messages->set_type(google::protobuf::FieldDescriptorProto::TYPE_MESSAGE);
+  messages->set_type_name("." + source->full_name());
+  messages->set_label(google::protobuf::FieldDescriptorProto::LABEL_REPEATED);
+  auto* log_time = message->add_field();
+  log_time->set_name("log_time");
+  log_time->set_number(2);
+  log_time->set_type(google::protobuf::FieldDescriptorProto::TYPE_FIXED64);
+  log_time->set_label(google::protobuf::FieldDescriptorProto::LABEL_REPEATED);
+
+  google::protobuf::SimpleDescriptorDatabase database;
+  for (const auto& source_file : fd_set.file()) {
+    database.Add(source_file);
+  }
+  database.Add(file);
+  google::protobuf::DescriptorPool pool(&database);
+  std::string type_name = std::string(kPackage) + "." + message_name;
+  if (!pool.FindMessageTypeByName(type_name)) {
+    error = "invalid batch schema for " + topic;
+    return nullptr;
+  }
+  *fd_set.add_file() = file;
+
+  auto batch = std::shared_ptr<MessageBatch>(new MessageBatch(window_ms, std::move(totals)));
+  batch->_type_name = std::move(type_name);
+  batch->_fd_set = fd_set.SerializeAsString();
+  return batch;
+}
+
+void MessageBatch::add(const std::string& message) {
+  uint64_t now = steadyNs();
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (_times.empty()) {
+    _first_ns = now;
+  }
+  // 字段 1，wire 类型 length-delimited
+  _frame.push_back(static_cast<char>((1 << 3) | 2));
+  writeVarint(_frame, message.size());
+  _frame.append(message);
+  _times.push_back(systemNs());
+  if (now - _first_ns >= _window_ns || _frame.size() >= kMaxFrameBytes) {
+    flushLocked();
+  }
+}
+
+void MessageBatch::flushExpired(uint64_t now_ns) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_times.empty() && now_ns - _first_ns >= _window_ns) {
+    flushLocked();
+  }
+}
+
+void MessageBatch::flushLocked() {
+  // 最后一个订阅者已取消，丢弃未发送的帧
+  if (!_channel->has_sinks()) {
+    _frame.clear();
+    _times.clear();
+    return;
+  }
+  // 字段 2，packed fixed64，按 protobuf 规定的小端序写入，不依赖主机字节序
+  _frame.push_back(static_cast<char>((2 << 3) | 2));
+  writeVarint(_frame, _times.size() * sizeof(uint64_t));
+  for (uint64_t time : _times) {
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+      _frame.push_back(static_cast<char>((time >> (8 * i)) & 0xff));
+    }
+  }
+
+  auto result = _channel->log(reinterpret_cast<const std::byte*>(_frame.data()), _frame.size());
+  if (result != foxglove::FoxgloveError::Ok) {
+    LOG_ERROR << "Failed to log batch: " << foxglove::strerror(result);
+  } else {
+    _totals->messages.fetch_add(_times.size(), std::memory_order_relaxed);
+    _totals->frames.fetch_add(1, std::memory_order_relaxed);
+  }
+  _frame.clear();
+  _times.clear();
+}
+
+BatchFlusher::BatchFlusher()
+    : _totals(std::make_shared<BatchTotals>())
+    , _last_collect(steadyNs()) {}
+
+BatchFlusher::~BatchFlusher() {
+  stop();
+}
+
+void BatchFlusher::add(const std::shared_ptr<MessageBatch>& batch) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _batches.push_back(batch);
+  if (!_running) {
+    _running = true;
+    _thread = std::thread(&BatchFlusher::run, this);
+  }
+}
+
+void BatchFlusher::remove(const std::shared_ptr<MessageBatch>& batch) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  _batches.erase(std::remove(_batches.begin(), _batches.end(), batch), _batches.end());
+}
+
+void BatchFlusher::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+}
+
+void BatchFlusher::collect(BridgeMetrics::Values& values) {
+  uint64_t messages = _totals->messages.load(std::memory_order_relaxed);
+  uint64_t frames = _totals->frames.load(std::memory_order_relaxed);
+  uint64_t saved = messages - std::min(messages, frames);
+  uint64_t now = steadyNs();
+  std::lock_guard<std::mutex> lock(_mutex);
+  values["fox_bridge_batch_topics"] = _batches.size();
+  values["fox_bridge_batch_messages"] = messages;
+  values["fox_bridge_batch_frames"] = frames;
+  values["fox_bridge_batch_saved_frames"] = saved;
+  uint64_t elapsed_ms = (now - _last_collect) / 1000000;
+  if (elapsed_ms > 0) {
+    values["fox_bridge_batch_saved_per_s"] = (saved - _last_saved) * 1000 / elapsed_ms;
+  }
+  _last_saved = saved;
+  _last_collect = now;
+}
+
+void BatchFlusher::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running) {
+    _cv.wait_for(lock, kFlushTick);
+    uint64_t now = steadyNs();
+    for (const auto& batch : _batches) {
+      batch->flushExpired(now);
+    }
+  }
+}
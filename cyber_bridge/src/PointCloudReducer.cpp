@@ -0,0 +1,356 @@
+#include "PointCloudReducer.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+namespace {
+
+// 体素坐标每轴 21 位，拼成 64 位 key；超出范围的点直接丢弃
+constexpr int kVoxelBits = 21;
+constexpr int32_t kVoxelLimit = 1 << (kVoxelBits - 1);
+constexpr uint32_t kEmptySlot = std::numeric_limits<uint32_t>::max();
+
+// 4 路 float / int32 向量，x86 上编译为 SSE，aarch64 上编译为 NEON
+typedef float VecF __attribute__((vector_size(16)));
+typedef int32_t VecI __attribute__((vector_size(16)));
+constexpr size_t kLanes = sizeof(VecF) / sizeof(float);
+
+VecF splat(float value) {
+  VecF v;
+  for (size_t lane = 0; lane < kLanes; ++lane) {
+    v[lane] = value;
+  }
+  return v;
+}
+
+VecF load(const float* data) {
+  VecF v;
+  std::memcpy(&v, data, sizeof(v));
+  return v;
+}
+
+// 预先换算好的裁剪参数
+struct Filter {
+  bool roi = false;
+  bool range = false;
+  bool voxel = false;
+  float lo[3] = {0, 0, 0};
+  float hi[3] = {0, 0, 0};
+  float min2 = 0;
+  float max2 = 0;
+  float inv_voxel = 0;
+
+  explicit Filter(const CloudOptions& options) {
+    roi = options.roi;
+    for (int axis = 0; axis < 3; ++axis) {
+      lo[axis] = options.roi_min[axis];
+      hi[axis] = options.roi_max[axis];
+    }
+    range = options.min_range > 0 || options.max_range > 0;
+    min2 = options.min_range * options.min_range;
+    max2 = options.max_range > 0 ? options.max_range * options.max_range
+                                 : std::numeric_limits<float>::infinity();
+    voxel = options.voxel > 0;
+    inv_voxel = voxel ? 1.0f / options.voxel : 0;
+  }
+};
+
+uint64_t voxelKey(int32_t ix, int32_t iy, int32_t iz) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(ix + kVoxelLimit)) |
+         static_cast<uint64_t>(static_cast<uint32_t>(iy + kVoxelLimit)) << kVoxelBits |
+         static_cast<uint64_t>(static_cast<uint32_t>(iz + kVoxelLimit)) << (2 * kVoxelBits);
+}
+
+struct Accum {
+  float x, y, z, intensity;
+  uint32_t count;
+};
+
+// 每个线程复用的中间结果
+struct Scratch {
+  std::vector<uint32_t> index;  // 通过裁剪的点，前 count 项有效
+  std::vector<uint64_t> key;    // 对应的体素 key，未开启体素时为空
+  size_t count = 0;
+  std::vector<uint32_t> slots;  // 开放寻址哈希表，存 accums 下标
+  std::vector<uint64_t> slot_keys;
+  std::vector<Accum> accums;  // 按体素首次出现的顺序
+
+  static Scratch& local() {
+    thread_local Scratch scratch;
+    return scratch;
+  }
+};
+
+bool scalarKeep(const Filter& filter, float x, float y, float z, uint64_t& key) {
+  // 同时排除 NaN 与 inf
+  if (!(x >= -FLT_MAX && x <= FLT_MAX && y >= -FLT_MAX && y <= FLT_MAX && z >= -FLT_MAX &&
+        z <= FLT_MAX)) {
+    return false;
+  }
+  if (filter.roi && !(x >= filter.lo[0] && x <= filter.hi[0] && y >= filter.lo[1] &&
+                      y <= filter.hi[1] && z >= filter.lo[2] && z <= filter.hi[2])) {
+    return false;
+  }
+  if (filter.range) {
+    float r2 = x * x + y * y + z * z;
+    if (!(r2 >= filter.min2 && r2 <= filter.max2)) {
+      return false;
+    }
+  }
+  if (filter.voxel) {
+    float fx = x * filter.inv_voxel;
+    float fy = y * filter.inv_voxel;
+    float fz = z * filter.inv_voxel;
+    constexpr float limit = static_cast<float>(kVoxelLimit);
+    if (!(fx >= -limit && fx < limit && fy >= -limit && fy < limit && fz >= -limit &&
+          fz < limit)) {
+      return false;
+    }
+    key = voxelKey(static_cast<int32_t>(std::floor(fx)), static_cast<int32_t>(std::floor(fy)),
+      static_cast<int32_t>(std::floor(fz)));
+  }
+  return true;
+}
+
+void selectScalar(const CloudView& input, const Filter& filter, size_t begin, Scratch& scratch) {
+  for (size_t i = begin; i < input.size; ++i) {
+    uint64_t key = 0;
+    if (scalarKeep(filter, input.x[i], input.y[i], input.z[i], key)) {
+      if (filter.voxel) {
+        scratch.key[scratch.count] = key;
+      }
+      scratch.index[scratch.count++] = static_cast<uint32_t>(i);
+    }
+  }
+}
+
+// 截断取整后对负数修正，得到 floor；被丢弃的通道先置 0，避免越界转换
+VecI floorToInt(VecF value, VecI keep) {
+  value = reinterpret_cast<VecF>(reinterpret_cast<VecI>(value) & keep);
+  VecI truncated = __builtin_convertvector(value, VecI);
+  return truncated + (__builtin_convertvector(truncated, VecF) > value);
+}
+
+// 返回向量化处理到的位置，剩余不足 4 个的点由 selectScalar 处理
+size_t selectVector(const CloudView& input, const Filter& filter, Scratch& scratch) {
+  const VecF max_value = splat(FLT_MAX);
+  const VecF min_value = splat(-FLT_MAX);
+  const VecF lo[3] = {splat(filter.lo[0]), splat(filter.lo[1]), splat(filter.lo[2])};
+  const VecF hi[3] = {splat(filter.hi[0]), splat(filter.hi[1]), splat(filter.hi[2])};
+  const VecF min2 = splat(filter.min2);
+  const VecF max2 = splat(filter.max2);
+  const VecF inv_voxel = splat(filter.inv_voxel);
+  const VecF limit = splat(static_cast<float>(kVoxelLimit));
+
+  size_t i = 0;
+  for (; i + kLanes <= input.size; i += kLanes) {
+    VecF x = load(input.x + i);
+    VecF y = load(input.y + i);
+    VecF z = load(input.z + i);
+    VecI keep = (x >= min_value) & (x <= max_value) & (y >= min_value) & (y <= max_value) &
+                (z >= min_value) & (z <= max_value);
+    if (filter.roi) {
+      keep &= (x >= lo[0]) & (x <= hi[0]) & (y >= lo[1]) & (y <= hi[1]) & (z >= lo[2]) &
+              (z <= hi[2]);
+    }
+    if (filter.range) {
+      VecF r2 = x * x + y * y + z * z;
+      keep &= (r2 >= min2) & (r2 <= max2);
+    }
+    VecI ix{}, iy{}, iz{};
+    if (filter.voxel) {
+      VecF fx = x * inv_voxel;
+      VecF fy = y * inv_voxel;
+      VecF fz = z * inv_voxel;
+      keep &= (fx >= -limit) & (fx < limit) & (fy >= -limit) & (fy < limit) & (fz >= -limit) &
+              (fz < limit);
+      ix = floorToInt(fx, keep);
+      iy = floorToInt(fy, keep);
+      iz = floorToInt(fz, keep);
+    }
+    // 无分支压缩：先写入再按掩码推进
+    for (size_t lane = 0; lane < kLanes; ++lane) {
+      if (filter.voxel) {
+        scratch.key[scratch.count] = voxelKey(ix[lane], iy[lane], iz[lane]);
+      }
+      scratch.index[scratch.count] = static_cast<uint32_t>(i + lane);
+      scratch.count += keep[lane] & 1;
+    }
+  }
+  return i;
+}
+
+void writePoint(float* out, bool intensity, float x, float y, float z, float value) {
+  out[0] = x;
+  out[1] = y;
+  out[2] = z;
+  if (intensity) {
+    out[3] = value;
+  }
+}
+
+// 同一体素内的点取平均，输出顺序为体素首次出现的顺序
+size_t aggregate(const CloudView& input, const CloudOptions& options, Scratch& scratch,
+  std::vector<std::byte>& output) {
+  size_t count = scratch.count;
+  size_t capacity = 16;
+  while (capacity < count * 2) {
+    capacity <<= 1;
+  }
+  scratch.slots.assign(capacity, kEmptySlot);
+  scratch.slot_keys.resize(capacity);
+  scratch.accums.clear();
+  const size_t mask = capacity - 1;
+  const int shift = 64 - __builtin_ctzll(capacity);
+  for (size_t n = 0; n < count; ++n) {
+    uint32_t i = scratch.index[n];
+    uint64_t key = scratch.key[n];
+    size_t slot = static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> shift) & mask;
+    while (scratch.slots[slot] != kEmptySlot && scratch.slot_keys[slot] != key) {
+      slot = (slot + 1) & mask;
+    }
+    float value = input.intensity ? input.intensity[i] : 0;
+    if (scratch.slots[slot] == kEmptySlot) {
+      scratch.slots[slot] = static_cast<uint32_t>(scratch.accums.size());
+      scratch.slot_keys[slot] = key;
+      scratch.accums.push_back({input.x[i], input.y[i], input.z[i], value, 1});
+      continue;
+    }
+    Accum& accum = scratch.accums[scratch.slots[slot]];
+    accum.x += input.x[i];
+    accum.y += input.y[i];
+    accum.z += input.z[i];
+    accum.intensity += value;
+    accum.count++;
+  }
+
+  const size_t floats = options.stride() / sizeof(float);
+  output.resize(scratch.accums.size() * options.stride());
+  auto* out = reinterpret_cast<float*>(output.data());
+  for (const auto& accum : scratch.accums) {
+    float scale = 1.0f / static_cast<float>(accum.count);
+    writePoint(out, options.intensity, accum.x * scale, accum.y * scale, accum.z * scale,
+      accum.intensity * scale);
+    out += floats;
+  }
+  return scratch.accums.size();
+}
+
+std::string formatFloat(float value) {
+  std::ostringstream stream;
+  stream << value;
+  return stream.str();
+}
+
+bool parseFloats(const std::string& value, float* result, size_t count) {
+  std::istringstream stream(value);
+  std::string item;
+  size_t n = 0;
+  while (std::getline(stream, item, ':')) {
+    if (n >= count) {
+      return false;
+    }
+    try {
+      result[n++] = std::stof(item);
+    } catch (...) {
+      return false;
+    }
+  }
+  return n == count;
+}
+
+}  // namespace
+
+bool CloudOptions::parse(const std::string& spec, CloudOptions& options) {
+  if (spec.empty() || spec == "off") {
+    options = CloudOptions();
+    return true;
+  }
+  CloudOptions parsed;
+  parsed.enabled = true;
+  std::istringstream stream(spec);
+  std::string item;
+  while (std::getline(stream, item, ',')) {
+    auto pos = item.find('=');
+    if (pos == std::string::npos) {
+      return false;
+    }
+    std::string key = item.substr(0, pos);
+    std::string value = item.substr(pos + 1);
+    if (key == "voxel") {
+      if (!parseFloats(value, &parsed.voxel, 1) || parsed.voxel < 0) {
+        return false;
+      }
+    } else if (key == "range") {
+      float range[2];
+      if (!parseFloats(value, range, 2) || range[0] < 0 || range[1] < 0) {
+        return false;
+      }
+      parsed.min_range = range[0];
+      parsed.max_range = range[1];
+    } else if (key == "roi") {
+      float roi[6];
+      if (!parseFloats(value, roi, 6)) {
+        return false;
+      }
+      parsed.roi = true;
+      for (int axis = 0; axis < 3; ++axis) {
+        parsed.roi_min[axis] = roi[axis * 2];
+        parsed.roi_max[axis] = roi[axis * 2 + 1];
+      }
+    } else if (key == "intensity") {
+      parsed.intensity = value == "1" || value == "true";
+    } else {
+      return false;
+    }
+  }
+  options = parsed;
+  return true;
+}
+
+std::string CloudOptions::toString() const {
+  if (!enabled) {
+    return "off";
+  }
+  std::string spec = "voxel=" + formatFloat(voxel);
+  if (min_range > 0 || max_range > 0) {
+    spec += ",range=" + formatFloat(min_range) + ":" + formatFloat(max_range);
+  }
+  if (roi) {
+    spec += ",roi=";
+    for (int axis = 0; axis < 3; ++axis) {
+      spec += formatFloat(roi_min[axis]) + ":" + formatFloat(roi_max[axis]);
+      spec += axis < 2 ? ":" : "";
+    }
+  }
+  spec += intensity ? ",intensity=1" : ",intensity=0";
+  return spec;
+}
+
+size_t PointCloudReducer::reduce(const CloudView& input, const CloudOptions& options,
+  std::vector<std::byte>& output, Path path) {
+  Filter filter(options);
+  auto& scratch = Scratch::local();
+  scratch.count = 0;
+  scratch.index.resize(input.size);
+  scratch.key.resize(filter.voxel ? input.size : 0);
+  size_t begin = path == Path::Vector ? selectVector(input, filter, scratch) : 0;
+  selectScalar(input, filter, begin, scratch);
+
+  if (filter.voxel) {
+    return aggregate(input, options, scratch, output);
+  }
+  const size_t floats = options.stride() / sizeof(float);
+  output.resize(scratch.count * options.stride());
+  auto* out = reinterpret_cast<float*>(output.data());
+  for (size_t n = 0; n < scratch.count; ++n) {
+    uint32_t i = scratch.index[n];
+    float value = input.intensity ? input.intensity[i] : 0;
+    writePoint(out, options.intensity, input.x[i], input.y[i], input.z[i], value);
+    out += floats;
+  }
+  return scratch.count;
+}
@@ -0,0 +1,319 @@
+#include "PointCloudStage.hpp"
+
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include <foxglove/schemas.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "HeaderFields.hpp"
+#include "logger/log.h"
+#include "protoPool.hpp"
+
+namespace {
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+constexpr const char* kColumnNames[4] = {"x", "y", "z", "intensity"};
+
+// 每个线程复用的解码结果，按列存放
+struct Columns {
+  std::vector<float> values[4];
+  std::vector<std::byte> points;  // 降采样输出
+  std::string output;             // 序列化后的 PointCloud
+
+  static Columns& local() {
+    thread_local Columns columns;
+    return columns;
+  }
+};
+
+bool isNumeric(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_FLOAT:
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+    case FieldDescriptor::CPPTYPE_INT32:
+    case FieldDescriptor::CPPTYPE_UINT32:
+    case FieldDescriptor::CPPTYPE_INT64:
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return !field->is_repeated();
+    default:
+      return false;
+  }
+}
+
+float defaultValue(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return field->default_value_float();
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return static_cast<float>(field->default_value_double());
+    case FieldDescriptor::CPPTYPE_INT32:
+      return static_cast<float>(field->default_value_int32());
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return static_cast<float>(field->default_value_uint32());
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<float>(field->default_value_int64());
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return static_cast<float>(field->default_value_uint64());
+    default:
+      return 0;
+  }
+}
+
+// 按字段声明的类型读取一个数值；wire 类型与声明不符时返回 false
+bool readNumber(CodedInputStream& input, uint32_t tag, int type, float& value) {
+  auto wire_type = WireFormatLite::GetTagWireType(tag);
+  uint32_t u32 = 0;
+  uint64_t u64 = 0;
+  switch (type) {
+    case FieldDescriptor::TYPE_FLOAT:
+    case FieldDescriptor::TYPE_FIXED32:
+    case FieldDescriptor::TYPE_SFIXED32:
+      if (wire_type != WireFormatLite::WIRETYPE_FIXED32 || !input.ReadLittleEndian32(&u32)) {
+        return false;
+      }
+      if (type == FieldDescriptor::TYPE_FLOAT) {
+        std::memcpy(&value, &u32, sizeof(value));
+      } else if (type == FieldDescriptor::TYPE_FIXED32) {
+        value = static_cast<float>(u32);
+      } else {
+        value = static_cast<float>(static_cast<int32_t>(u32));
+      }
+      return true;
+    case FieldDescriptor::TYPE_DOUBLE:
+    case FieldDescriptor::TYPE_FIXED64:
+    case FieldDescriptor::TYPE_SFIXED64:
+      if (wire_type != WireFormatLite::WIRETYPE_FIXED64 || !input.ReadLittleEndian64(&u64)) {
+        return false;
+      }
+      if (type == FieldDescriptor::TYPE_DOUBLE) {
+        double number;
+        std::memcpy(&number, &u64, sizeof(number));
+        value = static_cast<float>(number);
+      } else if (type == FieldDescriptor::TYPE_FIXED64) {
+        value = static_cast<float>(u64);
+      } else {
+        value = static_cast<float>(static_cast<int64_t>(u64));
+      }
+      return true;
+    default:
+      if (wire_type != WireFormatLite::WIRETYPE_VARINT || !input.ReadVarint64(&u64)) {
+        return false;
+      }
+      if (type == FieldDescriptor::TYPE_SINT32 || type == FieldDescriptor::TYPE_SINT64) {
+        value = static_cast<float>(WireFormatLite::ZigZagDecode64(u64));
+      } else if (type == FieldDescriptor::TYPE_UINT32 || type == FieldDescriptor::TYPE_UINT64) {
+        value = static_cast<float>(u64);
+      } else {
+        value = static_cast<float>(static_cast<int64_t>(u64));
+      }
+      return true;
+  }
+}
+
+foxglove::schemas::PackedElementField floatField(const char* name, uint32_t offset) {
+  foxglove::schemas::PackedElementField field;
+  field.name = name;
+  field.offset = offset;
+  field.type = foxglove::schemas::PackedElementField::NumericType::FLOAT32;
+  return field;
+}
+
+}  // namespace
+
+PointCloudStage::PointCloudStage(std::string topic, std::shared_ptr<const TypeInfo> type,
+  CloudOptions options, std::shared_ptr<TopicMetrics> metrics)
+    : _topic(std::move(topic))
+    , _type(std::move(type))
+    , _metrics(std::move(metrics))
+    , _options(std::make_shared<const CloudOptions>(options)) {
+  const auto* point = _type->descriptor()->FindFieldByName("point");
+  _point_field = point->number();
+  for (int i = 0; i < 4; ++i) {
+    const auto* field = point->message_type()->FindFieldByName(kColumnNames[i]);
+    if (field && isNumeric(field)) {
+      _columns[i].number = field->number();
+      _columns[i].type = field->type();
+      _columns[i].default_value = defaultValue(field);
+    }
+  }
+}
+
+bool PointCloudStage::isCloudType(const google::protobuf::Descriptor* descriptor) {
+  if (!descriptor) {
+    return false;
+  }
+  const auto* point = descriptor->FindFieldByName("point");
+  if (!point || !point->is_repeated() || point->cpp_type() != FieldDescriptor::CPPTYPE_MESSAGE) {
+    return false;
+  }
+  for (const char* name : {"x", "y", "z"}) {
+    const auto* field = point->message_type()->FindFieldByName(name);
+    if (!field || !isNumeric(field)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PointCloudStage::decode(const std::string& message, std::string& rest) {
+  auto& columns = Columns::local();
+  // 每个点在 wire 上至少约 15 字节，按此预留避免反复扩容
+  for (auto& values : columns.values) {
+    values.clear();
+    values.reserve(message.size() / 15);
+  }
+  rest.clear();
+  const auto* data = reinterpret_cast<const uint8_t*>(message.data());
+  CodedInputStream input(data, static_cast<int>(message.size()));
+  input.SetTotalBytesLimit(std::numeric_limits<int>::max());
+  while (true) {
+    int begin = input.CurrentPosition();
+    uint32_t tag = input.ReadTag();
+    if (tag == 0) {
+      return input.ConsumedEntireMessage();
+    }
+    if (WireFormatLite::GetTagFieldNumber(tag) != _point_field ||
+        WireFormatLite::GetTagWireType(tag) != WireFormatLite::WIRETYPE_LENGTH_DELIMITED) {
+      // 其他字段原样保留，稍后单独解析 header 等字段
+      if (!WireFormatLite::SkipField(&input, tag)) {
+        return false;
+      }
+      rest.append(message, begin, input.CurrentPosition() - begin);
+      continue;
+    }
+    uint32_t length = 0;
+    if (!input.ReadVarint32(&length)) {
+      return false;
+    }
+    auto limit = input.PushLimit(static_cast<int>(length));
+    float point[4];
+    for (int i = 0; i < 4; ++i) {
+      point[i] = _columns[i].default_value;
+    }
+    while (uint32_t field_tag = input.ReadTag()) {
+      int number = WireFormatLite::GetTagFieldNumber(field_tag);
+      int column = 0;
+      while (column < 4 && _columns[column].number != number) {
+        ++column;
+      }
+      bool ok = column < 4 ? readNumber(input, field_tag, _columns[column].type, point[column])
+                           : WireFormatLite::SkipField(&input, field_tag);
+      if (!ok) {
+        return false;
+      }
+    }
+    if (!input.ConsumedEntireMessage()) {
+      return false;
+    }
+    input.PopLimit(limit);
+    for (int i = 0; i < 4; ++i) {
+      columns.values[i].push_back(point[i]);
+    }
+  }
+}
+
+bool PointCloudStage::offer(const std::string& message, Deliver deliver) {
+  auto begin = std::chrono::steady_clock::now();
+  auto options = std::atomic_load(&_options);
+  auto& columns = Columns::local();
+  thread_local std::string rest;
+  if (!decode(message, rest)) {
+    if (_errors.fetch_add(1, std::memory_order_relaxed) == 0) {
+      LOG_WARN << "Failed to decode point cloud: " << _topic;
+    }
+    return false;
+  }
+
+  CloudView view;
+  view.x = columns.values[0].data();
+  view.y = columns.values[1].data();
+  view.z = columns.values[2].data();
+  view.intensity = _columns[3].number ? columns.values[3].data() : nullptr;
+  view.size = columns.values[0].size();
+  size_t count = PointCloudReducer::reduce(view, *options, columns.points);
+
+  foxglove::schemas::PointCloud cloud;
+  std::unique_ptr<google::protobuf::Message> header(_type->prototype()->New());
+  if (header->ParseFromString(rest)) {
+    cloud.frame_id = headerFrameId(*header);
+    cloud.timestamp = headerTimestamp(*header);
+  }
+  cloud.point_stride = options->stride();
+  cloud.fields = {floatField("x", 0), floatField("y", 4), floatField("z", 8)};
+  if (options->intensity) {
+    cloud.fields.push_back(floatField("intensity", 12));
+  }
+  // 借用线程内缓冲区，序列化后还回，避免每帧重新分配
+  cloud.data.swap(columns.points);
+  size_t encoded_len = 0;
+  columns.output.resize(cloud.data.size() + 256);
+  auto result = cloud.encode(
+    reinterpret_cast<uint8_t*>(columns.output.data()), columns.output.size(), &encoded_len);
+  if (result == foxglove::FoxgloveError::BufferTooShort) {
+    columns.output.resize(encoded_len);
+    result = cloud.encode(
+      reinterpret_cast<uint8_t*>(columns.output.data()), columns.output.size(), &encoded_len);
+  }
+  cloud.data.swap(columns.points);
+  if (result != foxglove::FoxgloveError::Ok) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+    LOG_WARN << "Failed to serialize PointCloud: " << foxglove::strerror(result);
+    return false;
+  }
+  columns.output.resize(encoded_len);
+
+  uint64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - begin)
+                          .count();
+  _last_reduce_us.store(elapsed_us, std::memory_order_relaxed);
+  if (_metrics) {
+    _metrics->encode_latency.record(elapsed_us);
+  }
+  _frames.fetch_add(1, std::memory_order_relaxed);
+  _points_in.fetch_add(view.size, std::memory_order_relaxed);
+  _points_out.fetch_add(count, std::memory_order_relaxed);
+  deliver(columns.output);
+  return true;
+}
+
+void PointCloudStage::setOptions(const CloudOptions& options) {
+  std::atomic_store(&_options, std::make_shared<const CloudOptions>(options));
+  LOG_INFO << "Point cloud options: " << _topic << " " << options.toString();
+}
+
+CloudOptions PointCloudStage::options() const {
+  return *std::atomic_load(&_options);
+}
+
+CloudStats PointCloudStage::stats() const {
+  CloudStats stats;
+  stats.topic = _topic;
+  stats.options = options().toString();
+  stats.frames = _frames.load(std::memory_order_relaxed);
+  stats.errors = _errors.load(std::memory_order_relaxed);
+  stats.points_in = _points_in.load(std::memory_order_relaxed);
+  stats.points_out = _points_out.load(std::memory_order_relaxed);
+  stats.last_reduce_us = _last_reduce_us.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void PointCloudStage::collect(BridgeMetrics::Values& values) const {
+  if (!_metrics) {
+    return;
+  }
+  auto current = stats();
+  const std::string name = _metrics->name + "_cloud";
+  values[name + "_frames"] = current.frames;
+  values[name + "_errors"] = current.errors;
+  values[name + "_points_in"] = current.points_in;
+  values[name + "_points_out"] = current.points_out;
+  values[name + "_reduce_us"] = current.last_reduce_us;
+}
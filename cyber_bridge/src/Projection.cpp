@@ -0,0 +1,610 @@
+#include "Projection.hpp"
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/descriptor.pb.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "ProtoArena.hpp"
+#include "logger/log.h"
+
+namespace {
+
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Message;
+
+constexpr const char* kPackage = "fox_bridge.projection";
+
+std::string trim(const std::string& text) {
+  size_t begin = text.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return "";
+  }
+  size_t end = text.find_last_not_of(" \t");
+  return text.substr(begin, end - begin + 1);
+}
+
+bool isIdentStart(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isIdentChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isIdentifier(const std::string& name) {
+  if (name.empty() || !isIdentStart(name[0])) {
+    return false;
+  }
+  for (char c : name) {
+    if (!isIdentChar(c)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 字段路径转为输出字段名：obstacle[0].position.x -> obstacle_0_position_x
+std::string fieldName(const std::string& path) {
+  std::string name;
+  for (char c : path) {
+    if (isIdentChar(c)) {
+      name.push_back(c);
+    } else if (!name.empty() && name.back() != '_') {
+      name.push_back('_');
+    }
+  }
+  while (!name.empty() && name.back() == '_') {
+    name.pop_back();
+  }
+  return name;
+}
+
+// 输出消息名：/plot/chassis -> PlotChassis
+std::string messageName(const std::string& topic) {
+  std::string name;
+  bool upper = true;
+  for (char c : topic) {
+    if (!std::isalnum(static_cast<unsigned char>(c))) {
+      upper = true;
+      continue;
+    }
+    name.push_back(upper ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : c);
+    upper = false;
+  }
+  if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0]))) {
+    name = "Projection" + name;
+  }
+  return name;
+}
+
+bool isNumericLeaf(const FieldDescriptor* field) {
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_STRING:
+    case FieldDescriptor::CPPTYPE_MESSAGE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+double readValue(const Message& msg, const FieldDescriptor* field, int index) {
+  const auto* reflection = msg.GetReflection();
+  bool repeated = index >= 0;
+  switch (field->cpp_type()) {
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return repeated ? reflection->GetRepeatedDouble(msg, field, index)
+                      : reflection->GetDouble(msg, field);
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return repeated ? reflection->GetRepeatedFloat(msg, field, index)
+                      : reflection->GetFloat(msg, field);
+    case FieldDescriptor::CPPTYPE_INT32:
+      return repeated ? reflection->GetRepeatedInt32(msg, field, index)
+                      : reflection->GetInt32(msg, field);
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return repeated ? reflection->GetRepeatedUInt32(msg, field, index)
+                      : reflection->GetUInt32(msg, field);
+    case FieldDescriptor::CPPTYPE_INT64:
+      return static_cast<double>(repeated ? reflection->GetRepeatedInt64(msg, field, index)
+                                          : reflection->GetInt64(msg, field));
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return static_cast<double>(repeated ? reflection->GetRepeatedUInt64(msg, field, index)
+                                          : reflection->GetUInt64(msg, field));
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return (repeated ? reflection->GetRepeatedBool(msg, field, index)
+                       : reflection->GetBool(msg, field))
+               ? 1.0
+               : 0.0;
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return repeated ? reflection->GetRepeatedEnumValue(msg, field, index)
+                      : reflection->GetEnumValue(msg, field);
+    default:
+      return std::numeric_limits<double>::quiet_NaN();
+  }
+}
+
+void writeVarint(std::string& output, uint64_t value) {
+  while (value >= 0x80) {
+    output.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  output.push_back(static_cast<char>(value));
+}
+
+}  // namespace
+
+bool ProjectionSpec::parse(const std::string& topic, const std::string& text,
+  ProjectionSpec& spec) {
+  spec = ProjectionSpec();
+  spec.topic = topic;
+  size_t colon = text.find(':');
+  if (topic.empty() || colon == std::string::npos) {
+    return false;
+  }
+  spec.source = trim(text.substr(0, colon));
+  // 逗号只在括号外分隔 item
+  std::string item;
+  int depth = 0;
+  for (size_t i = colon + 1; i <= text.size(); ++i) {
+    char c = i < text.size() ? text[i] : ',';
+    if (c == ',' && depth == 0) {
+      item = trim(item);
+      if (item.empty()) {
+        return false;
+      }
+      spec.items.push_back(item);
+      item.clear();
+      continue;
+    }
+    depth += c == '(' ? 1 : c == ')' ? -1 : 0;
+    item.push_back(c);
+  }
+  return !spec.source.empty() && depth == 0;
+}
+
+bool ProjectionSpec::fromJson(const nlohmann::json& j, ProjectionSpec& spec) {
+  spec = ProjectionSpec();
+  if (!j.is_object() || !j.contains("fields") || !j["fields"].is_array()) {
+    return false;
+  }
+  spec.topic = j.value("topic", "");
+  spec.source = j.value("source", "");
+  for (const auto& field : j["fields"]) {
+    if (!field.is_string() || trim(field.get<std::string>()).empty()) {
+      return false;
+    }
+    spec.items.push_back(trim(field.get<std::string>()));
+  }
+  return !spec.topic.empty() && !spec.source.empty() && !spec.items.empty();
+}
+
+std::string ProjectionSpec::toString() const {
+  std::string text = source + ":";
+  for (size_t i = 0; i < items.size(); ++i) {
+    text += (i ? "," : "") + items[i];
+  }
+  return text;
+}
+
+// 递归下降解析表达式，直接生成后缀指令
+class Projection::Parser {
+public:
+  Parser(Projection& owner, const std::string& text, std::vector<Op>& ops)
+      : _owner(owner)
+      , _text(text)
+      , _ops(ops) {}
+
+  bool parse(std::string& error) {
+    if (expr()) {
+      skip();
+      if (_pos == _text.size()) {
+        return true;
+      }
+    }
+    error = _error.empty() ? "unexpected '" + _text.substr(_pos) + "'" : _error;
+    return false;
+  }
+
+  size_t maxDepth() const {
+    return _max_depth;
+  }
+
+private:
+  void skip() {
+    while (_pos < _text.size() && std::isspace(static_cast<unsigned char>(_text[_pos]))) {
+      ++_pos;
+    }
+  }
+
+  bool accept(char c) {
+    skip();
+    if (_pos < _text.size() && _text[_pos] == c) {
+      ++_pos;
+      return true;
+    }
+    return false;
+  }
+
+  void emit(Op::Kind kind, double value = 0, uint32_t slot = 0) {
+    _ops.push_back({kind, value, slot});
+    if (kind == Op::Const || kind == Op::Load) {
+      _max_depth = std::max(_max_depth, ++_depth);
+    } else if (kind == Op::Add || kind == Op::Sub || kind == Op::Mul || kind == Op::Div) {
+      --_depth;
+    }
+  }
+
+  bool expr() {
+    if (!term()) {
+      return false;
+    }
+    while (true) {
+      if (accept('+')) {
+        if (!term()) {
+          return false;
+        }
+        emit(Op::Add);
+      } else if (accept('-')) {
+        if (!term()) {
+          return false;
+        }
+        emit(Op::Sub);
+      } else {
+        return true;
+      }
+    }
+  }
+
+  bool term() {
+    if (!unary()) {
+      return false;
+    }
+    while (true) {
+      if (accept('*')) {
+        if (!unary()) {
+          return false;
+        }
+        emit(Op::Mul);
+      } else if (accept('/')) {
+        if (!unary()) {
+          return false;
+        }
+        emit(Op::Div);
+      } else {
+        return true;
+      }
+    }
+  }
+
+  bool unary() {
+    if (accept('-')) {
+      if (!unary()) {
+        return false;
+      }
+      emit(Op::Neg);
+      return true;
+    }
+    return primary();
+  }
+
+  bool primary() {
+    skip();
+    if (accept('(')) {
+      return expr() && expect(')');
+    }
+    if (_pos >= _text.size()) {
+      _error = "unexpected end of expression";
+      return false;
+    }
+    char c = _text[_pos];
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+      const char* begin = _text.c_str() + _pos;
+      char* end = nullptr;
+      double value = std::strtod(begin, &end);
+      if (end == begin) {
+        _error = "invalid number at '" + _text.substr(_pos) + "'";
+        return false;
+      }
+      _pos += end - begin;
+      emit(Op::Const, value);
+      return true;
+    }
+    if (!isIdentStart(c)) {
+      _error = "unexpected '" + _text.substr(_pos) + "'";
+      return false;
+    }
+    size_t begin = _pos;
+    while (_pos < _text.size() && isIdentChar(_text[_pos])) {
+      ++_pos;
+    }
+    std::string name = _text.substr(begin, _pos - begin);
+    if (accept('(')) {
+      Op::Kind kind;
+      if (name == "abs") {
+        kind = Op::Abs;
+      } else if (name == "sqrt") {
+        kind = Op::Sqrt;
+      } else {
+        _error = "unknown function: " + name;
+        return false;
+      }
+      if (!expr() || !expect(')')) {
+        return false;
+      }
+      emit(kind);
+      return true;
+    }
+    // 字段路径：name(.name | [index])*，中间不允许空白
+    while (_pos < _text.size()) {
+      if (_text[_pos] == '.' && _pos + 1 < _text.size() && isIdentStart(_text[_pos + 1])) {
+        ++_pos;
+        while (_pos < _text.size() && isIdentChar(_text[_pos])) {
+          ++_pos;
+        }
+      } else if (_text[_pos] == '[') {
+        size_t close = _text.find(']', _pos);
+        if (close == std::string::npos) {
+          _error = "missing ']'";
+          return false;
+        }
+        _pos = close + 1;
+      } else {
+        break;
+      }
+    }
+    int slot = _owner.resolve(_text.substr(begin, _pos - begin), _error);
+    if (slot < 0) {
+      return false;
+    }
+    emit(Op::Load, 0, static_cast<uint32_t>(slot));
+    return true;
+  }
+
+  bool expect(char c) {
+    if (accept(c)) {
+      return true;
+    }
+    if (_error.empty()) {
+      _error = std::string("expected '") + c + "'";
+    }
+    return false;
+  }
+
+  Projection& _owner;
+  const std::string& _text;
+  std::vector<Op>& _ops;
+  size_t _pos = 0;
+  size_t _depth = 0;
+  size_t _max_depth = 0;
+  std::string _error;
+};
+
+int Projection::resolve(const std::string& path, std::string& error) {
+  for (size_t i = 0; i < _path_names.size(); ++i) {
+    if (_path_names[i] == path) {
+      return static_cast<int>(i);
+    }
+  }
+  std::vector<Step> steps;
+  const auto* descriptor = _prototype->GetDescriptor();
+  size_t pos = 0;
+  while (pos < path.size()) {
+    if (!descriptor) {
+      error = steps.back().field->name() + " is not a message";
+      return -1;
+    }
+    size_t end = path.find_first_of(".[", pos);
+    std::string name = path.substr(pos, end == std::string::npos ? end : end - pos);
+    const auto* field = descriptor->FindFieldByName(name);
+    if (!field) {
+      error = "no field " + name + " in " + descriptor->full_name();
+      return -1;
+    }
+    Step step{field, -1};
+    pos = end == std::string::npos ? path.size() : end;
+    if (pos < path.size() && path[pos] == '[') {
+      size_t close = path.find(']', pos);
+      std::string index = path.substr(pos + 1, close - pos - 1);
+      if (index.empty() || index.find_first_not_of("0123456789") != std::string::npos) {
+        error = "invalid index [" + index + "]";
+        return -1;
+      }
+      step.index = std::atoi(index.c_str());
+      pos = close + 1;
+    }
+    if (field->is_repeated() != (step.index >= 0)) {
+      error = name + (field->is_repeated() ? " is repeated, index required" : " is not repeated");
+      return -1;
+    }
+    if (pos < path.size() && path[pos] == '.') {
+      ++pos;
+    }
+    descriptor = field->cpp_type() == FieldDescriptor::CPPTYPE_MESSAGE ? field->message_type()
+                                                                        : nullptr;
+    steps.push_back(step);
+  }
+  if (steps.empty() || !isNumericLeaf(steps.back().field)) {
+    error = path + " is not a numeric field";
+    return -1;
+  }
+  _path_names.push_back(path);
+  _paths.push_back(std::move(steps));
+  return static_cast<int>(_paths.size() - 1);
+}
+
+std::shared_ptr<Projection> Projection::compile(const ProjectionSpec& spec,
+  std::shared_ptr<const Message> prototype, std::string& error) {
+  if (!prototype) {
+    error = "unknown source type";
+    return nullptr;
+  }
+  if (spec.items.empty()) {
+    error = "no fields";
+    return nullptr;
+  }
+  auto projection = std::make_shared<Projection>();
+  projection->_spec = spec;
+  projection->_prototype = std::move(prototype);
+
+  for (const auto& item : spec.items) {
+    std::string name;
+    std::string expression = item;
+    size_t assign = item.find('=');
+    if (assign != std::string::npos) {
+      name = trim(item.substr(0, assign));
+      expression = item.substr(assign + 1);
+      if (!isIdentifier(name)) {
+        error = "invalid output name: '" + name + "'";
+        return nullptr;
+      }
+    } else {
+      name = fieldName(item);
+    }
+    for (const auto& existing : projection->_outputs) {
+      if (existing == name) {
+        error = "duplicate output: " + name;
+        return nullptr;
+      }
+    }
+    std::vector<Op> ops;
+    Parser parser(*projection, expression, ops);
+    if (!parser.parse(error)) {
+      error = "'" + item + "': " + error;
+      return nullptr;
+    }
+    projection->_max_stack = std::max(projection->_max_stack, parser.maxDepth());
+    projection->_outputs.push_back(name);
+    projection->_programs.push_back(std::move(ops));
+  }
+
+  // 生成输出消息的 schema：proto3，字段全部为 double
+  google::protobuf::FileDescriptorProto file;
+  std::string message_name = messageName(spec.topic);
+  file.set_name(std::string("fox_bridge/projection/") + message_name + ".proto");
+  file.set_package(kPackage);
+  file.set_syntax("proto3");
+  auto* message = file.add_message_type();
+  message->set_name(message_name);
+  for (size_t i = 0; i < projection->_outputs.size(); ++i) {
+    auto* field = message->add_field();
+    field->set_name(projection->_outputs[i]);
+    field->set_number(static_cast<int>(i + 1));
+    field->set_type(google::protobuf::FieldDescriptorProto::TYPE_DOUBLE);
+    field->set_label(google::protobuf::FieldDescriptorProto::LABEL_OPTIONAL);
+  }
+  google::protobuf::DescriptorPool pool;
+  if (!pool.BuildFile(file)) {
+    error = "invalid output schema for " + spec.topic;
+    return nullptr;
+  }
+  google::protobuf::FileDescriptorSet fd_set;
+  *fd_set.add_file() = file;
+  projection->_fd_set = fd_set.SerializeAsString();
+  projection->_type_name = std::string(kPackage) + "." + message_name;
+  return projection;
+}
+
+double Projection::load(const Message& msg, const std::vector<Step>& path) const {
+  const Message* current = &msg;
+  for (size_t i = 0; i + 1 < path.size(); ++i) {
+    const auto& step = path[i];
+    const auto* reflection = current->GetReflection();
+    if (step.index < 0) {
+      current = &reflection->GetMessage(*current, step.field);
+    } else if (step.index < reflection->FieldSize(*current, step.field)) {
+      current = &reflection->GetRepeatedMessage(*current, step.field, step.index);
+    } else {
+      return std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+  const auto& leaf = path.back();
+  if (leaf.index >= 0 && leaf.index >= current->GetReflection()->FieldSize(*current, leaf.field)) {
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+  return readValue(*current, leaf.field, leaf.index);
+}
+
+void Projection::project(const Message& msg, std::string& output) const {
+  thread_local std::vector<double> values;
+  thread_local std::vector<double> stack;
+  // 每条消息每个字段路径只读取一次
+  values.resize(_paths.size());
+  for (size_t i = 0; i < _paths.size(); ++i) {
+    values[i] = load(msg, _paths[i]);
+  }
+  stack.resize(_max_stack);
+  output.clear();
+  for (size_t i = 0; i < _programs.size(); ++i) {
+    size_t top = 0;
+    for (const auto& op : _programs[i]) {
+      switch (op.kind) {
+        case Op::Const:
+          stack[top++] = op.value;
+          break;
+        case Op::Load:
+          stack[top++] = values[op.slot];
+          break;
+        case Op::Add:
+          --top;
+          stack[top - 1] += stack[top];
+          break;
+        case Op::Sub:
+          --top;
+          stack[top - 1] -= stack[top];
+          break;
+        case Op::Mul:
+          --top;
+          stack[top - 1] *= stack[top];
+          break;
+        case Op::Div:
+          --top;
+          stack[top - 1] /= stack[top];
+          break;
+        case Op::Neg:
+          stack[top - 1] = -stack[top - 1];
+          break;
+        case Op::Abs:
+          stack[top - 1] = std::fabs(stack[top - 1]);
+          break;
+        case Op::Sqrt:
+          stack[top - 1] = std::sqrt(stack[top - 1]);
+          break;
+      }
+    }
+    // 字段号 i + 1，wire 类型 fixed64
+    writeVarint(output, (static_cast<uint64_t>(i + 1) << 3) | 1);
+    char bytes[sizeof(double)];
+    std::memcpy(bytes, &stack[0], sizeof(double));
+    output.append(bytes, sizeof(double));
+  }
+}
+
+bool Projection::forward(
+  const std::string& message, const Message*& parsed, std::optional<uint64_t> sink_id) {
+  if (!_channel || !_channel->has_sinks()) {
+    return true;
+  }
+  if (!parsed || parsed->GetDescriptor() != _prototype->GetDescriptor()) {
+    auto* fresh = _prototype->New(ProtoArena::local().arena());
+    if (!fresh->ParseFromString(message)) {
+      _errors.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    parsed = fresh;
+  }
+  thread_local std::string output;
+  project(*parsed, output);
+  auto result = _channel->log(
+    reinterpret_cast<const std::byte*>(output.data()), output.size(), std::nullopt, sink_id);
+  if (result != foxglove::FoxgloveError::Ok) {
+    _errors.fetch_add(1, std::memory_order_relaxed);
+    LOG_ERROR << "Failed to log projection " << _spec.topic << ": " << foxglove::strerror(result);
+    return false;
+  }
+  _count.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
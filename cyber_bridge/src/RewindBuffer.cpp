@@ -0,0 +1,175 @@
+#include "RewindBuffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <queue>
+#include <utility>
+
+#include "BridgeConfig.hpp"
+
+namespace {
+
+uint64_t systemNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::system_clock::now().time_since_epoch())
+    .count();
+}
+
+}  // namespace
+
+RewindOptions RewindOptions::fromJson(const nlohmann::json& j) {
+  RewindOptions options;
+  if (!j.is_object()) {
+    return options;
+  }
+  options.enabled = j.value("enabled", options.enabled);
+  options.port = j.value("port", options.port);
+  options.window_s = j.value("window_s", options.window_s);
+  options.max_mb = j.value("max_mb", options.max_mb);
+  if (j.contains("topics") && j["topics"].is_array()) {
+    options.topics = j["topics"].get<std::vector<std::string>>();
+  }
+  return options;
+}
+
+RewindTrack::RewindTrack(
+  RewindBuffer& owner, std::string topic, const foxglove::RawChannel& channel)
+    : _owner(owner) {
+  _channel.topic = std::move(topic);
+  _channel.encoding = std::string(channel.message_encoding());
+  if (auto schema = channel.schema()) {
+    _channel.schema_name = schema->name;
+    _channel.schema_encoding = schema->encoding;
+    const auto* data = reinterpret_cast<const char*>(schema->data);
+    _channel.schema_data.assign(data, schema->data_len);
+  }
+}
+
+void RewindTrack::push(const std::string& message) {
+  uint64_t now = systemNs();
+  size_t freed = 0;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _entries.push_back({now, 0, std::make_shared<const std::string>(message)});
+    while (_entries.front().time_ns + _owner._window_ns < now) {
+      freed += _entries.front().data->size();
+      _entries.pop_front();
+    }
+  }
+  size_t bytes = _owner._bytes.fetch_add(message.size(), std::memory_order_relaxed);
+  _owner._bytes.fetch_sub(freed, std::memory_order_relaxed);
+  if (bytes + message.size() - freed > _owner._limit) {
+    _owner.evict();
+  }
+}
+
+RewindBuffer::RewindBuffer(RewindOptions options)
+    : _options(std::move(options))
+    , _window_ns(static_cast<uint64_t>(_options.window_s) * 1000000000ull)
+    , _limit(static_cast<size_t>(_options.max_mb) << 20) {}
+
+bool RewindBuffer::matches(const std::string& topic) const {
+  for (const auto& pattern : _options.topics) {
+    if (BridgeConfig::match(pattern, topic)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<RewindTrack> RewindBuffer::track(
+  const std::string& topic, const foxglove::RawChannel& channel) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto& track = _tracks[topic];
+  if (!track) {
+    track = std::make_shared<RewindTrack>(*this, topic, channel);
+  }
+  return track;
+}
+
+void RewindBuffer::evict() {
+  // 一次淘汰到上限的 95%，避免每条消息都扫描所有 topic
+  const size_t target = _limit - _limit / 20;
+  std::lock_guard<std::mutex> lock(_mutex);
+  size_t bytes = _bytes.load(std::memory_order_relaxed);
+  if (bytes <= target) {
+    return;
+  }
+  // 每个 topic 只加锁一次，按各 topic 队首时间的最小堆归并出全局最旧的消息，
+  // 累计到需要释放的字节数后，再从各 topic 的队首一次性删除
+  struct Cursor {
+    RewindTrack* track;
+    size_t count = 0;  // 该 topic 要淘汰的消息数
+  };
+  std::vector<std::unique_lock<std::mutex>> locks;
+  std::vector<Cursor> cursors;
+  using Head = std::pair<uint64_t, size_t>;  // 队首时间，cursors 下标
+  std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+  locks.reserve(_tracks.size());
+  cursors.reserve(_tracks.size());
+  for (const auto& [topic, track] : _tracks) {
+    locks.emplace_back(track->_mutex);
+    if (!track->_entries.empty()) {
+      heads.emplace(track->_entries.front().time_ns, cursors.size());
+      cursors.push_back({track.get()});
+    }
+  }
+  size_t freed = 0;
+  while (freed < bytes - target && !heads.empty()) {
+    auto& cursor = cursors[heads.top().second];
+    heads.pop();
+    const auto& entries = cursor.track->_entries;
+    freed += entries[cursor.count++].data->size();
+    if (cursor.count < entries.size()) {
+      heads.emplace(entries[cursor.count].time_ns, &cursor - cursors.data());
+    }
+  }
+  uint64_t evicted = 0;
+  for (auto& cursor : cursors) {
+    auto& entries = cursor.track->_entries;
+    entries.erase(entries.begin(), entries.begin() + cursor.count);
+    evicted += cursor.count;
+  }
+  _bytes.fetch_sub(freed, std::memory_order_relaxed);
+  _evicted.fetch_add(evicted, std::memory_order_relaxed);
+}
+
+RewindSnapshot RewindBuffer::snapshot() {
+  RewindSnapshot snapshot;
+  uint64_t now = systemNs();
+  uint64_t begin = now > _window_ns ? now - _window_ns : 0;
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (const auto& [topic, track] : _tracks) {
+    std::lock_guard<std::mutex> track_lock(track->_mutex);
+    auto index = static_cast<uint32_t>(snapshot.channels.size());
+    bool used = false;
+    for (const auto& entry : track->_entries) {
+      if (entry.time_ns < begin) {
+        continue;
+      }
+      snapshot.messages.push_back({entry.time_ns, index, entry.data});
+      snapshot.bytes += entry.data->size();
+      used = true;
+    }
+    if (used) {
+      snapshot.channels.push_back(track->_channel);
+    }
+  }
+  std::stable_sort(snapshot.messages.begin(), snapshot.messages.end(),
+    [](const RewindSnapshot::Message& a, const RewindSnapshot::Message& b) {
+      return a.time_ns < b.time_ns;
+    });
+  if (!snapshot.messages.empty()) {
+    snapshot.begin_ns = snapshot.messages.front().time_ns;
+    snapshot.end_ns = snapshot.messages.back().time_ns;
+  }
+  return snapshot;
+}
+
+void RewindBuffer::collect(BridgeMetrics::Values& values) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  values["fox_bridge_rewind_topics"] = _tracks.size();
+  values["fox_bridge_rewind_bytes"] = _bytes.load(std::memory_order_relaxed);
+  values["fox_bridge_rewind_evicted"] = _evicted.load(std::memory_order_relaxed);
+}
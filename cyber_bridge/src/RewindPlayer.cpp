@@ -0,0 +1,150 @@
+#include "RewindPlayer.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "logger/log.h"
+
+namespace {
+
+// 播放时 broadcastTime 与发送消息的周期
+constexpr auto kTick = std::chrono::milliseconds(10);
+
+}  // namespace
+
+RewindPlayer::RewindPlayer(RewindSnapshot snapshot)
+    : _snapshot(std::move(snapshot))
+    , _context(foxglove::Context::create())
+    , _clock(_snapshot.begin_ns, _snapshot.end_ns) {}
+
+RewindPlayer::~RewindPlayer() {
+  stop();
+}
+
+bool RewindPlayer::start(const std::string& host, uint16_t port) {
+  if (_snapshot.messages.empty()) {
+    LOG_WARN << "Rewind buffer is empty";
+    return false;
+  }
+  for (const auto& channel : _snapshot.channels) {
+    std::optional<foxglove::Schema> schema;
+    if (!channel.schema_name.empty()) {
+      schema = foxglove::Schema{channel.schema_name, channel.schema_encoding,
+        reinterpret_cast<const std::byte*>(channel.schema_data.data()),
+        channel.schema_data.size()};
+    }
+    auto result = foxglove::RawChannel::create(channel.topic, channel.encoding, schema, _context);
+    if (!result.has_value()) {
+      LOG_WARN << "Failed to create rewind channel: " << channel.topic << " "
+               << foxglove::strerror(result.error());
+      _channels.emplace_back();
+      continue;
+    }
+    _channels.push_back(std::make_unique<foxglove::RawChannel>(std::move(result.value())));
+  }
+
+  foxglove::WebSocketServerOptions options;
+  options.context = _context;
+  options.name = "FoxgloveServer/rewind";
+  options.host = host;
+  options.port = port;
+  options.capabilities = foxglove::WebSocketServerCapabilities::Time;
+  options.supported_encodings = {"json", "protobuf"};
+  options.playback_time_range = std::make_pair(_snapshot.begin_ns, _snapshot.end_ns);
+  options.callbacks.onPlaybackControlRequest =
+    [this](const foxglove::PlaybackControlRequest& request)
+    -> std::optional<foxglove::PlaybackState> {
+    return onControl(request);
+  };
+  auto server_result = foxglove::WebSocketServer::create(std::move(options));
+  if (!server_result.has_value()) {
+    LOG_ERROR << "Failed to create rewind server: " << foxglove::strerror(server_result.error());
+    return false;
+  }
+  _server = std::make_unique<foxglove::WebSocketServer>(std::move(server_result.value()));
+  _port = _server->port();
+  _running = true;
+  _thread = std::thread(&RewindPlayer::run, this);
+  LOG_INFO << "Rewind server listening on: " << host << ":" << _port
+           << " messages: " << _snapshot.messages.size() << " topics: " << _channels.size()
+           << " span_ms: " << (_snapshot.end_ns - _snapshot.begin_ns) / 1000000;
+  return true;
+}
+
+void RewindPlayer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  _server->stop();
+  _server.reset();
+  _channels.clear();
+}
+
+void RewindPlayer::logAt(size_t index) {
+  const auto& message = _snapshot.messages[index];
+  if (const auto& channel = _channels[message.channel]) {
+    channel->log(reinterpret_cast<const std::byte*>(message.data->data()), message.data->size(),
+      message.time_ns);
+  }
+}
+
+void RewindPlayer::logLatestBefore(size_t cursor) {
+  std::vector<bool> seen(_channels.size(), false);
+  std::vector<size_t> latest;
+  for (size_t i = cursor; i > 0 && latest.size() < _channels.size(); --i) {
+    uint32_t channel = _snapshot.messages[i - 1].channel;
+    if (!seen[channel]) {
+      seen[channel] = true;
+      latest.push_back(i - 1);
+    }
+  }
+  for (auto it = latest.rbegin(); it != latest.rend(); ++it) {
+    logAt(*it);
+  }
+}
+
+foxglove::PlaybackState RewindPlayer::onControl(const foxglove::PlaybackControlRequest& request) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  auto seek = _clock.apply(request);
+  if (seek) {
+    const auto& messages = _snapshot.messages;
+    _cursor = std::lower_bound(messages.begin(), messages.end(), *seek,
+                [](const RewindSnapshot::Message& message, uint64_t time) {
+                  return message.time_ns < time;
+                }) -
+              messages.begin();
+    logLatestBefore(_cursor);
+  }
+  _cv.notify_all();
+  return _clock.state(seek.has_value(), request.request_id);
+}
+
+void RewindPlayer::run() {
+  std::unique_lock<std::mutex> lock(_mutex);
+  const auto& messages = _snapshot.messages;
+  while (_running) {
+    if (!_clock.playing()) {
+      _cv.wait(lock);
+      continue;
+    }
+    uint64_t current = _clock.current();
+    while (_cursor < messages.size() && messages[_cursor].time_ns <= current) {
+      logAt(_cursor++);
+    }
+    _server->broadcastTime(current);
+    if (_cursor >= messages.size()) {
+      _clock.finish();
+      _server->broadcastPlaybackState(_clock.state(false));
+      continue;
+    }
+    _cv.wait_for(lock, kTick);
+  }
+}
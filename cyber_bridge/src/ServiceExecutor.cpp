@@ -0,0 +1,134 @@
+#include "ServiceExecutor.hpp"
+
+#include "logger/log.h"
+
+ServiceExecutor::ServiceExecutor(size_t threads, size_t max_running)
+    : _max_running(max_running) {
+  if (threads == 0) {
+    threads = 1;
+  }
+  for (size_t i = 0; i < threads; ++i) {
+    _workers.emplace_back(&ServiceExecutor::workerLoop, this);
+  }
+  LOG_INFO << "service executor started, threads: " << threads
+           << " max running per service: " << max_running;
+}
+
+ServiceExecutor::~ServiceExecutor() {
+  stop();
+}
+
+bool ServiceExecutor::submit(const std::string& service, uint32_t max_inflight, Task task) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& stats = _stats[service];
+    stats.service = service;
+    if (_stopped || (max_inflight > 0 && stats.inflight >= max_inflight)) {
+      ++stats.rejected;
+      return false;
+    }
+    ++stats.inflight;
+    auto& queue = _queues[service];
+    if (queue.tasks.empty()) {
+      _ready.push_back(service);
+    }
+    queue.tasks.push_back(std::move(task));
+  }
+  _cv.notify_one();
+  return true;
+}
+
+void ServiceExecutor::stop() {
+  std::vector<std::pair<std::string, Task>> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_stopped) {
+      return;
+    }
+    _stopped = true;
+    for (auto& [service, queue] : _queues) {
+      for (auto& task : queue.tasks) {
+        cancelled.emplace_back(service, std::move(task));
+      }
+      queue.tasks.clear();
+    }
+    _ready.clear();
+  }
+  _cv.notify_all();
+  for (auto& worker : _workers) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+  for (auto& [service, task] : cancelled) {
+    task(true);
+    finish(service);
+  }
+  LOG_INFO << "service executor stopped";
+}
+
+std::vector<ServiceStats> ServiceExecutor::stats() {
+  std::lock_guard<std::mutex> lock(_mutex);
+  std::vector<ServiceStats> result;
+  result.reserve(_stats.size());
+  for (const auto& [service, stats] : _stats) {
+    result.push_back(stats);
+  }
+  return result;
+}
+
+bool ServiceExecutor::takeLocked(std::string& service, Task& task) {
+  for (auto it = _ready.begin(); it != _ready.end(); ++it) {
+    auto& queue = _queues[*it];
+    if (_max_running > 0 && queue.running >= _max_running) {
+      continue;
+    }
+    service = *it;
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    ++queue.running;
+    // 取过任务的服务排到末尾，其他服务的请求不会排在它后面
+    _ready.erase(it);
+    if (!queue.tasks.empty()) {
+      _ready.push_back(service);
+    }
+    return true;
+  }
+  return false;
+}
+
+void ServiceExecutor::workerLoop() {
+  for (;;) {
+    std::string service;
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _cv.wait(lock, [&]() {
+        return _stopped || takeLocked(service, task);
+      });
+      if (_stopped) {
+        return;
+      }
+    }
+    task(false);
+    finish(service);
+  }
+}
+
+void ServiceExecutor::finish(const std::string& service) {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& stats = _stats[service];
+    --stats.inflight;
+    ++stats.completed;
+    auto it = _queues.find(service);
+    if (it != _queues.end() && it->second.running > 0) {
+      --it->second.running;
+      if (it->second.running == 0 && it->second.tasks.empty()) {
+        _queues.erase(it);
+      }
+    }
+  }
+  // 该服务的执行数下降后，排队的任务可能可以执行
+  _cv.notify_one();
+}
@@ -0,0 +1,224 @@
+#include "TfAggregator.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "BridgeConfig.hpp"
+#include "logger/log.h"
+
+namespace {
+
+bool sameVector(const std::optional<foxglove::schemas::Vector3>& a,
+  const std::optional<foxglove::schemas::Vector3>& b) {
+  if (!a || !b) {
+    return a.has_value() == b.has_value();
+  }
+  return a->x == b->x && a->y == b->y && a->z == b->z;
+}
+
+bool sameQuaternion(const std::optional<foxglove::schemas::Quaternion>& a,
+  const std::optional<foxglove::schemas::Quaternion>& b) {
+  if (!a || !b) {
+    return a.has_value() == b.has_value();
+  }
+  return a->x == b->x && a->y == b->y && a->z == b->z && a->w == b->w;
+}
+
+// 只比较父节点与位姿，时间戳不同不视为变化
+bool sameTransform(
+  const foxglove::schemas::FrameTransform& a, const foxglove::schemas::FrameTransform& b) {
+  return a.parent_frame_id == b.parent_frame_id && sameVector(a.translation, b.translation) &&
+         sameQuaternion(a.rotation, b.rotation);
+}
+
+}  // namespace
+
+TfOptions TfOptions::fromJson(const nlohmann::json& j) {
+  TfOptions options;
+  if (!j.is_object()) {
+    return options;
+  }
+  options.enabled = j.value("enabled", options.enabled);
+  options.topic = j.value("topic", options.topic);
+  options.static_topic = j.value("static_topic", options.static_topic);
+  options.hz = j.value("hz", options.hz);
+  if (j.contains("static_topics") && j["static_topics"].is_array()) {
+    options.static_topics = j["static_topics"].get<std::vector<std::string>>();
+  }
+  return options;
+}
+
+TfAggregator::TfAggregator(TfOptions options)
+    : _options(std::move(options)) {}
+
+TfAggregator::~TfAggregator() {
+  stop();
+}
+
+bool TfAggregator::isStaticSource(const std::string& topic) const {
+  return std::any_of(_options.static_topics.begin(), _options.static_topics.end(),
+    [&topic](const std::string& pattern) { return BridgeConfig::match(pattern, topic); });
+}
+
+bool TfAggregator::start() {
+  auto create = [](const std::string& topic) -> std::shared_ptr<foxglove::RawChannel> {
+    auto result = foxglove::RawChannel::create(
+      topic, "protobuf", foxglove::schemas::FrameTransforms::schema());
+    if (!result.has_value()) {
+      LOG_ERROR << "Failed to create channel: " << topic << " "
+                << foxglove::strerror(result.error());
+      return nullptr;
+    }
+    return std::make_shared<foxglove::RawChannel>(std::move(result.value()));
+  };
+  _channel = create(_options.topic);
+  _static_channel = create(_options.static_topic);
+  if (!_channel || !_static_channel) {
+    return false;
+  }
+  _running = true;
+  _thread = std::thread(&TfAggregator::run, this);
+  LOG_INFO << "Aggregating transforms on: " << _options.topic << " and "
+           << _options.static_topic << " hz: " << _options.hz;
+  return true;
+}
+
+void TfAggregator::stop() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (!_running) {
+      return;
+    }
+    _running = false;
+  }
+  _cv.notify_all();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  _channel->close();
+  _static_channel->close();
+}
+
+bool TfAggregator::owns(uint64_t channel_id) const {
+  return (_channel && _channel->id() == channel_id) ||
+         (_static_channel && _static_channel->id() == channel_id);
+}
+
+void TfAggregator::update(const std::string& topic, bool is_static,
+  const ConverterInfo& converter, const std::string& message,
+  const google::protobuf::Message* parsed) {
+  thread_local std::vector<foxglove::schemas::FrameTransform> transforms;
+  bool ok = converter.transforms(message, parsed, transforms);
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!ok) {
+    ++_errors;
+    return;
+  }
+  auto& frames = is_static ? _static_frames : _frames;
+  bool changed = false;
+  for (auto& transform : transforms) {
+    if (transform.child_frame_id.empty()) {
+      continue;
+    }
+    auto [it, inserted] = frames.try_emplace(transform.child_frame_id);
+    if (!inserted && sameTransform(it->second.transform, transform)) {
+      continue;
+    }
+    it->second.topic = topic;
+    it->second.transform = std::move(transform);
+    it->second.dirty = true;
+    changed = true;
+    ++_updates;
+  }
+  // 静态变换很少变化，每次发送全部静态变换，最后一条消息即为完整的静态变换树
+  if (is_static && changed && _running) {
+    thread_local foxglove::schemas::FrameTransforms output;
+    collectLocked(_static_frames, false, output);
+    log(*_static_channel, output);
+  }
+}
+
+void TfAggregator::erase(const std::string& topic) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  for (auto* frames : {&_frames, &_static_frames}) {
+    for (auto it = frames->begin(); it != frames->end();) {
+      it = it->second.topic == topic ? frames->erase(it) : std::next(it);
+    }
+  }
+}
+
+void TfAggregator::onSubscribe(uint64_t channel_id, uint64_t sink_id) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  if (!_running) {
+    return;
+  }
+  bool is_static = _static_channel->id() == channel_id;
+  foxglove::schemas::FrameTransforms output;
+  collectLocked(is_static ? _static_frames : _frames, false, output);
+  if (!output.transforms.empty()) {
+    log(is_static ? *_static_channel : *_channel, output, sink_id);
+  }
+}
+
+void TfAggregator::collect(BridgeMetrics::Values& values) {
+  std::lock_guard<std::mutex> lock(_mutex);
+  values["fox_bridge_tf_frames"] = _frames.size();
+  values["fox_bridge_tf_static_frames"] = _static_frames.size();
+  values["fox_bridge_tf_updates"] = _updates;
+  values["fox_bridge_tf_sent"] = _sent;
+  values["fox_bridge_tf_errors"] = _errors;
+}
+
+void TfAggregator::collectLocked(
+  Frames& frames, bool dirty_only, foxglove::schemas::FrameTransforms& output) {
+  output.transforms.clear();
+  for (auto& [child, entry] : frames) {
+    if (dirty_only && !entry.dirty) {
+      continue;
+    }
+    output.transforms.push_back(entry.transform);
+    entry.dirty = false;
+  }
+}
+
+bool TfAggregator::log(foxglove::RawChannel& channel,
+  foxglove::schemas::FrameTransforms& transforms, std::optional<uint64_t> sink_id) {
+  thread_local std::string buffer;
+  size_t encoded_len = 0;
+  buffer.resize(buffer.capacity());
+  auto result = transforms.encode(
+    reinterpret_cast<uint8_t*>(buffer.data()), buffer.size(), &encoded_len);
+  if (result == foxglove::FoxgloveError::BufferTooShort) {
+    buffer.resize(encoded_len);
+    result = transforms.encode(
+      reinterpret_cast<uint8_t*>(buffer.data()), buffer.size(), &encoded_len);
+  }
+  if (result == foxglove::FoxgloveError::Ok) {
+    result = channel.log(
+      reinterpret_cast<const std::byte*>(buffer.data()), encoded_len, std::nullopt, sink_id);
+  }
+  if (result != foxglove::FoxgloveError::Ok) {
+    LOG_ERROR << "Failed to log transforms: " << foxglove::strerror(result);
+    ++_errors;
+    return false;
+  }
+  ++_sent;
+  return true;
+}
+
+void TfAggregator::run() {
+  auto period = std::chrono::duration<double>(1.0 / std::max(_options.hz, 0.1));
+  foxglove::schemas::FrameTransforms output;
+  std::unique_lock<std::mutex> lock(_mutex);
+  while (_running) {
+    _cv.wait_for(lock, period);
+    if (!_running) {
+      break;
+    }
+    // 没有订阅者时也清除标记，新订阅者由 onSubscribe 补发全部变换
+    collectLocked(_frames, true, output);
+    if (!output.transforms.empty() && _channel->has_sinks()) {
+      log(*_channel, output);
+    }
+  }
+}
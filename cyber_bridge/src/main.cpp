@@ -1,4 +1,6 @@
+#include "BridgeConfig.hpp"
 #include "FoxgloveServer.hpp"
+#include "McapFileServer.hpp"
 #include "MessageConverter.hpp"
 #ifdef USE_CYBER_BRIDGE
 #include <cyber/cyber.h>
@@ -39,6 +41,12 @@ public:
   int getPort() const {
     return port;
   }
+  const std::string& getConfigPath() const {
+    return configPath;
+  }
+  const std::string& getMcapPath() const {
+    return mcapPath;
+  }
 
   bool requestedHelp() const {
     return helpRequested;
@@ -58,6 +66,8 @@ public:
     std::cout << "Options:\n";
     std::cout << "  -i, --ipAddress <ip>   Foxglove server address (default 127.0.0.1)\n";
     std::cout << "  -p, --port <port>      Foxglove server port (default 8765)\n";
+    std::cout << "  -c, --config <file>    Bridge config file (json)\n";
+    std::cout << "  -f, --mcap <file>      Serve an MCAP file instead of cyber topics\n";
     std::cout << "  -h, --help             Show this help message\n";
   }
 
@@ -65,6 +75,8 @@ private:
   std::string programName;
   std::string ipAddress;
   int port;
+  std::string configPath;
+  std::string mcapPath;
   bool helpRequested{false};
   bool ipProvided{false};
   bool portProvided{false};
@@ -126,6 +138,32 @@ private:
         continue;
       }
 
+      if (arg == "-c" || isLongOpt(arg, "config")) {
+        std::string value;
+        if (arg.rfind("--config=", 0) == 0) {
+          value = arg.substr(std::string("--config=").size());
+        } else if (!consumeValue(argc, argv, i, value)) {
+          parseError = true;
+          errorMessage = "Missing value for " + arg;
+          continue;
+        }
+        configPath = value;
+        continue;
+      }
+
+      if (arg == "-f" || isLongOpt(arg, "mcap")) {
+        std::string value;
+        if (arg.rfind("--mcap=", 0) == 0) {
+          value = arg.substr(std::string("--mcap=").size());
+        } else if (!consumeValue(argc, argv, i, value)) {
+          parseError = true;
+          errorMessage = "Missing value for " + arg;
+          continue;
+        }
+        mcapPath = value;
+        continue;
+      }
+
       // 未知参数
       parseError = true;
       errorMessage = "Unknown option: " + arg;
@@ -133,6 +171,29 @@ private:
   }
 };
 
+// 文件回放模式：不初始化 cyber，阻塞到 SIGINT / SIGTERM
+int serveMcap(const ArgParser& parser) {
+  // 在创建线程之前屏蔽信号，由 sigwait 统一接收
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+  McapFileServer server(parser.getMcapPath(),
+    McapServeOptions::fromJson(
+      BridgeConfig::instance().global().value("mcap_server", nlohmann::json::object())));
+  if (!server.start(parser.getIpAddress(), parser.getPort())) {
+    LOG_ERROR << "Failed to serve MCAP file";
+    return -1;
+  }
+  int signo = 0;
+  sigwait(&signals, &signo);
+  LOG_INFO << "Received signal " << signo << ", stopping";
+  server.stop();
+  return 0;
+}
+
 int main(int argc, const char* argv[]) {
 //   INIT_LOG_INSTANCE;
     // 可选：只显示 WARN 及以上级别
@@ -152,6 +213,12 @@ int main(int argc, const char* argv[]) {
     parser.printHelp();
     // 继续使用默认值运行
   }
+  if (!parser.getConfigPath().empty() && !BridgeConfig::instance().load(parser.getConfigPath())) {
+    return 1;
+  }
+  if (!parser.getMcapPath().empty()) {
+    return serveMcap(parser);
+  }
   LOG_INFO << "Starting Foxglove Server";
 #ifdef USE_CYBER_BRIDGE
   cyber::Init("fox_bridge");